@@ -0,0 +1,96 @@
+#ifndef MSC_ADAPTIVE_LAYER_CONTROLLER_HPP
+#define MSC_ADAPTIVE_LAYER_CONTROLLER_HPP
+
+#include "Producer.hpp"
+
+#include <json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace mediasoupclient
+{
+	// Fast forward declarations.
+	class SendTransport;
+
+	/*
+	 * Inspects the sender stats of every video Producer of a SendTransport and
+	 * lowers its max spatial layer when the encoder is CPU limited, raising it
+	 * again (up to the max spatial layer set by the application) once the encoder
+	 * has been idle long enough.
+	 *
+	 * Producers are not thread-safe, so the controller has no thread of its own.
+	 * The application calls Tick() periodically (e.g. every second) from the
+	 * thread it uses the SendTransport from, and listener callbacks are called
+	 * from there. It must not outlive the SendTransport.
+	 */
+	class AdaptiveLayerController
+	{
+	public:
+		/* Public Listener API */
+		class Listener
+		{
+		public:
+			virtual ~Listener() = default;
+			virtual void OnMaxSpatialLayerChange(Producer* producer, uint8_t spatialLayer) = 0;
+		};
+
+		struct Options
+		{
+			// Encoding time per wall clock time above which the encoder is considered
+			// overused.
+			double overuseEncodeUsage{ 0.85 };
+			// Encoding time per wall clock time below which the encoder is considered
+			// underused.
+			double underuseEncodeUsage{ 0.45 };
+			// Consecutive overused inspections needed to drop a layer.
+			uint32_t overuseCount{ 2u };
+			// Consecutive underused inspections needed to raise a layer.
+			uint32_t underuseCount{ 10u };
+		};
+
+	public:
+		AdaptiveLayerController(
+		  SendTransport* sendTransport, Listener* listener = nullptr, const Options& options = Options());
+
+	public:
+		// Inspects all the Producers once.
+		void Tick();
+		// Inspects the given sender stats of a Producer of the SendTransport.
+		void Inspect(
+		  Producer* producer,
+		  const nlohmann::json& stats,
+		  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+	private:
+		struct ProducerState
+		{
+			// Whether the previous values have been sampled.
+			bool sampled{ false };
+			std::chrono::steady_clock::time_point sampledAt;
+			// Sum of totalEncodeTime (seconds) of all the encodings.
+			double totalEncodeTime{ 0 };
+			// bytesSent of each encoding, indexed by rid.
+			std::unordered_map<std::string, uint64_t> bytesSent;
+			uint32_t overuseCount{ 0u };
+			uint32_t underuseCount{ 0u };
+			// Highest max spatial layer to raise to, the one set by the application.
+			uint8_t maxSpatialLayer{ 0u };
+			// Max spatial layer last set by the controller, 0 if none.
+			uint8_t appliedSpatialLayer{ 0u };
+		};
+
+	private:
+		// SendTransport instance.
+		SendTransport* sendTransport{ nullptr };
+		// Listener instance.
+		Listener* listener{ nullptr };
+		Options options;
+		// State of each Producer, indexed by Producer id.
+		std::unordered_map<std::string, ProducerState> producerStates;
+	};
+} // namespace mediasoupclient
+
+#endif
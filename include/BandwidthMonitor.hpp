@@ -0,0 +1,88 @@
+#ifndef MSC_BANDWIDTH_MONITOR_HPP
+#define MSC_BANDWIDTH_MONITOR_HPP
+
+#include <json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace mediasoupclient
+{
+	// Fast forward declarations.
+	class SendTransport;
+
+	/*
+	 * Inspects the stats of a SendTransport and publishes the outgoing bandwidth
+	 * estimation of libwebrtc (transport-cc or REMB based), notifying when it
+	 * drops so the application can lower its simulcast layers or pause video
+	 * before the encoder starves.
+	 *
+	 * Call Tick() (e.g. once a second) from the thread using the SendTransport,
+	 * which it must not outlive.
+	 */
+	class BandwidthMonitor
+	{
+	public:
+		struct Estimation
+		{
+			// Available outgoing bitrate (bps) of the selected ICE candidate pair, 0
+			// if not known yet.
+			uint64_t availableOutgoingBitrate{ 0u };
+			// Average time the packets sent since the previous inspection were held
+			// by the pacer.
+			std::chrono::milliseconds pacerQueueDelay{ 0 };
+		};
+
+		/* Public Listener API */
+		class Listener
+		{
+		public:
+			virtual ~Listener() = default;
+			virtual void OnBandwidthEstimation(const Estimation& estimation) = 0;
+			// The available outgoing bitrate dropped by Options::congestionDropRatio
+			// or more from the given previous one.
+			virtual void OnCongestion(const Estimation& estimation, uint64_t previousBitrate) = 0;
+		};
+
+		struct Options
+		{
+			// Drop of the available outgoing bitrate between two inspections, from 0
+			// to 1, taken as congestion.
+			double congestionDropRatio{ 0.3 };
+		};
+
+	public:
+		BandwidthMonitor(
+		  SendTransport* sendTransport, Listener* listener = nullptr, const Options& options = Options());
+
+	public:
+		// Inspects the transport stats once.
+		void Tick();
+		// Inspects the given transport stats, for applications already polling
+		// them.
+		void Inspect(const nlohmann::json& stats);
+		Estimation GetEstimation() const;
+
+	private:
+		struct OutboundRtpState
+		{
+			double totalPacketSendDelay{ 0 };
+			uint64_t packetsSent{ 0u };
+		};
+
+	private:
+		// SendTransport instance.
+		SendTransport* sendTransport{ nullptr };
+		// Listener instance.
+		Listener* listener{ nullptr };
+		Options options;
+		// Latest estimation.
+		Estimation estimation;
+		// Outbound RTP streams at the previous inspection, indexed by stats id.
+		std::unordered_map<std::string, OutboundRtpState> outboundRtpStates;
+	};
+} // namespace mediasoupclient
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef MSC_CONNECTION_QUALITY_MONITOR_HPP
+#define MSC_CONNECTION_QUALITY_MONITOR_HPP
+
+#include <json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace mediasoupclient
+{
+	// Fast forward declarations.
+	class Transport;
+
+	/*
+	 * Samples the selected candidate-pair, remote-inbound-rtp and inbound-rtp
+	 * stats of a Transport, smooths its RTT, packet loss and jitter and notifies when its
+	 * quality bucket changes.
+	 *
+	 * Transports are not thread-safe, so the monitor has no background thread.
+	 * The application calls Tick() at the interval of its choice from the thread
+	 * it uses the Transport from, and listener callbacks are called from there.
+	 * It must not outlive the Transport.
+	 */
+	class ConnectionQualityMonitor
+	{
+	public:
+		enum class Quality : uint8_t
+		{
+			UNKNOWN = 0,
+			GOOD,
+			FAIR,
+			POOR
+		};
+
+		struct Metrics
+		{
+			std::chrono::milliseconds roundTripTime{ 0 };
+			// Fraction of the packets lost, from 0 to 1.
+			double packetLoss{ 0 };
+			std::chrono::milliseconds jitter{ 0 };
+		};
+
+		/* Public Listener API */
+		class Listener
+		{
+		public:
+			virtual ~Listener() = default;
+			virtual void OnQualityChange(Quality quality, const Metrics& metrics) = 0;
+		};
+
+		struct Options
+		{
+			// Weight of every new sample in the smoothed metrics, from 0 to 1.
+			double smoothingFactor{ 0.3 };
+			// The quality is good if every metric is within these values.
+			std::chrono::milliseconds goodRoundTripTime{ 150 };
+			double goodPacketLoss{ 0.02 };
+			std::chrono::milliseconds goodJitter{ 30 };
+			// The quality is poor if any metric exceeds these values.
+			std::chrono::milliseconds poorRoundTripTime{ 400 };
+			double poorPacketLoss{ 0.1 };
+			std::chrono::milliseconds poorJitter{ 100 };
+		};
+
+	public:
+		static std::map<ConnectionQualityMonitor::Quality, const std::string> quality2String;
+
+	public:
+		ConnectionQualityMonitor(
+		  Transport* transport, Listener* listener = nullptr, const Options& options = Options());
+
+	public:
+		// Samples the transport stats once.
+		void Tick();
+		// Samples the given transport stats, for applications already polling
+		// them.
+		void Inspect(const nlohmann::json& stats);
+		Quality GetQuality() const;
+		Metrics GetMetrics() const;
+
+	private:
+		struct InboundRtpState
+		{
+			uint64_t packetsReceived{ 0u };
+			int64_t packetsLost{ 0 };
+		};
+
+	private:
+		Quality ComputeQuality(const Metrics& metrics) const;
+
+	private:
+		// Transport instance.
+		Transport* transport{ nullptr };
+		// Listener instance.
+		Listener* listener{ nullptr };
+		Options options;
+		// Smoothed metrics (seconds and fraction).
+		double roundTripTime{ 0 };
+		double packetLoss{ 0 };
+		double jitter{ 0 };
+		// Whether each metric has been sampled at least once.
+		bool roundTripTimeSampled{ false };
+		bool packetLossSampled{ false };
+		bool jitterSampled{ false };
+		// Inbound RTP streams at the previous sample, indexed by stats id.
+		std::unordered_map<std::string, InboundRtpState> inboundRtpStates;
+		Quality quality{ Quality::UNKNOWN };
+	};
+} // namespace mediasoupclient
+
+#endif
@@ -2,6 +2,7 @@
 #define MSC_CONSUMER_HPP
 
 #include <json.hpp>
+#include <absl/types/optional.h>
 #include <api/media_stream_interface.h> // webrtc::MediaStreamTrackInterface
 #include <api/rtp_receiver_interface.h> // webrtc::RtpReceiverInterface
 #include <string>
@@ -14,6 +15,10 @@ namespace mediasoupclient
 
 	class Consumer
 	{
+	public:
+		// Maximum latency hint, in seconds (as libwebrtc clamps it).
+		static constexpr double MaxLatencyHint{ 10.0 };
+
 	public:
 		class PrivateListener
 		{
@@ -56,6 +61,11 @@ namespace mediasoupclient
 		nlohmann::json GetStats() const;
 		void Pause();
 		void Resume();
+		// Sets the receive latency, in seconds, the jitter buffer targets. The
+		// lower, the lower the playout delay (0 for the minimum). If not set,
+		// libwebrtc adapts it to the network. May throw.
+		void SetLatencyHint(absl::optional<double> latencyHint);
+		absl::optional<double> GetLatencyHint() const;
 
 	private:
 		void TransportClosed();
@@ -84,6 +94,8 @@ namespace mediasoupclient
 		nlohmann::json rtpParameters;
 		// Paused flag.
 		bool paused{ false };
+		// Latency hint in seconds.
+		absl::optional<double> latencyHint;
 		// App custom data.
 		nlohmann::json appData{};
 	};
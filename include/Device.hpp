@@ -5,6 +5,7 @@
 #include "Transport.hpp"
 #include <json.hpp>
 #include <map>
+#include <memory>
 #include <string>
 
 namespace mediasoupclient
@@ -18,9 +19,26 @@ namespace mediasoupclient
 		bool IsLoaded() const;
 		const nlohmann::json& GetRtpCapabilities() const;
 		const nlohmann::json& GetSctpCapabilities() const;
+		// The optional profile restricts the codecs and RTP header extensions to
+		// use, see ortc::validateRtpCapabilitiesProfile().
 		void Load(
 		  nlohmann::json routerRtpCapabilities,
-		  const PeerConnection::Options* peerConnectionOptions = nullptr);
+		  const PeerConnection::Options* peerConnectionOptions = nullptr,
+		  const nlohmann::json& rtpCapabilitiesProfile         = nlohmann::json::object());
+		// Shares the capabilities of the given loaded Device, which must have been
+		// loaded with the same router RTP capabilities.
+		void Load(const Device& loadedDevice);
+		// Stores the computed capabilities in the given file so a later Device can
+		// be loaded from it. May throw.
+		void Save(const std::string& path) const;
+		// Loads the Device from a file written by Save() for the same router RTP
+		// capabilities, profile, library version and native codecs. Returns false
+		// if there is no such file, so Load() must be called instead.
+		bool Restore(
+		  const std::string& path,
+		  nlohmann::json routerRtpCapabilities,
+		  const PeerConnection::Options* peerConnectionOptions = nullptr,
+		  const nlohmann::json& rtpCapabilitiesProfile         = nlohmann::json::object());
 		bool CanProduce(const std::string& kind);
 		SendTransport* CreateSendTransport(
 		  SendTransport::Listener* listener,
@@ -56,24 +74,51 @@ namespace mediasoupclient
 		  const nlohmann::json& dtlsParameters,
 		  const PeerConnection::Options* peerConnectionOptions = nullptr,
 		  const nlohmann::json& appData                        = nlohmann::json::object()) const;
+		// Receives over the PeerConnection of the given SendTransport, which must
+		// be a server side transport able to both produce and consume.
+		RecvTransport* CreateRecvTransport(
+		  RecvTransport::Listener* listener,
+		  SendTransport* sendTransport,
+		  const nlohmann::json& appData = nlohmann::json::object()) const;
 
 	private:
-		// Loaded flag.
-		bool loaded{ false };
-		// Extended RTP capabilities.
-		nlohmann::json extendedRtpCapabilities;
-		// Local RTP capabilities for receiving media.
-		nlohmann::json recvRtpCapabilities;
-		// Whether we can produce audio/video based on computed extended RTP capabilities.
-		// clang-format off
-		std::map<std::string, bool> canProduceByKind =
+		// Capabilities computed on load. Immutable, so shared by every Device
+		// loaded with the same ones.
+		struct Capabilities
 		{
-			{ "audio", false },
-			{ "video", false }
+			// Extended RTP capabilities.
+			nlohmann::json extendedRtpCapabilities;
+			// Local RTP capabilities for receiving media.
+			nlohmann::json recvRtpCapabilities;
+			// Local SCTP capabilities.
+			nlohmann::json sctpCapabilities;
+			// Whether we can produce audio/video based on computed extended RTP
+			// capabilities.
+			// clang-format off
+			std::map<std::string, bool> canProduceByKind =
+			{
+				{ "audio", false },
+				{ "video", false }
+			};
+			// clang-format on
+			// Generic sending RTP parameters for audio and video.
+			nlohmann::json sendingRtpParametersByKind;
+			// Generic sending RTP parameters for audio and video suitable for the SDP
+			// remote answer.
+			nlohmann::json sendingRemoteRtpParametersByKind;
 		};
-		// clang-format on
-		// Local SCTP capabilities.
-		nlohmann::json sctpCapabilities;
+
+	private:
+		void SetCapabilities(Capabilities capabilities);
+
+	private:
+		// Loaded flag.
+		bool loaded{ false };
+		// Capabilities.
+		std::shared_ptr<const Capabilities> capabilities;
+		// Router RTP capabilities, profile and native codecs the Device was loaded
+		// with, which identify its capabilities in the file written by Save().
+		std::shared_ptr<const nlohmann::json> loadParameters;
 	};
 } // namespace mediasoupclient
 
@@ -2,6 +2,7 @@
 #define MSC_HANDLER_HPP
 
 #include "PeerConnection.hpp"
+#include "sdp/LocalSdp.hpp"
 #include "sdp/RemoteSdp.hpp"
 #include <json.hpp>
 #include <api/media_stream_interface.h>    // webrtc::MediaStreamTrackInterface
@@ -10,8 +11,12 @@
 #include <api/rtp_receiver_interface.h>    // webrtc::RtpReceiverInterface
 #include <api/rtp_sender_interface.h>      // webrtc::RtpSenderInterface
 #include <api/rtp_transceiver_interface.h> // webrtc::RtpTransceiverInterface
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace mediasoupclient
 {
@@ -35,9 +40,18 @@ namespace mediasoupclient
 		};
 
 	public:
+		// Just the given media kinds are added to the offer the capabilities are
+		// taken from. If given, nativeCodecs is filled with the codecs of the
+		// PeerConnection used.
 		static nlohmann::json GetNativeRtpCapabilities(
-		  const PeerConnection::Options* peerConnectionOptions = nullptr);
+		  const PeerConnection::Options* peerConnectionOptions = nullptr,
+		  const std::vector<std::string>& kinds                = { "audio", "video" },
+		  nlohmann::json* nativeCodecs                         = nullptr);
 		static nlohmann::json GetNativeSctpCapabilities();
+		// Codecs of the PeerConnection factory, which the native RTP capabilities
+		// depend on. No PeerConnection is created.
+		static nlohmann::json GetNativeCodecs(
+		  const PeerConnection::Options* peerConnectionOptions = nullptr);
 
 	public:
 		explicit Handler(
@@ -47,36 +61,99 @@ namespace mediasoupclient
 		  const nlohmann::json& dtlsParameters,
 		  const nlohmann::json& sctpParameters,
 		  const PeerConnection::Options* peerConnectionOptions);
+		~Handler() override;
+
+	protected:
+		// Uses the PeerConnection and the remote SDP of the given Handler.
+		Handler(PrivateListener* privateListener, Handler* handler);
 
 	public:
 		void Close();
+		virtual void Connect() = 0;
 		nlohmann::json GetTransportStats();
 		void UpdateIceServers(const nlohmann::json& iceServerUris);
 		virtual void RestartIce(const nlohmann::json& iceParameters) = 0;
 
 	protected:
-		void SetupTransport(const std::string& localDtlsRole, nlohmann::json& localSdpObject);
+		void SetupTransport(const std::string& localDtlsRole, const Sdp::LocalSdp& localSdp);
+		// Negotiates the queued operations, including those queued meanwhile, unless
+		// another thread is already doing it.
+		void ProcessPendingOperations();
+		// Called with pendingMutex locked.
+		virtual bool HasPendingOperations() const = 0;
+		// Applies all the queued operations within a single SDP negotiation.
+		virtual void NegotiatePendingOperations() = 0;
+		// Rejects all the queued operations. Called with pendingMutex locked.
+		virtual void RejectPendingOperations(const std::exception_ptr& error) = 0;
+		// Stops the given transceivers within a single SDP negotiation.
+		virtual void StopTransceivers(const std::vector<std::string>& localIds) = 0;
 
 		/* Methods inherited from PeerConnectionListener. */
 	public:
 		void OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState newState) override;
 
+	protected:
+		// State of a PeerConnection, shared by the Handlers using it. It listens to
+		// the PeerConnection on their behalf.
+		class Session : public PeerConnection::PrivateListener
+		{
+		public:
+			void AddHandler(Handler* handler);
+			// Returns the number of remaining Handlers.
+			size_t RemoveHandler(Handler* handler);
+			// Whether an open DataChannel uses the given SCTP stream id. Called with
+			// negotiationMutex locked.
+			bool IsSctpStreamIdInUse(uint16_t streamId) const;
+			// Takes the receiving transceiver signaled for the given MID by the last
+			// remote description, null if none.
+			rtc::scoped_refptr<webrtc::RtpTransceiverInterface> TakeReceivingTransceiver(
+			  const std::string& mid);
+
+			/* Methods inherited from PeerConnection::PrivateListener. */
+		public:
+			void OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState newState) override;
+			void OnTrack(rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver) override;
+
+		public:
+			// Got transport local and remote parameters.
+			bool transportReady{ false };
+			bool hasDataChannelMediaSection{ false };
+			// Serializes the SDP negotiations.
+			std::recursive_mutex negotiationMutex;
+			// DataChannels of all the Handlers indexed by SCTP stream id. Guarded by
+			// negotiationMutex.
+			std::unordered_map<uint16_t, rtc::scoped_refptr<webrtc::DataChannelInterface>> dataChannels;
+
+		private:
+			std::mutex handlersMutex;
+			std::vector<Handler*> handlers;
+			// Receiving transceivers signaled by OnTrack() from the signaling thread
+			// and not taken yet, indexed by MID.
+			std::mutex receivingTransceiversMutex;
+			std::unordered_map<std::string, rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>
+			  receivingTransceivers;
+		};
+
 	protected:
 		// PrivateListener instance.
 		PrivateListener* privateListener{ nullptr };
+		// Session instance. Must outlive the PeerConnection.
+		std::shared_ptr<Session> session{ nullptr };
 		// Remote SDP instance.
-		std::unique_ptr<Sdp::RemoteSdp> remoteSdp{ nullptr };
-		// Got transport local and remote parameters.
-		bool transportReady{ false };
+		std::shared_ptr<Sdp::RemoteSdp> remoteSdp{ nullptr };
 		// Map of RTCTransceivers indexed by MID.
 		std::unordered_map<std::string, webrtc::RtpTransceiverInterface*> mapMidTransceiver{};
 		// PeerConnection instance.
-		std::unique_ptr<PeerConnection> pc{ nullptr };
-		bool hasDataChannelMediaSection = false;
-		uint32_t nextSendSctpStreamId   = 0;
+		std::shared_ptr<PeerConnection> pc{ nullptr };
+		bool hasSctpParameters{ false };
+		uint32_t nextSendSctpStreamId = 0;
 		// Initial server side DTLS role. If not 'auto', it will force the opposite
 		// value in client side.
 		std::string forcedLocalDtlsRole;
+		// Guards the queued operations and the negotiating flag.
+		std::mutex pendingMutex;
+		// Whether a thread is negotiating the queued operations.
+		bool negotiating{ false };
 	};
 
 	class SendHandler : public Handler
@@ -99,6 +176,16 @@ namespace mediasoupclient
 		  const PeerConnection::Options* peerConnectionOptions,
 		  const nlohmann::json& sendingRtpParametersByKind,
 		  const nlohmann::json& sendingRemoteRtpParametersByKind = nlohmann::json());
+		// Shares the given sending RTP parameters instead of copying them.
+		SendHandler(
+		  Handler::PrivateListener* privateListener,
+		  const nlohmann::json& iceParameters,
+		  const nlohmann::json& iceCandidates,
+		  const nlohmann::json& dtlsParameters,
+		  const nlohmann::json& sctpParameters,
+		  const PeerConnection::Options* peerConnectionOptions,
+		  std::shared_ptr<const nlohmann::json> sendingRtpParametersByKind,
+		  std::shared_ptr<const nlohmann::json> sendingRemoteRtpParametersByKind);
 
 	public:
 		SendResult Send(
@@ -106,19 +193,62 @@ namespace mediasoupclient
 		  std::vector<webrtc::RtpEncodingParameters>* encodings,
 		  const nlohmann::json* codecOptions,
 		  const nlohmann::json* codec);
+		std::future<SendResult> SendAsync(
+		  webrtc::MediaStreamTrackInterface* track,
+		  const std::vector<webrtc::RtpEncodingParameters>* encodings,
+		  const nlohmann::json* codecOptions,
+		  const nlohmann::json* codec);
 		void StopSending(const std::string& localId);
+		void StopSending(const std::vector<std::string>& localIds);
+		std::future<void> StopSendingAsync(const std::string& localId);
 		void ReplaceTrack(const std::string& localId, webrtc::MediaStreamTrackInterface* track);
 		void SetMaxSpatialLayer(const std::string& localId, uint8_t spatialLayer);
+		void SetRtpEncodingParameters(const std::string& localId, const nlohmann::json& encodings);
+		void PauseSending(const std::string& localId);
+		void ResumeSending(const std::string& localId);
 		nlohmann::json GetSenderStats(const std::string& localId);
 		void RestartIce(const nlohmann::json& iceParameters) override;
 		DataChannel SendDataChannel(const std::string& label, webrtc::DataChannelInit dataChannelInit);
 
+	private:
+		struct PendingSend
+		{
+			rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track;
+			std::vector<webrtc::RtpEncodingParameters> encodings;
+			// Null if not given.
+			nlohmann::json codecOptions;
+			nlohmann::json codec;
+			std::promise<SendResult> promise;
+		};
+
+		struct PendingStop
+		{
+			std::string localId;
+			std::promise<void> promise;
+		};
+
+	private:
+		void SendSctpAssociation();
+
+		/* Virtual methods inherited from Handler. */
+	private:
+		bool HasPendingOperations() const override;
+		void NegotiatePendingOperations() override;
+		void RejectPendingOperations(const std::exception_ptr& error) override;
+		void StopTransceivers(const std::vector<std::string>& localIds) override;
+
 	private:
 		// Generic sending RTP parameters for audio and video.
-		nlohmann::json sendingRtpParametersByKind;
+		std::shared_ptr<const nlohmann::json> sendingRtpParametersByKind;
 		// Generic sending RTP parameters for audio and video suitable for the SDP
 		// remote answer.
-		nlohmann::json sendingRemoteRtpParametersByKind;
+		std::shared_ptr<const nlohmann::json> sendingRemoteRtpParametersByKind;
+		// Encodings active flags of paused senders (to be restored on resume),
+		// indexed by MID.
+		std::unordered_map<std::string, std::vector<bool>> mapMidPausedEncodingsActive;
+		// Operations waiting for the next negotiation.
+		std::vector<PendingSend> pendingSends;
+		std::vector<PendingStop> pendingStops;
 	};
 
 	class RecvHandler : public Handler
@@ -131,6 +261,13 @@ namespace mediasoupclient
 			webrtc::MediaStreamTrackInterface* track{ nullptr };
 		};
 
+		struct ReceiveOptions
+		{
+			std::string id;
+			std::string kind;
+			nlohmann::json rtpParameters;
+		};
+
 	public:
 		RecvHandler(
 		  Handler::PrivateListener* privateListener,
@@ -139,13 +276,51 @@ namespace mediasoupclient
 		  const nlohmann::json& dtlsParameters,
 		  const nlohmann::json& sctpParameters,
 		  const PeerConnection::Options* peerConnectionOptions);
+		// Receives over the PeerConnection of the given SendHandler.
+		RecvHandler(Handler::PrivateListener* privateListener, SendHandler* sendHandler);
 
 		RecvResult Receive(
 		  const std::string& id, const std::string& kind, const nlohmann::json* rtpParameters);
+		std::future<RecvResult> ReceiveAsync(
+		  const std::string& id, const std::string& kind, const nlohmann::json& rtpParameters);
+		std::vector<std::future<RecvResult>> ReceiveAsync(const std::vector<ReceiveOptions>& optionsList);
+		void Connect() override;
 		void StopReceiving(const std::string& localId);
+		void StopReceiving(const std::vector<std::string>& localIds);
+		std::future<void> StopReceivingAsync(const std::string& localId);
 		nlohmann::json GetReceiverStats(const std::string& localId);
 		void RestartIce(const nlohmann::json& iceParameters) override;
 		DataChannel ReceiveDataChannel(const std::string& label, webrtc::DataChannelInit dataChannelInit);
+
+	private:
+		struct PendingReceive
+		{
+			std::string id;
+			std::string kind;
+			nlohmann::json rtpParameters;
+			std::promise<RecvResult> promise;
+		};
+
+		struct PendingStop
+		{
+			std::string localId;
+			std::promise<void> promise;
+		};
+
+	private:
+		void ReceiveSctpAssociation();
+
+		/* Virtual methods inherited from Handler. */
+	private:
+		bool HasPendingOperations() const override;
+		void NegotiatePendingOperations() override;
+		void RejectPendingOperations(const std::exception_ptr& error) override;
+		void StopTransceivers(const std::vector<std::string>& localIds) override;
+
+	private:
+		// Operations waiting for the next negotiation.
+		std::vector<PendingReceive> pendingReceives;
+		std::vector<PendingStop> pendingStops;
 	};
 } // namespace mediasoupclient
 
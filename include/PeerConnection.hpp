@@ -3,11 +3,15 @@
 
 #include <json.hpp>
 #include <api/peer_connection_interface.h> // webrtc::PeerConnectionInterface
+#include <atomic>                          // std::atomic
 #include <future>                          // std::promise, std::future
 #include <memory>                          // std::unique_ptr
 
 namespace mediasoupclient
 {
+	// Fast forward declarations.
+	class TransportPool;
+
 	class PeerConnection
 	{
 	public:
@@ -101,37 +105,115 @@ namespace mediasoupclient
 		};
 
 	public:
+		struct Options;
+
+		/*
+		 * Creates the PeerConnection instances, so that a different implementation
+		 * (i.e. an in-memory fake for testing) can be used instead of libwebrtc.
+		 */
+		class Backend
+		{
+		public:
+			virtual ~Backend() = default;
+			virtual PeerConnection* CreatePeerConnection(
+			  PrivateListener* privateListener, const Options* options) = 0;
+			// Codecs of the PeerConnections it creates, see GetNativeCodecs().
+			virtual nlohmann::json GetNativeCodecs(const Options* options) const = 0;
+		};
+
 		struct Options
 		{
 			webrtc::PeerConnectionInterface::RTCConfiguration config;
 			webrtc::PeerConnectionFactoryInterface* factory{ nullptr };
+			// If set, transports take a pre-created PeerConnection from it.
+			TransportPool* transportPool{ nullptr };
+			// If set, PeerConnections are created by it.
+			Backend* backend{ nullptr };
+			// Write the remote ICE parameters once at session level and the remote
+			// ICE candidates just in the BUNDLE tagged media section.
+			bool compactRemoteSdp{ false };
+			// Keep gathering ICE candidates on network changes and pre-gather a pooled
+			// set of candidates, so ICE restarts do not wait for a fresh gathering.
+			bool continualGathering{ false };
+		};
+
+	public:
+		// Creates a PeerConnection using the backend given in options, if any.
+		static PeerConnection* Create(PrivateListener* privateListener, const Options* options);
+		// Codecs of the PeerConnections created with the given options, without
+		// creating one.
+		static nlohmann::json GetNativeCodecs(const Options* options);
+
+	private:
+		// Forwards the webrtc::PeerConnection events to the current PrivateListener,
+		// which may be set after the PeerConnection has been created.
+		class PrivateListenerProxy : public webrtc::PeerConnectionObserver
+		{
+		public:
+			explicit PrivateListenerProxy(PrivateListener* privateListener = nullptr)
+			  : privateListener(privateListener)
+			{
+			}
+
+			/* Virtual methods inherited from PeerConnectionObserver. */
+		public:
+			void OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState newState) override;
+			void OnAddStream(rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) override;
+			void OnRemoveStream(rtc::scoped_refptr<webrtc::MediaStreamInterface> stream) override;
+			void OnDataChannel(rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel) override;
+			void OnRenegotiationNeeded() override;
+			void OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState newState) override;
+			void OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState newState) override;
+			void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) override;
+			void OnIceCandidatesRemoved(const std::vector<cricket::Candidate>& candidates) override;
+			void OnIceConnectionReceivingChange(bool receiving) override;
+			void OnAddTrack(
+			  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+			  const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>& streams) override;
+			void OnTrack(rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver) override;
+			void OnRemoveTrack(rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver) override;
+			void OnInterestingUsage(int usagePattern) override;
+
+		public:
+			// Events are called from the signaling thread.
+			std::atomic<PrivateListener*> privateListener;
 		};
 
 	public:
 		PeerConnection(PrivateListener* privateListener, const Options* options);
-		~PeerConnection() = default;
-
-		void Close();
-		webrtc::PeerConnectionInterface::RTCConfiguration GetConfiguration() const;
-		bool SetConfiguration(const webrtc::PeerConnectionInterface::RTCConfiguration& config);
-		std::string CreateOffer(const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& options);
-		std::string CreateAnswer(const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& options);
-		void SetLocalDescription(PeerConnection::SdpType type, const std::string& sdp);
-		void SetRemoteDescription(PeerConnection::SdpType type, const std::string& sdp);
-		const std::string GetLocalDescription();
-		const std::string GetRemoteDescription();
-		std::vector<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>> GetTransceivers() const;
-		rtc::scoped_refptr<webrtc::RtpTransceiverInterface> AddTransceiver(cricket::MediaType mediaType);
-		rtc::scoped_refptr<webrtc::RtpTransceiverInterface> AddTransceiver(
+		virtual ~PeerConnection() = default;
+
+	protected:
+		// For alternative implementations, which do not create a webrtc::PeerConnection.
+		PeerConnection() = default;
+
+	public:
+		virtual void SetPrivateListener(PrivateListener* privateListener);
+		virtual void Close();
+		virtual webrtc::PeerConnectionInterface::RTCConfiguration GetConfiguration() const;
+		virtual bool SetConfiguration(const webrtc::PeerConnectionInterface::RTCConfiguration& config);
+		virtual std::string CreateOffer(const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& options);
+		virtual std::string CreateAnswer(
+		  const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& options);
+		virtual void SetLocalDescription(PeerConnection::SdpType type, const std::string& sdp);
+		virtual void SetRemoteDescription(PeerConnection::SdpType type, const std::string& sdp);
+		virtual const std::string GetLocalDescription();
+		virtual const std::string GetRemoteDescription();
+		virtual std::vector<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>> GetTransceivers() const;
+		virtual rtc::scoped_refptr<webrtc::RtpTransceiverInterface> AddTransceiver(
+		  cricket::MediaType mediaType);
+		virtual rtc::scoped_refptr<webrtc::RtpTransceiverInterface> AddTransceiver(
 		  rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track,
 		  webrtc::RtpTransceiverInit rtpTransceiverInit);
-		std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> GetSenders();
-		bool RemoveTrack(webrtc::RtpSenderInterface* sender);
-		nlohmann::json GetStats();
-		nlohmann::json GetStats(rtc::scoped_refptr<webrtc::RtpSenderInterface> selector);
-		nlohmann::json GetStats(rtc::scoped_refptr<webrtc::RtpReceiverInterface> selector);
-		rtc::scoped_refptr<webrtc::DataChannelInterface> CreateDataChannel(
+		virtual std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> GetSenders();
+		virtual bool RemoveTrack(webrtc::RtpSenderInterface* sender);
+		virtual nlohmann::json GetStats();
+		virtual nlohmann::json GetStats(rtc::scoped_refptr<webrtc::RtpSenderInterface> selector);
+		virtual nlohmann::json GetStats(rtc::scoped_refptr<webrtc::RtpReceiverInterface> selector);
+		virtual rtc::scoped_refptr<webrtc::DataChannelInterface> CreateDataChannel(
 		  const std::string& label, const webrtc::DataChannelInit* config);
+		// Codecs the factory can send and receive, indexed by kind.
+		virtual nlohmann::json GetNativeCodecs() const;
 
 	private:
 		// Signaling and worker threads.
@@ -142,6 +224,9 @@ namespace mediasoupclient
 		// PeerConnection factory.
 		rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> peerConnectionFactory;
 
+		// PeerConnection events forwarder. It must outlive the PeerConnection.
+		PrivateListenerProxy privateListenerProxy;
+
 		// PeerConnection instance.
 		rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc;
 	};
@@ -22,7 +22,11 @@ namespace mediasoupclient
 			virtual void OnReplaceTrack(
 			  const Producer* producer, webrtc::MediaStreamTrackInterface* newTrack)             = 0;
 			virtual void OnSetMaxSpatialLayer(const Producer* producer, uint8_t maxSpatialLayer) = 0;
-			virtual nlohmann::json OnGetStats(const Producer* producer)                          = 0;
+			virtual void OnSetRtpEncodingParameters(
+			  const Producer* producer, const nlohmann::json& encodings)  = 0;
+			virtual void OnPause(const Producer* producer)              = 0;
+			virtual void OnResume(const Producer* producer)             = 0;
+			virtual nlohmann::json OnGetStats(const Producer* producer) = 0;
 		};
 
 		/* Public Listener API */
@@ -41,7 +45,8 @@ namespace mediasoupclient
 		  webrtc::RtpSenderInterface* rtpSender,
 		  webrtc::MediaStreamTrackInterface* track,
 		  const nlohmann::json& rtpParameters,
-		  const nlohmann::json& appData);
+		  const nlohmann::json& appData,
+		  bool zeroRtpOnPause = false);
 
 	public:
 		const std::string& GetId() const;
@@ -60,6 +65,7 @@ namespace mediasoupclient
 		void Resume();
 		void ReplaceTrack(webrtc::MediaStreamTrackInterface* track);
 		void SetMaxSpatialLayer(uint8_t spatialLayer);
+		void SetRtpEncodingParameters(const nlohmann::json& encodings);
 
 	private:
 		void TransportClosed();
@@ -88,6 +94,8 @@ namespace mediasoupclient
 		bool paused{ false };
 		// Video Max spatial layer.
 		uint8_t maxSpatialLayer{ 0 };
+		// Whether pausing deactivates the RtpSender encodings so no RTP is sent.
+		bool zeroRtpOnPause{ false };
 		// App custom data.
 		nlohmann::json appData;
 	};
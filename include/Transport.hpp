@@ -12,15 +12,20 @@
 #include <api/peer_connection_interface.h> // webrtc::PeerConnectionInterface
 #include <api/rtp_parameters.h>            // webrtc::RtpEncodingParameters
 
+#include <chrono>
 #include <future>
 #include <map>
 #include <memory> // unique_ptr
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace mediasoupclient
 {
 	// Fast forward declarations.
+	class AdaptiveLayerController;
 	class Device;
+	class RecvTransport;
 
 	class Transport : public Handler::PrivateListener
 	{
@@ -49,8 +54,13 @@ namespace mediasoupclient
 		const std::string& GetConnectionState() const;
 		nlohmann::json& GetAppData();
 		virtual void Close();
+		virtual void Connect() = 0;
 		nlohmann::json GetStats() const;
 		void RestartIce(const nlohmann::json& iceParameters);
+		// Time from the latest RestartIce() to the ICE connection becoming connected
+		// again, zero if not measured yet. A restart that fails, or whose ICE
+		// connection goes to other state than connected, is not measured.
+		std::chrono::milliseconds GetIceRestartLatency() const;
 		void UpdateIceServers(const nlohmann::json& iceServers);
 
 	protected:
@@ -85,6 +95,12 @@ namespace mediasoupclient
 		};
 		// Handler.
 		Handler* handler{ nullptr };
+		// Guards the ICE restart measurement, updated from the signaling thread.
+		mutable std::mutex iceRestartMutex;
+		// Whether an ICE restart is waiting for the ICE connection.
+		bool restartingIce{ false };
+		std::chrono::steady_clock::time_point iceRestartTime;
+		std::chrono::milliseconds iceRestartLatency{ 0 };
 		// App custom data.
 		nlohmann::json appData = nlohmann::json::object();
 	};
@@ -123,10 +139,16 @@ namespace mediasoupclient
 		  const PeerConnection::Options* peerConnectionOptions,
 		  const nlohmann::json* extendedRtpCapabilities,
 		  const std::map<std::string, bool>* canProduceByKind,
+		  std::shared_ptr<const nlohmann::json> sendingRtpParametersByKind,
+		  std::shared_ptr<const nlohmann::json> sendingRemoteRtpParametersByKind,
 		  const nlohmann::json& appData);
 
 		/* Device is the only one constructing Transports. */
 		friend Device;
+		/* AdaptiveLayerController inspects all the Producers. */
+		friend AdaptiveLayerController;
+		/* RecvTransport may share the SendHandler PeerConnection. */
+		friend RecvTransport;
 
 	public:
 		Producer* Produce(
@@ -135,7 +157,8 @@ namespace mediasoupclient
 		  const std::vector<webrtc::RtpEncodingParameters>* encodings,
 		  const nlohmann::json* codecOptions,
 		  const nlohmann::json* codec,
-		  const nlohmann::json& appData = nlohmann::json::object());
+		  const nlohmann::json& appData = nlohmann::json::object(),
+		  bool zeroRtpOnPause           = false);
 
 		DataProducer* ProduceData(
 		  DataProducer::Listener* listener,
@@ -146,9 +169,12 @@ namespace mediasoupclient
 		  int maxPacketLifeTime         = 0,
 		  const nlohmann::json& appData = nlohmann::json::object());
 
+		void CloseProducers(const std::vector<Producer*>& producers);
+
 		/* Virtual methods inherited from Transport. */
 	public:
 		void Close() override;
+		void Connect() override;
 
 		/* Virtual methods inherited from Producer::PrivateListener. */
 	public:
@@ -156,6 +182,9 @@ namespace mediasoupclient
 		void OnClose(DataProducer* dataProducer) override;
 		void OnReplaceTrack(const Producer* producer, webrtc::MediaStreamTrackInterface* track) override;
 		void OnSetMaxSpatialLayer(const Producer* producer, uint8_t maxSpatialLayer) override;
+		void OnSetRtpEncodingParameters(const Producer* producer, const nlohmann::json& encodings) override;
+		void OnPause(const Producer* producer) override;
+		void OnResume(const Producer* producer) override;
 		nlohmann::json OnGetStats(const Producer* producer) override;
 
 	private:
@@ -192,10 +221,26 @@ namespace mediasoupclient
 		  const PeerConnection::Options* peerConnectionOptions,
 		  const nlohmann::json* extendedRtpCapabilities,
 		  const nlohmann::json& appData);
+		RecvTransport(
+		  Listener* listener,
+		  SendTransport* sendTransport,
+		  const nlohmann::json* extendedRtpCapabilities,
+		  const nlohmann::json& appData);
 
 		/* Device is the only one constructing Transports */
 		friend Device;
 
+	public:
+		struct ConsumeOptions
+		{
+			std::string id;
+			std::string producerId;
+			std::string kind;
+			nlohmann::json rtpParameters;
+			nlohmann::json appData = nlohmann::json::object();
+			absl::optional<double> latencyHint;
+		};
+
 	public:
 		Consumer* Consume(
 		  Consumer::Listener* consumerListener,
@@ -203,7 +248,10 @@ namespace mediasoupclient
 		  const std::string& producerId,
 		  const std::string& kind,
 		  nlohmann::json* rtpParameters,
-		  const nlohmann::json& appData = nlohmann::json::object());
+		  const nlohmann::json& appData      = nlohmann::json::object(),
+		  absl::optional<double> latencyHint = absl::nullopt);
+		std::vector<Consumer*> Consume(
+		  Consumer::Listener* consumerListener, const std::vector<ConsumeOptions>& optionsList);
 
 		DataConsumer* ConsumeData(
 		  DataConsumer::Listener* listener,
@@ -214,9 +262,12 @@ namespace mediasoupclient
 		  const std::string& protocol   = std::string(),
 		  const nlohmann::json& appData = nlohmann::json::object());
 
+		void CloseConsumers(const std::vector<Consumer*>& consumers);
+
 		/* Virtual methods inherited from Transport. */
 	public:
 		void Close() override;
+		void Connect() override;
 
 		/* Virtual methods inherited from Consumer::PrivateListener. */
 	public:
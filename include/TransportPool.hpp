@@ -0,0 +1,64 @@
+#ifndef MSC_TRANSPORT_POOL_HPP
+#define MSC_TRANSPORT_POOL_HPP
+
+#include "PeerConnection.hpp"
+
+#include <deque>
+#include <memory> // unique_ptr
+#include <mutex>
+
+namespace mediasoupclient
+{
+	// Fast forward declarations.
+	class Handler;
+
+	/*
+	 * Keeps a number of PeerConnections created ahead of time, so that creating
+	 * a transport does not wait for the PeerConnection creation, the DTLS
+	 * certificate generation nor the ICE candidates gathering.
+	 *
+	 * Set it in the PeerConnection::Options given to Device::CreateSendTransport()
+	 * or Device::CreateRecvTransport(). The configuration of those options is
+	 * applied to the PeerConnection taken from the pool. If the pool is empty, or
+	 * the configuration cannot be applied (i.e. it sets different certificates),
+	 * a new PeerConnection is created as usual.
+	 */
+	class TransportPool
+	{
+	public:
+		explicit TransportPool(const PeerConnection::Options* peerConnectionOptions = nullptr, size_t size = 1u);
+		~TransportPool();
+
+	public:
+		// Creates PeerConnections until the pool is full. It may be called from
+		// any thread.
+		void Fill();
+		void Close();
+		bool IsClosed() const;
+		size_t GetSize() const;
+		size_t GetAvailable();
+
+	private:
+		// Takes a PeerConnection from the pool configured with the given options,
+		// or nullptr if none can be taken.
+		std::unique_ptr<PeerConnection> Acquire(
+		  PeerConnection::PrivateListener* privateListener,
+		  const PeerConnection::Options* peerConnectionOptions);
+
+		/* Handler is the only one acquiring PeerConnections. */
+		friend Handler;
+
+	private:
+		// Options given to every PeerConnection.
+		PeerConnection::Options peerConnectionOptions;
+		// Number of PeerConnections to keep.
+		size_t size{ 0u };
+		// Closed flag.
+		bool closed{ false };
+		// Available PeerConnections, oldest first.
+		std::deque<std::unique_ptr<PeerConnection>> peerConnections;
+		mutable std::mutex mutex;
+	};
+} // namespace mediasoupclient
+
+#endif
@@ -1,8 +1,12 @@
 #ifndef MEDIASOUP_CLIENT_HPP
 #define MEDIASOUP_CLIENT_HPP
 
+#include "AdaptiveLayerController.hpp"
+#include "BandwidthMonitor.hpp"
+#include "ConnectionQualityMonitor.hpp"
 #include "Device.hpp"
 #include "Logger.hpp"
+#include "TransportPool.hpp"
 
 namespace mediasoupclient
 {
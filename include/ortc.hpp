@@ -3,6 +3,7 @@
 
 #include <json.hpp>
 #include <string>
+#include <vector>
 
 namespace mediasoupclient
 {
@@ -26,11 +27,19 @@ namespace mediasoupclient
 		void validateDtlsParameters(nlohmann::json& params);
 		void validateProducerCodecOptions(nlohmann::json& params);
 		nlohmann::json getExtendedRtpCapabilities(nlohmann::json& localCaps, nlohmann::json& remoteCaps);
+		void validateRtpCapabilitiesProfile(const nlohmann::json& profile);
+		void applyRtpCapabilitiesProfile(
+		  nlohmann::json& extendedRtpCapabilities, const nlohmann::json& profile);
+		std::vector<std::string> getRtpCapabilitiesProfileKinds(const nlohmann::json& profile);
+		void reduceRtpCapabilitiesKinds(
+		  nlohmann::json& caps, const std::vector<std::string>& kinds);
 		nlohmann::json getRecvRtpCapabilities(const nlohmann::json& extendedRtpCapabilities);
 		nlohmann::json getSendingRtpParameters(
 		  const std::string& kind, const nlohmann::json& extendedRtpCapabilities);
 		nlohmann::json getSendingRemoteRtpParameters(
 		  const std::string& kind, const nlohmann::json& extendedRtpCapabilities);
+		nlohmann::json getReceivingRtpParameters(
+		  const std::string& kind, const nlohmann::json& extendedRtpCapabilities);
 		const nlohmann::json generateProbatorRtpParameters(const nlohmann::json& videoRtpParameters);
 		bool canSend(const std::string& kind, const nlohmann::json& extendedRtpCapabilities);
 		bool canReceive(nlohmann::json& rtpParameters, const nlohmann::json& extendedRtpCapabilities);
@@ -0,0 +1,65 @@
+#ifndef MSC_LOCAL_SDP_HPP
+#define MSC_LOCAL_SDP_HPP
+
+#include <json.hpp>
+#include <absl/strings/string_view.h>
+#include <absl/types/optional.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mediasoupclient
+{
+	namespace Sdp
+	{
+		/*
+		 * Lazy view over a SDP generated by libwebrtc. It just indexes the media
+		 * section boundaries and only tokenizes the lines asked for, so reading a
+		 * few attributes does not need a full sdptransform::parse().
+		 */
+		class LocalSdp
+		{
+		public:
+			explicit LocalSdp(std::string sdp);
+
+		public:
+			const std::string& GetSdp() const;
+			size_t GetMediaSectionCount() const;
+			// Media section index of the given MID, absl::nullopt if not found.
+			absl::optional<size_t> GetMediaSectionIdx(const std::string& mid) const;
+			// Media type (audio, video, application) of the given media section.
+			absl::string_view GetMediaType(size_t idx) const;
+			bool IsMediaSectionClosed(size_t idx) const;
+			// Value of the first a=<name>[:<value>] line of the session or of the
+			// given media section. absl::nullopt if there is no such line.
+			absl::optional<absl::string_view> GetSessionAttribute(absl::string_view name) const;
+			absl::optional<absl::string_view> GetAttribute(size_t idx, absl::string_view name) const;
+			// Values of all the a=<name>[:<value>] lines of the given media section.
+			std::vector<absl::string_view> GetAttributes(size_t idx, absl::string_view name) const;
+			// The given media section as sdptransform::parse() would give it.
+			nlohmann::json ParseMediaSection(size_t idx) const;
+			// Replaces the given media section with the SDP lines of the given object.
+			void SetMediaSection(size_t idx, const nlohmann::json& mediaObject);
+			// Same as Sdp::Utils::extractDtlsParameters() on the parsed SDP.
+			nlohmann::json ExtractDtlsParameters() const;
+
+		private:
+			void IndexMediaSections();
+			absl::string_view GetSection(size_t sectionIdx) const;
+			absl::optional<absl::string_view> FindAttribute(
+			  absl::string_view section, absl::string_view name) const;
+
+		private:
+			std::string sdp;
+			// [begin, end) offsets of the session lines (first) and of each media
+			// section.
+			std::vector<std::pair<size_t, size_t>> sections;
+			// Media section indices indexed by MID, filled when first needed.
+			mutable std::unordered_map<std::string, size_t> midToIndex;
+			mutable bool midsIndexed{ false };
+		};
+	} // namespace Sdp
+} // namespace mediasoupclient
+
+#endif
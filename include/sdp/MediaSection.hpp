@@ -16,12 +16,19 @@ namespace mediasoupclient
 			MediaSection(const nlohmann::json& iceParameters, const nlohmann::json& iceCandidates);
 
 		public:
-			std::string GetMid() const;
+			const std::string& GetMid() const;
 			bool IsClosed() const;
-			nlohmann::json GetObject() const;
+			const nlohmann::json& GetObject() const;
 			void SetIceParameters(const nlohmann::json& iceParameters);
+			// For ICE parameters given at session level.
+			void RemoveIceParameters();
+			// For media sections bundled in another one.
+			void RemoveIceCandidates();
 			void Disable();
 			void Close();
+			// Sets a=setup for the given DTLS role, whether this media section belongs
+			// to an offer or to an answer.
+			void ForceDtlsRole(const std::string& role);
 
 		public:
 			virtual void SetDtlsRole(const std::string& role) = 0;
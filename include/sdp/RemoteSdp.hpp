@@ -3,8 +3,10 @@
 
 #include "sdp/MediaSection.hpp"
 #include <json.hpp>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace mediasoupclient
 {
@@ -25,10 +27,19 @@ namespace mediasoupclient
 			  const nlohmann::json& iceCandidates,
 			  const nlohmann::json& dtlsParameters,
 			  const nlohmann::json& sctpParameters);
-			~RemoteSdp();
 
 		public:
-			Sdp::RemoteSdp::MediaSectionIdx GetNextMediaSectionIdx();
+			// Lets this remote SDP carry both answer media sections (for the tracks we
+			// send) and offer media sections (for the tracks we receive) so it can be
+			// used both as an offer and as an answer on the same PeerConnection.
+			void SetMixedRoles();
+			// Writes ICE parameters at session level and ICE candidates just in the
+			// BUNDLE tagged (first) media section, as every other media section uses
+			// its transport.
+			void SetCompact();
+			// Skips the given number of free media sections, for those already taken
+			// by a pending negotiation.
+			Sdp::RemoteSdp::MediaSectionIdx GetNextMediaSectionIdx(size_t skip = 0u);
 			void Send(
 			  nlohmann::json& offerMediaObject,
 			  const std::string& reuseMid,
@@ -49,12 +60,20 @@ namespace mediasoupclient
 			void UpdateDtlsRole(const std::string& role);
 			void DisableMediaSection(const std::string& mid);
 			void CloseMediaSection(const std::string& mid);
+			bool HasMediaSection(const std::string& mid) const;
+			// Index of the media section with the given MID. May throw.
+			size_t GetMediaSectionIdx(const std::string& mid) const;
 			std::string GetSdp();
 
 		private:
-			void AddMediaSection(MediaSection* newMediaSection);
-			void ReplaceMediaSection(MediaSection* newMediaSection, const std::string& reuseMid);
+			void AddMediaSection(std::unique_ptr<MediaSection> newMediaSection);
+			void ReplaceMediaSection(
+			  std::unique_ptr<MediaSection> newMediaSection, const std::string& reuseMid);
+			void UpdateMediaObject(size_t idx);
+			void ApplyCompactTransport(size_t idx);
+			void SetSessionIceParameters();
 			void RegenerateBundleMids();
+			void ApplyMixedDtlsRole(MediaSection* mediaSection) const;
 
 		protected:
 			// Generic sending RTP parameters for audio and video.
@@ -65,16 +84,22 @@ namespace mediasoupclient
 			nlohmann::json iceCandidates  = nlohmann::json::object();
 			nlohmann::json dtlsParameters = nlohmann::json::object();
 			nlohmann::json sctpParameters = nlohmann::json::object();
-			// MediaSection instances.
-			std::vector<MediaSection*> mediaSections;
+			// MediaSection instances. Their objects are the SDP media sections.
+			std::vector<std::unique_ptr<MediaSection>> mediaSections;
 			// MediaSection indices indexed by MID.
-			std::map<std::string, size_t> midToIndex;
+			std::unordered_map<std::string, size_t> midToIndex;
 			// First MID.
 			std::string firstMid;
 			// Generic sending RTP parameters for audio and video.
 			nlohmann::json sendingRtpParametersByKind = nlohmann::json::object();
-			// SDP global fields.
+			// SDP global fields, with no media sections.
 			nlohmann::json sdpObject = nlohmann::json::object();
+			// SDP text of each media section, empty if it must be written again.
+			std::vector<std::string> mediaSdps;
+			// Whether offer and answer media sections are mixed.
+			bool mixedRoles{ false };
+			// Whether transport attributes are written just once.
+			bool compact{ false };
 		};
 	} // namespace Sdp
 } // namespace mediasoupclient
@@ -19,6 +19,9 @@ namespace mediasoupclient
 			std::string getCname(const json& offerMediaObject);
 			json getRtpEncodings(const json& offerMediaObject);
 			void applyCodecParameters(const json& offerRtpParameters, json& answerMediaObject);
+			// SDP lines of the given media section, as sdptransform::write() gives
+			// them within a whole SDP.
+			std::string writeMediaObject(const json& mediaObject);
 		} // namespace Utils
 	}   // namespace Sdp
 } // namespace mediasoupclient
@@ -0,0 +1,231 @@
+#define MSC_CLASS "AdaptiveLayerController"
+
+#include "AdaptiveLayerController.hpp"
+#include "Logger.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "Transport.hpp"
+
+#include <cinttypes>
+
+using json = nlohmann::json;
+
+namespace mediasoupclient
+{
+	AdaptiveLayerController::AdaptiveLayerController(
+	  SendTransport* sendTransport, Listener* listener, const Options& options)
+	  : sendTransport(sendTransport), listener(listener), options(options)
+	{
+		MSC_TRACE();
+
+		if (!sendTransport)
+			MSC_THROW_TYPE_ERROR("missing sendTransport");
+		else if (options.underuseEncodeUsage >= options.overuseEncodeUsage)
+			MSC_THROW_TYPE_ERROR("underuseEncodeUsage must be lower than overuseEncodeUsage");
+	}
+
+	void AdaptiveLayerController::Tick()
+	{
+		MSC_TRACE();
+
+		if (this->sendTransport->IsClosed())
+			return;
+
+		const auto& producers = this->sendTransport->producers;
+
+		// Forget closed Producers.
+		for (auto it = this->producerStates.begin(); it != this->producerStates.end();)
+		{
+			if (producers.find(it->first) == producers.end())
+				it = this->producerStates.erase(it);
+			else
+				++it;
+		}
+
+		for (const auto& kv : producers)
+		{
+			auto* producer = kv.second;
+
+			if (producer->IsClosed() || producer->GetKind() != "video")
+				continue;
+
+			// Nothing to adapt with a single encoding.
+			if (producer->GetRtpParameters()["encodings"].size() < 2)
+				continue;
+
+			// A paused Producer does not encode, do not take it as underused.
+			if (producer->IsPaused())
+			{
+				auto stateIt = this->producerStates.find(producer->GetId());
+
+				if (stateIt != this->producerStates.end())
+				{
+					stateIt->second.sampled       = false;
+					stateIt->second.overuseCount  = 0u;
+					stateIt->second.underuseCount = 0u;
+				}
+
+				continue;
+			}
+
+			try
+			{
+				// May throw.
+				Inspect(producer, producer->GetStats());
+			}
+			catch (MediaSoupClientError& error)
+			{
+				MSC_WARN("failed to adapt Producer [id:%s]: %s", producer->GetId().c_str(), error.what());
+
+				this->producerStates.erase(producer->GetId());
+			}
+		}
+	}
+
+	void AdaptiveLayerController::Inspect(
+	  Producer* producer, const json& stats, std::chrono::steady_clock::time_point now)
+	{
+		MSC_TRACE();
+
+		auto numLayers = static_cast<uint8_t>(producer->GetRtpParameters()["encodings"].size());
+		auto& state    = this->producerStates[producer->GetId()];
+
+		double totalEncodeTime{ 0 };
+		uint64_t bitrate{ 0u };
+		bool cpuLimited{ false };
+		bool bandwidthLimited{ false };
+		std::unordered_map<std::string, uint64_t> bytesSent;
+
+		double elapsed = std::chrono::duration<double>(now - state.sampledAt).count();
+
+		for (const auto& stat : stats)
+		{
+			auto typeIt = stat.find("type");
+
+			if (typeIt == stat.end() || *typeIt != "outbound-rtp")
+				continue;
+
+			auto totalEncodeTimeIt         = stat.find("totalEncodeTime");
+			auto bytesSentIt               = stat.find("bytesSent");
+			auto qualityLimitationReasonIt = stat.find("qualityLimitationReason");
+			auto ridIt                     = stat.find("rid");
+			std::string rid;
+
+			if (ridIt != stat.end() && ridIt->is_string())
+				rid = ridIt->get<std::string>();
+
+			if (totalEncodeTimeIt != stat.end() && totalEncodeTimeIt->is_number())
+				totalEncodeTime += totalEncodeTimeIt->get<double>();
+
+			if (bytesSentIt != stat.end() && bytesSentIt->is_number_unsigned())
+			{
+				auto value     = bytesSentIt->get<uint64_t>();
+				bytesSent[rid] = value;
+
+				auto previousIt = state.bytesSent.find(rid);
+
+				if (state.sampled && previousIt != state.bytesSent.end() && value > previousIt->second)
+					bitrate += static_cast<uint64_t>((value - previousIt->second) * 8 / elapsed);
+			}
+
+			if (qualityLimitationReasonIt != stat.end() && qualityLimitationReasonIt->is_string())
+			{
+				if (*qualityLimitationReasonIt == "cpu")
+					cpuLimited = true;
+				else if (*qualityLimitationReasonIt == "bandwidth")
+					bandwidthLimited = true;
+			}
+		}
+
+		bool sampled               = state.sampled;
+		double lastTotalEncodeTime = state.totalEncodeTime;
+		state.sampled              = true;
+		state.sampledAt            = now;
+		state.totalEncodeTime      = totalEncodeTime;
+		state.bytesSent            = bytesSent;
+
+		// Need two samples to compute rates.
+		if (!sampled || elapsed <= 0)
+			return;
+
+		// Nothing is being sent (i.e. muted track), so nothing to measure.
+		if (bitrate == 0u)
+		{
+			state.overuseCount  = 0u;
+			state.underuseCount = 0u;
+
+			return;
+		}
+
+		double encodeUsage = (totalEncodeTime - lastTotalEncodeTime) / elapsed;
+
+		MSC_DEBUG(
+		  "[producerId:%s, encodeUsage:%.2f, bitrate:%" PRIu64 ", cpuLimited:%s]",
+		  producer->GetId().c_str(),
+		  encodeUsage,
+		  bitrate,
+		  cpuLimited ? "true" : "false");
+
+		if (cpuLimited || encodeUsage > this->options.overuseEncodeUsage)
+		{
+			state.underuseCount = 0u;
+
+			if (++state.overuseCount < this->options.overuseCount)
+				return;
+		}
+		else if (!bandwidthLimited && encodeUsage < this->options.underuseEncodeUsage)
+		{
+			state.overuseCount = 0u;
+
+			if (++state.underuseCount < this->options.underuseCount)
+				return;
+		}
+		else
+		{
+			state.overuseCount  = 0u;
+			state.underuseCount = 0u;
+
+			return;
+		}
+
+		auto spatialLayer = producer->GetMaxSpatialLayer();
+
+		// 0 means that no max spatial layer was set, so all of them are active.
+		if (spatialLayer == 0u || spatialLayer > numLayers)
+			spatialLayer = numLayers;
+
+		// Unless it is the one set by the controller, the current max spatial layer
+		// was set by the application, so never raise above it.
+		if (spatialLayer != state.appliedSpatialLayer)
+			state.maxSpatialLayer = spatialLayer;
+
+		uint8_t newSpatialLayer = spatialLayer;
+
+		if (state.overuseCount > 0u && spatialLayer > 1u)
+			newSpatialLayer = static_cast<uint8_t>(spatialLayer - 1);
+		else if (state.underuseCount > 0u && spatialLayer < state.maxSpatialLayer)
+			newSpatialLayer = static_cast<uint8_t>(spatialLayer + 1);
+
+		state.overuseCount  = 0u;
+		state.underuseCount = 0u;
+
+		if (newSpatialLayer == spatialLayer)
+			return;
+
+		MSC_DEBUG(
+		  "changing max spatial layer [producerId:%s, from:%" PRIu8 ", to:%" PRIu8 "]",
+		  producer->GetId().c_str(),
+		  spatialLayer,
+		  newSpatialLayer);
+
+		// May throw.
+		producer->SetMaxSpatialLayer(newSpatialLayer);
+
+		state.appliedSpatialLayer = newSpatialLayer;
+
+		// Encoding time of the previous layers is not representative anymore.
+		state.sampled = false;
+
+		if (this->listener)
+			this->listener->OnMaxSpatialLayerChange(producer, newSpatialLayer);
+	}
+} // namespace mediasoupclient
@@ -0,0 +1,176 @@
+#define MSC_CLASS "BandwidthMonitor"
+
+#include "BandwidthMonitor.hpp"
+#include "Logger.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "Transport.hpp"
+
+#include <cinttypes>
+
+using json = nlohmann::json;
+
+namespace mediasoupclient
+{
+	BandwidthMonitor::BandwidthMonitor(
+	  SendTransport* sendTransport, Listener* listener, const Options& options)
+	  : sendTransport(sendTransport), listener(listener), options(options)
+	{
+		MSC_TRACE();
+
+		if (!sendTransport)
+			MSC_THROW_TYPE_ERROR("missing sendTransport");
+		else if (options.congestionDropRatio <= 0 || options.congestionDropRatio >= 1)
+			MSC_THROW_TYPE_ERROR("congestionDropRatio must be between 0 and 1");
+	}
+
+	void BandwidthMonitor::Tick()
+	{
+		MSC_TRACE();
+
+		if (this->sendTransport->IsClosed())
+			return;
+
+		try
+		{
+			// May throw.
+			Inspect(this->sendTransport->GetStats());
+		}
+		catch (MediaSoupClientError& error)
+		{
+			MSC_WARN("failed to get transport stats: %s", error.what());
+		}
+	}
+
+	void BandwidthMonitor::Inspect(const json& stats)
+	{
+		MSC_TRACE();
+
+		// The ICE candidate pair selected by the transport, others may be nominated
+		// too (e.g. after an ICE restart).
+		std::string selectedCandidatePairId;
+		// Available outgoing bitrates indexed by candidate pair id.
+		std::unordered_map<std::string, uint64_t> availableOutgoingBitrates;
+		// Sums of the deltas of the outbound RTP streams since the previous
+		// inspection. New streams need two samples.
+		double totalPacketSendDelay{ 0 };
+		uint64_t packetsSent{ 0u };
+		std::unordered_map<std::string, OutboundRtpState> outboundRtpStates;
+
+		for (const auto& stat : stats)
+		{
+			auto typeIt = stat.find("type");
+
+			if (typeIt == stat.end())
+				continue;
+
+			if (*typeIt == "transport")
+			{
+				auto selectedCandidatePairIdIt = stat.find("selectedCandidatePairId");
+
+				if (selectedCandidatePairIdIt != stat.end() && selectedCandidatePairIdIt->is_string())
+					selectedCandidatePairId = selectedCandidatePairIdIt->get<std::string>();
+			}
+			else if (*typeIt == "candidate-pair")
+			{
+				auto idIt                       = stat.find("id");
+				auto availableOutgoingBitrateIt = stat.find("availableOutgoingBitrate");
+
+				if (
+				  idIt != stat.end() && idIt->is_string() && availableOutgoingBitrateIt != stat.end() &&
+				  availableOutgoingBitrateIt->is_number())
+				{
+					availableOutgoingBitrates[idIt->get<std::string>()] =
+					  availableOutgoingBitrateIt->get<uint64_t>();
+				}
+			}
+			else if (*typeIt == "outbound-rtp")
+			{
+				auto idIt                   = stat.find("id");
+				auto totalPacketSendDelayIt = stat.find("totalPacketSendDelay");
+				auto packetsSentIt          = stat.find("packetsSent");
+
+				if (
+				  idIt == stat.end() || !idIt->is_string() || totalPacketSendDelayIt == stat.end() ||
+				  !totalPacketSendDelayIt->is_number() || packetsSentIt == stat.end() ||
+				  !packetsSentIt->is_number_unsigned())
+				{
+					continue;
+				}
+
+				OutboundRtpState state;
+
+				state.totalPacketSendDelay = totalPacketSendDelayIt->get<double>();
+				state.packetsSent          = packetsSentIt->get<uint64_t>();
+
+				auto previousIt = this->outboundRtpStates.find(idIt->get<std::string>());
+
+				// Skip the streams whose counters went back, i.e. restarted.
+				if (
+				  previousIt != this->outboundRtpStates.end() &&
+				  state.packetsSent > previousIt->second.packetsSent &&
+				  state.totalPacketSendDelay >= previousIt->second.totalPacketSendDelay)
+				{
+					totalPacketSendDelay +=
+					  state.totalPacketSendDelay - previousIt->second.totalPacketSendDelay;
+					packetsSent += state.packetsSent - previousIt->second.packetsSent;
+				}
+
+				outboundRtpStates[idIt->get<std::string>()] = state;
+			}
+		}
+
+		this->outboundRtpStates = std::move(outboundRtpStates);
+
+		Estimation estimation;
+
+		auto availableOutgoingBitrateIt = availableOutgoingBitrates.find(selectedCandidatePairId);
+
+		if (availableOutgoingBitrateIt != availableOutgoingBitrates.end())
+			estimation.availableOutgoingBitrate = availableOutgoingBitrateIt->second;
+
+		if (packetsSent > 0u)
+		{
+			auto delay = totalPacketSendDelay / static_cast<double>(packetsSent);
+
+			estimation.pacerQueueDelay =
+			  std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(delay));
+		}
+
+		auto previousBitrate = this->estimation.availableOutgoingBitrate;
+
+		this->estimation = estimation;
+
+		MSC_DEBUG(
+		  "[availableOutgoingBitrate:%" PRIu64 ", pacerQueueDelay:%lldms]",
+		  estimation.availableOutgoingBitrate,
+		  static_cast<long long>(estimation.pacerQueueDelay.count()));
+
+		if (!this->listener)
+			return;
+
+		this->listener->OnBandwidthEstimation(estimation);
+
+		if (previousBitrate == 0u || estimation.availableOutgoingBitrate == 0u)
+			return;
+
+		auto bitrate   = static_cast<double>(estimation.availableOutgoingBitrate);
+		auto dropRatio = (static_cast<double>(previousBitrate) - bitrate) / previousBitrate;
+
+		if (dropRatio >= this->options.congestionDropRatio)
+		{
+			MSC_DEBUG(
+			  "congestion [availableOutgoingBitrate:%" PRIu64 ", previousBitrate:%" PRIu64 "]",
+			  estimation.availableOutgoingBitrate,
+			  previousBitrate);
+
+			this->listener->OnCongestion(estimation, previousBitrate);
+		}
+	}
+
+	BandwidthMonitor::Estimation BandwidthMonitor::GetEstimation() const
+	{
+		MSC_TRACE();
+
+		return this->estimation;
+	}
+} // namespace mediasoupclient
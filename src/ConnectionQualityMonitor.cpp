@@ -0,0 +1,286 @@
+#define MSC_CLASS "ConnectionQualityMonitor"
+
+#include "ConnectionQualityMonitor.hpp"
+#include "Logger.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "Transport.hpp"
+
+#include <algorithm>
+
+using json = nlohmann::json;
+
+namespace mediasoupclient
+{
+	/* Class variables. */
+
+	// clang-format off
+	std::map<ConnectionQualityMonitor::Quality, const std::string> ConnectionQualityMonitor::quality2String =
+	{
+		{ ConnectionQualityMonitor::Quality::UNKNOWN, "unknown" },
+		{ ConnectionQualityMonitor::Quality::GOOD,    "good"    },
+		{ ConnectionQualityMonitor::Quality::FAIR,    "fair"    },
+		{ ConnectionQualityMonitor::Quality::POOR,    "poor"    }
+	};
+	// clang-format on
+
+	ConnectionQualityMonitor::ConnectionQualityMonitor(
+	  Transport* transport, Listener* listener, const Options& options)
+	  : transport(transport), listener(listener), options(options)
+	{
+		MSC_TRACE();
+
+		if (!transport)
+			MSC_THROW_TYPE_ERROR("missing transport");
+		else if (options.smoothingFactor <= 0 || options.smoothingFactor > 1)
+			MSC_THROW_TYPE_ERROR("smoothingFactor must be greater than 0 and not greater than 1");
+		else if (
+		  options.goodRoundTripTime > options.poorRoundTripTime ||
+		  options.goodPacketLoss > options.poorPacketLoss || options.goodJitter > options.poorJitter)
+		{
+			MSC_THROW_TYPE_ERROR("good thresholds must not be greater than poor ones");
+		}
+	}
+
+	void ConnectionQualityMonitor::Tick()
+	{
+		MSC_TRACE();
+
+		if (this->transport->IsClosed())
+			return;
+
+		try
+		{
+			// May throw.
+			Inspect(this->transport->GetStats());
+		}
+		catch (MediaSoupClientError& error)
+		{
+			MSC_WARN("failed to get transport stats: %s", error.what());
+		}
+	}
+
+	void ConnectionQualityMonitor::Inspect(const json& stats)
+	{
+		MSC_TRACE();
+
+		bool hasRoundTripTime{ false };
+		bool hasPacketLoss{ false };
+		bool hasJitter{ false };
+		// The ICE candidate pair selected by the transport, others may be nominated
+		// too (e.g. after an ICE restart).
+		std::string selectedCandidatePairId;
+		// ICE RTTs indexed by candidate pair id.
+		std::unordered_map<std::string, double> candidatePairRoundTripTimes;
+		double remoteRoundTripTime{ 0 };
+		double remotePacketLoss{ 0 };
+		double jitter{ 0 };
+		// Sums of the deltas of the inbound RTP streams since the previous sample.
+		// New streams need two samples.
+		uint64_t packetsReceived{ 0u };
+		uint64_t packetsLost{ 0u };
+		std::unordered_map<std::string, InboundRtpState> inboundRtpStates;
+
+		for (const auto& stat : stats)
+		{
+			auto typeIt = stat.find("type");
+
+			if (typeIt == stat.end())
+				continue;
+
+			if (*typeIt == "transport")
+			{
+				auto selectedCandidatePairIdIt = stat.find("selectedCandidatePairId");
+
+				if (selectedCandidatePairIdIt != stat.end() && selectedCandidatePairIdIt->is_string())
+					selectedCandidatePairId = selectedCandidatePairIdIt->get<std::string>();
+			}
+			else if (*typeIt == "candidate-pair")
+			{
+				auto idIt            = stat.find("id");
+				auto roundTripTimeIt = stat.find("currentRoundTripTime");
+
+				if (
+				  idIt != stat.end() && idIt->is_string() && roundTripTimeIt != stat.end() &&
+				  roundTripTimeIt->is_number())
+				{
+					candidatePairRoundTripTimes[idIt->get<std::string>()] = roundTripTimeIt->get<double>();
+				}
+			}
+			else if (*typeIt == "remote-inbound-rtp")
+			{
+				auto roundTripTimeIt = stat.find("roundTripTime");
+				auto fractionLostIt  = stat.find("fractionLost");
+				auto jitterIt        = stat.find("jitter");
+
+				if (roundTripTimeIt != stat.end() && roundTripTimeIt->is_number())
+				{
+					hasRoundTripTime    = true;
+					remoteRoundTripTime = std::max(remoteRoundTripTime, roundTripTimeIt->get<double>());
+				}
+
+				if (fractionLostIt != stat.end() && fractionLostIt->is_number())
+				{
+					hasPacketLoss    = true;
+					remotePacketLoss = std::max(remotePacketLoss, fractionLostIt->get<double>());
+				}
+
+				if (jitterIt != stat.end() && jitterIt->is_number())
+				{
+					hasJitter = true;
+					jitter    = std::max(jitter, jitterIt->get<double>());
+				}
+			}
+			else if (*typeIt == "inbound-rtp")
+			{
+				auto idIt              = stat.find("id");
+				auto packetsReceivedIt = stat.find("packetsReceived");
+				auto packetsLostIt     = stat.find("packetsLost");
+				auto jitterIt          = stat.find("jitter");
+
+				if (jitterIt != stat.end() && jitterIt->is_number())
+				{
+					hasJitter = true;
+					jitter    = std::max(jitter, jitterIt->get<double>());
+				}
+
+				if (
+				  idIt == stat.end() || !idIt->is_string() || packetsReceivedIt == stat.end() ||
+				  !packetsReceivedIt->is_number_unsigned() || packetsLostIt == stat.end() ||
+				  !packetsLostIt->is_number_integer())
+				{
+					continue;
+				}
+
+				InboundRtpState state;
+
+				state.packetsReceived = packetsReceivedIt->get<uint64_t>();
+				state.packetsLost     = packetsLostIt->get<int64_t>();
+
+				auto previousIt = this->inboundRtpStates.find(idIt->get<std::string>());
+
+				// Skip the streams whose counters went back, i.e. restarted.
+				if (
+				  previousIt != this->inboundRtpStates.end() &&
+				  state.packetsReceived >= previousIt->second.packetsReceived)
+				{
+					packetsReceived += state.packetsReceived - previousIt->second.packetsReceived;
+
+					// packetsLost is signed, duplicated packets may make it go back.
+					if (state.packetsLost > previousIt->second.packetsLost)
+					{
+						packetsLost +=
+						  static_cast<uint64_t>(state.packetsLost - previousIt->second.packetsLost);
+					}
+				}
+
+				inboundRtpStates[idIt->get<std::string>()] = state;
+			}
+		}
+
+		this->inboundRtpStates = std::move(inboundRtpStates);
+
+		// The ICE RTT is preferred since it does not depend on RTCP.
+		double roundTripTime              = remoteRoundTripTime;
+		auto candidatePairRoundTripTimeIt = candidatePairRoundTripTimes.find(selectedCandidatePairId);
+
+		if (candidatePairRoundTripTimeIt != candidatePairRoundTripTimes.end())
+		{
+			hasRoundTripTime = true;
+			roundTripTime    = candidatePairRoundTripTimeIt->second;
+		}
+
+		// Packet loss of the received streams since the previous sample.
+		double packetLoss = remotePacketLoss;
+
+		if (packetsReceived + packetsLost > 0u)
+		{
+			auto lost = static_cast<double>(packetsLost);
+
+			hasPacketLoss = true;
+			packetLoss    = std::max(packetLoss, lost / (static_cast<double>(packetsReceived) + lost));
+		}
+
+		if (!hasRoundTripTime && !hasPacketLoss && !hasJitter)
+			return;
+
+		auto alpha = this->options.smoothingFactor;
+
+		// The first sample of each metric is taken as is.
+		auto smooth = [alpha](double& current, bool& sampled, double sample) {
+			current = sampled ? (alpha * sample) + ((1 - alpha) * current) : sample;
+			sampled = true;
+		};
+
+		if (hasRoundTripTime)
+			smooth(this->roundTripTime, this->roundTripTimeSampled, roundTripTime);
+
+		if (hasPacketLoss)
+			smooth(this->packetLoss, this->packetLossSampled, packetLoss);
+
+		if (hasJitter)
+			smooth(this->jitter, this->jitterSampled, jitter);
+
+		auto metrics         = GetMetrics();
+		auto quality         = ComputeQuality(metrics);
+		auto previousQuality = this->quality;
+
+		this->quality = quality;
+
+		if (quality == previousQuality)
+			return;
+
+		MSC_DEBUG(
+		  "quality changed [quality:%s, roundTripTime:%lldms, packetLoss:%.3f, jitter:%lldms]",
+		  ConnectionQualityMonitor::quality2String[quality].c_str(),
+		  static_cast<long long>(metrics.roundTripTime.count()),
+		  metrics.packetLoss,
+		  static_cast<long long>(metrics.jitter.count()));
+
+		if (this->listener)
+			this->listener->OnQualityChange(quality, metrics);
+	}
+
+	ConnectionQualityMonitor::Quality ConnectionQualityMonitor::GetQuality() const
+	{
+		MSC_TRACE();
+
+		return this->quality;
+	}
+
+	ConnectionQualityMonitor::Metrics ConnectionQualityMonitor::GetMetrics() const
+	{
+		MSC_TRACE();
+
+		Metrics metrics;
+
+		metrics.roundTripTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+		  std::chrono::duration<double>(this->roundTripTime));
+		metrics.packetLoss = this->packetLoss;
+		metrics.jitter =
+		  std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(this->jitter));
+
+		return metrics;
+	}
+
+	ConnectionQualityMonitor::Quality ConnectionQualityMonitor::ComputeQuality(
+	  const Metrics& metrics) const
+	{
+		MSC_TRACE();
+
+		if (
+		  metrics.roundTripTime > this->options.poorRoundTripTime ||
+		  metrics.packetLoss > this->options.poorPacketLoss || metrics.jitter > this->options.poorJitter)
+		{
+			return Quality::POOR;
+		}
+		else if (
+		  metrics.roundTripTime <= this->options.goodRoundTripTime &&
+		  metrics.packetLoss <= this->options.goodPacketLoss &&
+		  metrics.jitter <= this->options.goodJitter)
+		{
+			return Quality::GOOD;
+		}
+
+		return Quality::FAIR;
+	}
+} // namespace mediasoupclient
@@ -3,6 +3,7 @@
 #include "Consumer.hpp"
 #include "Logger.hpp"
 #include "MediaSoupClientErrors.hpp"
+#include <cmath> // std::isfinite
 
 using json = nlohmann::json;
 
@@ -152,6 +153,32 @@ namespace mediasoupclient
 		this->track->set_enabled(true);
 	}
 
+	/**
+	 * Sets the jitter buffer minimum delay of the RTCRtpReceiver.
+	 */
+	void Consumer::SetLatencyHint(absl::optional<double> latencyHint)
+	{
+		MSC_TRACE();
+
+		if (this->closed)
+			MSC_THROW_INVALID_STATE_ERROR("Consumer closed");
+		else if (
+		  latencyHint &&
+		  (!std::isfinite(*latencyHint) || *latencyHint < 0 || *latencyHint > MaxLatencyHint))
+			MSC_THROW_TYPE_ERROR("invalid latencyHint");
+
+		this->rtpReceiver->SetJitterBufferMinimumDelay(latencyHint);
+
+		this->latencyHint = latencyHint;
+	}
+
+	absl::optional<double> Consumer::GetLatencyHint() const
+	{
+		MSC_TRACE();
+
+		return this->latencyHint;
+	}
+
 	/**
 	 * Transport was closed.
 	 */
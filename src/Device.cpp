@@ -4,9 +4,22 @@
 #include "Logger.hpp"
 #include "MediaSoupClientErrors.hpp"
 #include "ortc.hpp"
+#include "version.hpp"
+#include <fstream>
+#include <iterator> // std::istreambuf_iterator
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 using json = nlohmann::json;
 
+// Static functions declaration.
+static std::string getCapabilitiesKey(
+  const json& routerRtpCapabilities, const json& profile, const json& nativeCodecs);
+static std::string getHash(const std::string& data);
+static std::shared_ptr<const json> getLoadParameters(
+  json routerRtpCapabilities, const json& profile, json nativeCodecs);
+
 namespace mediasoupclient
 {
 	/**
@@ -29,7 +42,7 @@ namespace mediasoupclient
 		if (!this->loaded)
 			MSC_THROW_INVALID_STATE_ERROR("not loaded");
 
-		return this->recvRtpCapabilities;
+		return this->capabilities->recvRtpCapabilities;
 	}
 
 	/**
@@ -42,13 +55,16 @@ namespace mediasoupclient
 		if (!this->loaded)
 			MSC_THROW_INVALID_STATE_ERROR("not loaded");
 
-		return this->sctpCapabilities;
+		return this->capabilities->sctpCapabilities;
 	}
 
 	/**
 	 * Initialize the Device.
 	 */
-	void Device::Load(json routerRtpCapabilities, const PeerConnection::Options* peerConnectionOptions)
+	void Device::Load(
+	  json routerRtpCapabilities,
+	  const PeerConnection::Options* peerConnectionOptions,
+	  const json& rtpCapabilitiesProfile)
 	{
 		MSC_TRACE();
 
@@ -57,44 +73,214 @@ namespace mediasoupclient
 
 		// This may throw.
 		ortc::validateRtpCapabilities(routerRtpCapabilities);
+		ortc::validateRtpCapabilitiesProfile(rtpCapabilitiesProfile);
+
+		auto kinds = ortc::getRtpCapabilitiesProfileKinds(rtpCapabilitiesProfile);
+		json nativeCodecs;
 
 		// Get Native RTP capabilities.
-		auto nativeRtpCapabilities = Handler::GetNativeRtpCapabilities(peerConnectionOptions);
+		auto nativeRtpCapabilities =
+		  Handler::GetNativeRtpCapabilities(peerConnectionOptions, kinds, &nativeCodecs);
 
 		MSC_DEBUG("got native RTP capabilities:\n%s", nativeRtpCapabilities.dump(4).c_str());
 
 		// This may throw.
 		ortc::validateRtpCapabilities(nativeRtpCapabilities);
 
+		// Before the router RTP capabilities are modified by the matching.
+		auto loadParameters = getLoadParameters(
+		  routerRtpCapabilities, rtpCapabilitiesProfile, std::move(nativeCodecs));
+
+		// Do not match codecs and header extensions of other kinds.
+		ortc::reduceRtpCapabilitiesKinds(routerRtpCapabilities, kinds);
+
+		Capabilities capabilities;
+
 		// Get extended RTP capabilities.
-		this->extendedRtpCapabilities =
+		capabilities.extendedRtpCapabilities =
 		  ortc::getExtendedRtpCapabilities(nativeRtpCapabilities, routerRtpCapabilities);
 
-		MSC_DEBUG("got extended RTP capabilities:\n%s", this->extendedRtpCapabilities.dump(4).c_str());
+		// Just keep the codecs and header extensions allowed by the profile.
+		ortc::applyRtpCapabilitiesProfile(capabilities.extendedRtpCapabilities, rtpCapabilitiesProfile);
+
+		MSC_DEBUG(
+		  "got extended RTP capabilities:\n%s", capabilities.extendedRtpCapabilities.dump(4).c_str());
 
 		// Check whether we can produce audio/video.
-		this->canProduceByKind["audio"] = ortc::canSend("audio", this->extendedRtpCapabilities);
-		this->canProduceByKind["video"] = ortc::canSend("video", this->extendedRtpCapabilities);
+		capabilities.canProduceByKind["audio"] =
+		  ortc::canSend("audio", capabilities.extendedRtpCapabilities);
+		capabilities.canProduceByKind["video"] =
+		  ortc::canSend("video", capabilities.extendedRtpCapabilities);
 
 		// Generate our receiving RTP capabilities for receiving media.
-		this->recvRtpCapabilities = ortc::getRecvRtpCapabilities(this->extendedRtpCapabilities);
+		capabilities.recvRtpCapabilities =
+		  ortc::getRecvRtpCapabilities(capabilities.extendedRtpCapabilities);
 
-		MSC_DEBUG("got receiving RTP capabilities:\n%s", this->recvRtpCapabilities.dump(4).c_str());
+		MSC_DEBUG("got receiving RTP capabilities:\n%s", capabilities.recvRtpCapabilities.dump(4).c_str());
 
 		// This may throw.
-		ortc::validateRtpCapabilities(this->recvRtpCapabilities);
+		ortc::validateRtpCapabilities(capabilities.recvRtpCapabilities);
 
 		// Generate our SCTP capabilities.
-		this->sctpCapabilities = Handler::GetNativeSctpCapabilities();
+		capabilities.sctpCapabilities = Handler::GetNativeSctpCapabilities();
+
+		MSC_DEBUG("got receiving SCTP capabilities:\n%s", capabilities.sctpCapabilities.dump(4).c_str());
+
+		// This may throw.
+		ortc::validateSctpCapabilities(capabilities.sctpCapabilities);
+
+		this->SetCapabilities(std::move(capabilities));
+		this->loadParameters = std::move(loadParameters);
+
+		MSC_DEBUG("succeeded");
+
+		this->loaded = true;
+	}
+
+	/**
+	 * Initialize the Device with the capabilities of the given loaded one,
+	 * sharing them.
+	 */
+	void Device::Load(const Device& loadedDevice)
+	{
+		MSC_TRACE();
+
+		if (this->loaded)
+			MSC_THROW_INVALID_STATE_ERROR("already loaded");
+		else if (!loadedDevice.loaded)
+			MSC_THROW_INVALID_STATE_ERROR("given Device not loaded");
+
+		this->capabilities    = loadedDevice.capabilities;
+		this->loadParameters  = loadedDevice.loadParameters;
+
+		MSC_DEBUG("succeeded");
+
+		this->loaded = true;
+	}
+
+	/**
+	 * Store the capabilities computed by Load() in a compact (CBOR) file.
+	 */
+	void Device::Save(const std::string& path) const
+	{
+		MSC_TRACE();
+
+		if (!this->loaded)
+			MSC_THROW_INVALID_STATE_ERROR("not loaded");
+
+		const auto& loadParameters = *this->loadParameters;
+
+		auto key = getCapabilitiesKey(
+		  loadParameters.at("routerRtpCapabilities"),
+		  loadParameters.at("rtpCapabilitiesProfile"),
+		  loadParameters.at("nativeCodecs"));
+
+		// clang-format off
+		json cache =
+		{
+			{ "key",                     key                                          },
+			{ "extendedRtpCapabilities", this->capabilities->extendedRtpCapabilities  },
+			{ "recvRtpCapabilities",     this->capabilities->recvRtpCapabilities      },
+			{ "sctpCapabilities",        this->capabilities->sctpCapabilities         },
+			{ "canProduceByKind",        this->capabilities->canProduceByKind         }
+		};
+		// clang-format on
+
+		auto data = json::to_cbor(cache);
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+		if (!file)
+			MSC_THROW_ERROR("cannot write file [path:%s]", path.c_str());
+	}
+
+	/**
+	 * Initialize the Device with the capabilities stored by Save(), skipping the
+	 * native RTP capabilities retrieval and their matching.
+	 */
+	bool Device::Restore(
+	  const std::string& path,
+	  json routerRtpCapabilities,
+	  const PeerConnection::Options* peerConnectionOptions,
+	  const json& rtpCapabilitiesProfile)
+	{
+		MSC_TRACE();
 
-		MSC_DEBUG("got receiving SCTP capabilities:\n%s", this->sctpCapabilities.dump(4).c_str());
+		if (this->loaded)
+			MSC_THROW_INVALID_STATE_ERROR("already loaded");
 
 		// This may throw.
-		ortc::validateSctpCapabilities(this->sctpCapabilities);
+		ortc::validateRtpCapabilities(routerRtpCapabilities);
+		ortc::validateRtpCapabilitiesProfile(rtpCapabilitiesProfile);
+
+		std::ifstream file(path, std::ios::binary);
+
+		if (!file)
+			return false;
+
+		std::vector<uint8_t> data(
+		  (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		auto cache = json::from_cbor(data, /*strict*/ true, /*allow_exceptions*/ false);
+
+		if (!cache.is_object())
+		{
+			MSC_WARN("invalid file [path:%s]", path.c_str());
+
+			return false;
+		}
+
+		// No PeerConnection is created for them.
+		auto nativeCodecs = Handler::GetNativeCodecs(peerConnectionOptions);
+		auto key = getCapabilitiesKey(routerRtpCapabilities, rtpCapabilitiesProfile, nativeCodecs);
+
+		if (cache.value("key", "") != key)
+		{
+			MSC_DEBUG("stale file [path:%s]", path.c_str());
+
+			return false;
+		}
+
+		Capabilities capabilities;
+
+		try
+		{
+			capabilities.extendedRtpCapabilities = cache.at("extendedRtpCapabilities");
+			capabilities.recvRtpCapabilities     = cache.at("recvRtpCapabilities");
+			capabilities.sctpCapabilities        = cache.at("sctpCapabilities");
+			capabilities.canProduceByKind =
+			  cache.at("canProduceByKind").get<std::map<std::string, bool>>();
+		}
+		catch (const json::exception& error)
+		{
+			MSC_WARN("invalid file [path:%s]: %s", path.c_str(), error.what());
+
+			return false;
+		}
+
+		try
+		{
+			ortc::validateRtpCapabilities(capabilities.recvRtpCapabilities);
+			ortc::validateSctpCapabilities(capabilities.sctpCapabilities);
+		}
+		catch (const MediaSoupClientError& error)
+		{
+			MSC_WARN("invalid capabilities in file [path:%s]: %s", path.c_str(), error.what());
+
+			return false;
+		}
+
+		this->SetCapabilities(std::move(capabilities));
+		this->loadParameters = getLoadParameters(
+		  std::move(routerRtpCapabilities), rtpCapabilitiesProfile, std::move(nativeCodecs));
 
 		MSC_DEBUG("succeeded");
 
 		this->loaded = true;
+
+		return true;
 	}
 
 	/**
@@ -110,7 +296,71 @@ namespace mediasoupclient
 		else if (kind != "audio" && kind != "video")
 			MSC_THROW_TYPE_ERROR("invalid kind");
 
-		return this->canProduceByKind[kind];
+		return this->capabilities->canProduceByKind.at(kind);
+	}
+
+	/**
+	 * Completes the given capabilities and takes the identical ones already used
+	 * by another Device, if any.
+	 */
+	void Device::SetCapabilities(Capabilities capabilities)
+	{
+		MSC_TRACE();
+
+		// Capabilities used by any Device, indexed by the hash of their extended RTP
+		// capabilities.
+		static std::mutex internedMutex;
+		static std::unordered_multimap<size_t, std::weak_ptr<const Capabilities>> interned;
+
+		auto hash = std::hash<json>{}(capabilities.extendedRtpCapabilities);
+
+		std::lock_guard<std::mutex> lock(internedMutex);
+
+		auto range = interned.equal_range(hash);
+
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			auto internedCapabilities = it->second.lock();
+
+			// Different capabilities may have the same hash.
+			if (
+			  internedCapabilities &&
+			  internedCapabilities->extendedRtpCapabilities == capabilities.extendedRtpCapabilities &&
+			  internedCapabilities->recvRtpCapabilities == capabilities.recvRtpCapabilities &&
+			  internedCapabilities->sctpCapabilities == capabilities.sctpCapabilities)
+			{
+				this->capabilities = std::move(internedCapabilities);
+
+				return;
+			}
+		}
+
+		// clang-format off
+		capabilities.sendingRtpParametersByKind =
+		{
+			{ "audio", ortc::getSendingRtpParameters("audio", capabilities.extendedRtpCapabilities) },
+			{ "video", ortc::getSendingRtpParameters("video", capabilities.extendedRtpCapabilities) }
+		};
+
+		capabilities.sendingRemoteRtpParametersByKind =
+		{
+			{ "audio", ortc::getSendingRemoteRtpParameters("audio", capabilities.extendedRtpCapabilities) },
+			{ "video", ortc::getSendingRemoteRtpParameters("video", capabilities.extendedRtpCapabilities) }
+		};
+		// clang-format on
+
+		// Forget the capabilities no longer used.
+		for (auto it = interned.begin(); it != interned.end();)
+		{
+			if (it->second.expired())
+				it = interned.erase(it);
+			else
+				++it;
+		}
+
+		this->capabilities = std::make_shared<const Capabilities>(std::move(capabilities));
+
+		interned.emplace(hash, this->capabilities);
 	}
 
 	SendTransport* Device::CreateSendTransport(
@@ -147,8 +397,12 @@ namespace mediasoupclient
 		  dtlsParameters,
 		  sctpParameters,
 		  peerConnectionOptions,
-		  &this->extendedRtpCapabilities,
-		  &this->canProduceByKind,
+		  &this->capabilities->extendedRtpCapabilities,
+		  &this->capabilities->canProduceByKind,
+		  // Aliasing pointers keeping the capabilities alive.
+		  std::shared_ptr<const json>(this->capabilities, &this->capabilities->sendingRtpParametersByKind),
+		  std::shared_ptr<const json>(
+		    this->capabilities, &this->capabilities->sendingRemoteRtpParametersByKind),
 		  appData);
 
 		return transport;
@@ -203,7 +457,7 @@ namespace mediasoupclient
 		  dtlsParameters,
 		  sctpParameters,
 		  peerConnectionOptions,
-		  &this->extendedRtpCapabilities,
+		  &this->capabilities->extendedRtpCapabilities,
 		  appData);
 
 		return transport;
@@ -223,4 +477,83 @@ namespace mediasoupclient
 		return Device::CreateRecvTransport(
 		  listener, id, iceParameters, iceCandidates, dtlsParameters, nullptr, peerConnectionOptions, appData);
 	}
+
+	RecvTransport* Device::CreateRecvTransport(
+	  RecvTransport::Listener* listener, SendTransport* sendTransport, const json& appData) const
+	{
+		MSC_TRACE();
+
+		if (!this->loaded)
+			MSC_THROW_INVALID_STATE_ERROR("not loaded");
+		else if (!sendTransport)
+			MSC_THROW_TYPE_ERROR("missing sendTransport");
+		else if (sendTransport->IsClosed())
+			MSC_THROW_INVALID_STATE_ERROR("SendTransport closed");
+		else if (!appData.is_object())
+			MSC_THROW_TYPE_ERROR("appData must be a JSON object");
+
+		// Create a new Transport.
+		auto* transport =
+		  new RecvTransport(listener, sendTransport, &this->capabilities->extendedRtpCapabilities, appData);
+
+		return transport;
+	}
 } // namespace mediasoupclient
+
+// Private helpers used in this file.
+
+/**
+ * Identifies the capabilities computed for the given router RTP capabilities
+ * and profile by this library version with the given native codecs.
+ */
+static std::string getCapabilitiesKey(
+  const json& routerRtpCapabilities, const json& profile, const json& nativeCodecs)
+{
+	std::string data;
+
+	data.append(std::to_string(MEDIASOUPCLIENT_VERSION_MAJOR))
+	  .append(".")
+	  .append(std::to_string(MEDIASOUPCLIENT_VERSION_MINOR))
+	  .append(".")
+	  .append(std::to_string(MEDIASOUPCLIENT_VERSION_PATCH))
+	  .append(routerRtpCapabilities.dump())
+	  .append(profile.dump())
+	  .append(nativeCodecs.dump());
+
+	return getHash(data);
+}
+
+/**
+ * FNV-1a hash, stable across processes.
+ */
+static std::string getHash(const std::string& data)
+{
+	static const uint64_t FnvOffsetBasis{ 14695981039346656037ull };
+	static const uint64_t FnvPrime{ 1099511628211ull };
+
+	uint64_t hash{ FnvOffsetBasis };
+
+	for (auto c : data)
+	{
+		hash ^= static_cast<uint8_t>(c);
+		hash *= FnvPrime;
+	}
+
+	return std::to_string(hash);
+}
+
+/**
+ * What getCapabilitiesKey() needs, kept by the loaded Device until Save().
+ */
+static std::shared_ptr<const json> getLoadParameters(
+  json routerRtpCapabilities, const json& profile, json nativeCodecs)
+{
+	// clang-format off
+	return std::make_shared<const json>(json
+	{
+		{ "routerRtpCapabilities",  std::move(routerRtpCapabilities) },
+		{ "rtpCapabilitiesProfile", profile                          },
+		{ "nativeCodecs",           std::move(nativeCodecs)          }
+	});
+	// clang-format on
+}
@@ -4,38 +4,58 @@
 #include "Logger.hpp"
 #include "MediaSoupClientErrors.hpp"
 #include "PeerConnection.hpp"
+#include "TransportPool.hpp"
 #include "ortc.hpp"
 #include "scalabilityMode.hpp"
 #include "sdptransform.hpp"
 #include "sdp/Utils.hpp"
+#include <algorithm> // std::find, std::remove
 #include <cinttypes> // PRIu64, etc
+#include <limits>    // std::numeric_limits
 
 using json = nlohmann::json;
 
 constexpr uint16_t SctpNumStreamsOs{ 1024u };
 constexpr uint16_t SctpNumStreamsMis{ 1024u };
+// Stream id of the placeholder DataChannel used to negotiate the m=application
+// section, never given to a DataProducer.
+constexpr uint16_t SctpConnectStreamId{ SctpNumStreamsMis - 1 };
 
 json SctpNumStreams = { { "OS", SctpNumStreamsOs }, { "MIS", SctpNumStreamsMis } };
 
 // Static functions declaration.
 static void fillJsonRtpEncodingParameters(
   json& jsonEncoding, const webrtc::RtpEncodingParameters& encoding);
+static void applyJsonRtpEncodingParameters(
+  webrtc::RtpEncodingParameters& encoding, const json& jsonEncoding);
+template<typename T>
+static void rejectPromise(std::promise<T>& promise, const std::exception_ptr& error);
 
 namespace mediasoupclient
 {
 	/* Handler static methods. */
 
-	json Handler::GetNativeRtpCapabilities(const PeerConnection::Options* peerConnectionOptions)
+	json Handler::GetNativeRtpCapabilities(
+	  const PeerConnection::Options* peerConnectionOptions,
+	  const std::vector<std::string>& kinds,
+	  json* nativeCodecs)
 	{
 		MSC_TRACE();
 
 		std::unique_ptr<PeerConnection::PrivateListener> privateListener(
 		  new PeerConnection::PrivateListener());
 		std::unique_ptr<PeerConnection> pc(
-		  new PeerConnection(privateListener.get(), peerConnectionOptions));
+		  PeerConnection::Create(privateListener.get(), peerConnectionOptions));
 
-		(void)pc->AddTransceiver(cricket::MediaType::MEDIA_TYPE_AUDIO);
-		(void)pc->AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO);
+		for (const auto& kind : kinds)
+		{
+			if (kind == "audio")
+				(void)pc->AddTransceiver(cricket::MediaType::MEDIA_TYPE_AUDIO);
+			else if (kind == "video")
+				(void)pc->AddTransceiver(cricket::MediaType::MEDIA_TYPE_VIDEO);
+			else
+				MSC_THROW_TYPE_ERROR("invalid kind");
+		}
 
 		webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
 
@@ -44,6 +64,9 @@ namespace mediasoupclient
 		auto sdpObject             = sdptransform::parse(offer);
 		auto nativeRtpCapabilities = Sdp::Utils::extractRtpCapabilities(sdpObject);
 
+		if (nativeCodecs)
+			*nativeCodecs = pc->GetNativeCodecs();
+
 		return nativeRtpCapabilities;
 	}
 
@@ -56,6 +79,13 @@ namespace mediasoupclient
 		return caps;
 	}
 
+	json Handler::GetNativeCodecs(const PeerConnection::Options* peerConnectionOptions)
+	{
+		MSC_TRACE();
+
+		return PeerConnection::GetNativeCodecs(peerConnectionOptions);
+	}
+
 	/* Handler instance methods. */
 
 	Handler::Handler(
@@ -65,7 +95,7 @@ namespace mediasoupclient
 	  const json& dtlsParameters,
 	  const json& sctpParameters,
 	  const PeerConnection::Options* peerConnectionOptions)
-	  : privateListener(privateListener)
+	  : privateListener(privateListener), hasSctpParameters(sctpParameters.is_object())
 	{
 		MSC_TRACE();
 
@@ -75,16 +105,96 @@ namespace mediasoupclient
 			  dtlsParameters["role"].get<std::string>() == "server" ? "client" : "server";
 		}
 
-		this->pc.reset(new PeerConnection(this, peerConnectionOptions));
+		this->session = std::make_shared<Session>();
+		this->session->AddHandler(this);
+
+		// Take a pre-created PeerConnection if a TransportPool is given.
+		if (peerConnectionOptions != nullptr && peerConnectionOptions->transportPool != nullptr)
+		{
+			this->pc =
+			  peerConnectionOptions->transportPool->Acquire(this->session.get(), peerConnectionOptions);
+		}
+
+		if (!this->pc)
+			this->pc.reset(PeerConnection::Create(this->session.get(), peerConnectionOptions));
 
 		this->remoteSdp.reset(
 		  new Sdp::RemoteSdp(iceParameters, iceCandidates, dtlsParameters, sctpParameters));
+
+		if (peerConnectionOptions != nullptr && peerConnectionOptions->compactRemoteSdp)
+			this->remoteSdp->SetCompact();
 	};
 
+	Handler::Handler(PrivateListener* privateListener, Handler* handler)
+	  : privateListener(privateListener), session(handler->session), remoteSdp(handler->remoteSdp),
+	    pc(handler->pc), hasSctpParameters(handler->hasSctpParameters),
+	    forcedLocalDtlsRole(handler->forcedLocalDtlsRole)
+	{
+		MSC_TRACE();
+
+		this->session->AddHandler(this);
+
+		// Both Handlers negotiate over the same remote SDP.
+		this->remoteSdp->SetMixedRoles();
+	}
+
+	Handler::~Handler()
+	{
+		MSC_TRACE();
+
+		this->session->RemoveHandler(this);
+	}
+
 	void Handler::Close()
 	{
 		MSC_TRACE();
 
+		// Keep the PeerConnection while other Handlers use it, but close the
+		// m-sections of this one.
+		if (this->session->RemoveHandler(this) != 0u)
+		{
+			std::vector<std::string> localIds;
+
+			{
+				std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
+
+				for (const auto& kv : this->mapMidTransceiver)
+				{
+					const auto& localId = kv.first;
+					auto* transceiver   = kv.second;
+
+					// Skip the already stopped transceivers, whose m-section may have been
+					// reused by the other Handler.
+					if (
+					  transceiver->stopped() ||
+					  transceiver->direction() == webrtc::RtpTransceiverDirection::kInactive ||
+					  !this->remoteSdp->HasMediaSection(localId))
+					{
+						continue;
+					}
+
+					localIds.push_back(localId);
+				}
+			}
+
+			if (!localIds.empty())
+			{
+				try
+				{
+					// Negotiates under negotiationMutex.
+					this->StopTransceivers(localIds);
+				}
+				catch (const std::exception& error)
+				{
+					MSC_WARN("failed to close the media sections: %s", error.what());
+				}
+			}
+
+			this->mapMidTransceiver.clear();
+
+			return;
+		}
+
 		// Clear the stored transceivers before closing the PeerConnection.
 		this->mapMidTransceiver.clear();
 
@@ -127,242 +237,271 @@ namespace mediasoupclient
 		return this->privateListener->OnConnectionStateChange(newState);
 	}
 
-	void Handler::SetupTransport(const std::string& localDtlsRole, json& localSdpObject)
+	/* Handler::Session instance methods. */
+
+	void Handler::Session::AddHandler(Handler* handler)
 	{
 		MSC_TRACE();
 
-		if (localSdpObject.empty())
-			localSdpObject = sdptransform::parse(this->pc->GetLocalDescription());
-
-		// Get our local DTLS parameters.
-		auto dtlsParameters = Sdp::Utils::extractDtlsParameters(localSdpObject);
-
-		// Set our DTLS role.
-		dtlsParameters["role"] = localDtlsRole;
-
-		// Update the remote DTLS role in the SDP.
-		std::string remoteDtlsRole = localDtlsRole == "client" ? "server" : "client";
-		this->remoteSdp->UpdateDtlsRole(remoteDtlsRole);
-
-		// May throw.
-		this->privateListener->OnConnect(dtlsParameters);
-		this->transportReady = true;
-	};
+		std::lock_guard<std::mutex> lock(this->handlersMutex);
 
-	/* SendHandler instance methods. */
+		this->handlers.push_back(handler);
+	}
 
-	SendHandler::SendHandler(
-	  Handler::PrivateListener* privateListener,
-	  const json& iceParameters,
-	  const json& iceCandidates,
-	  const json& dtlsParameters,
-	  const json& sctpParameters,
-	  const PeerConnection::Options* peerConnectionOptions,
-	  const json& sendingRtpParametersByKind,
-	  const json& sendingRemoteRtpParametersByKind)
-	  : Handler(
-	      privateListener, iceParameters, iceCandidates, dtlsParameters, sctpParameters, peerConnectionOptions)
+	size_t Handler::Session::RemoveHandler(Handler* handler)
 	{
 		MSC_TRACE();
 
-		this->sendingRtpParametersByKind = sendingRtpParametersByKind;
+		std::lock_guard<std::mutex> lock(this->handlersMutex);
 
-		this->sendingRemoteRtpParametersByKind = sendingRemoteRtpParametersByKind;
-	};
+		this->handlers.erase(
+		  std::remove(this->handlers.begin(), this->handlers.end(), handler), this->handlers.end());
 
-	SendHandler::SendResult SendHandler::Send(
-	  webrtc::MediaStreamTrackInterface* track,
-	  std::vector<webrtc::RtpEncodingParameters>* encodings,
-	  const json* codecOptions,
-	  const json* codec)
+		return this->handlers.size();
+	}
+
+	void Handler::Session::OnIceConnectionChange(
+	  webrtc::PeerConnectionInterface::IceConnectionState newState)
 	{
 		MSC_TRACE();
 
-		// Check if the track is a null pointer.
-		if (!track)
-			MSC_THROW_TYPE_ERROR("missing track");
+		std::vector<Handler*> handlers;
 
-		MSC_DEBUG("[kind:%s, track->id():%s]", track->kind().c_str(), track->id().c_str());
+		{
+			std::lock_guard<std::mutex> lock(this->handlersMutex);
+
+			handlers = this->handlers;
+		}
 
-		if (encodings && encodings->size() > 1)
+		// Dispatch without the lock so the listeners can close their transport.
+		for (auto* handler : handlers)
 		{
-			uint8_t idx = 0;
-			for (webrtc::RtpEncodingParameters& encoding : *encodings)
 			{
-				encoding.rid = std::string("r").append(std::to_string(idx++));
+				std::lock_guard<std::mutex> lock(this->handlersMutex);
+
+				// Skip the Handlers closed meanwhile.
+				auto it = std::find(this->handlers.begin(), this->handlers.end(), handler);
+
+				if (it == this->handlers.end())
+					continue;
 			}
-		}
 
-		json sendingRtpParameters = this->sendingRtpParametersByKind[track->kind()];
+			handler->OnIceConnectionChange(newState);
+		}
+	}
 
-		// This may throw.
-		sendingRtpParameters["codecs"] = ortc::reduceCodecs(sendingRtpParameters["codecs"], codec);
+	void Handler::Session::OnTrack(rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver)
+	{
+		MSC_TRACE();
 
-		json sendingRemoteRtpParameters = this->sendingRemoteRtpParametersByKind[track->kind()];
+		auto mid = transceiver->mid();
 
-		// This may throw.
-		sendingRemoteRtpParameters["codecs"] =
-		  ortc::reduceCodecs(sendingRemoteRtpParameters["codecs"], codec);
+		if (!mid.has_value())
+			return;
 
-		const Sdp::RemoteSdp::MediaSectionIdx mediaSectionIdx = this->remoteSdp->GetNextMediaSectionIdx();
+		std::lock_guard<std::mutex> lock(this->receivingTransceiversMutex);
 
-		webrtc::RtpTransceiverInit transceiverInit;
-		transceiverInit.direction = webrtc::RtpTransceiverDirection::kSendOnly;
+		this->receivingTransceivers[mid.value()] = std::move(transceiver);
+	}
 
-		if (encodings && !encodings->empty())
-			transceiverInit.send_encodings = *encodings;
+	rtc::scoped_refptr<webrtc::RtpTransceiverInterface> Handler::Session::TakeReceivingTransceiver(
+	  const std::string& mid)
+	{
+		MSC_TRACE();
 
-		webrtc::RtpTransceiverInterface* transceiver = this->pc->AddTransceiver(track, transceiverInit);
+		std::lock_guard<std::mutex> lock(this->receivingTransceiversMutex);
 
-		if (!transceiver)
-			MSC_THROW_ERROR("error creating transceiver");
+		auto it = this->receivingTransceivers.find(mid);
 
-		std::string offer;
-		std::string localId;
+		if (it == this->receivingTransceivers.end())
+			return nullptr;
 
-		// Special case for VP9 with SVC.
-		bool hackVp9Svc = false;
+		auto transceiver = std::move(it->second);
 
-		try
-		{
-			webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+		this->receivingTransceivers.erase(it);
 
-			offer               = this->pc->CreateOffer(options);
-			auto localSdpObject = sdptransform::parse(offer);
+		return transceiver;
+	}
 
-			// Transport is not ready.
-			if (!this->transportReady)
-				this->SetupTransport(
-				  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "server", localSdpObject);
+	bool Handler::Session::IsSctpStreamIdInUse(uint16_t streamId) const
+	{
+		MSC_TRACE();
 
-			std::string scalability_mode =
-			  encodings && encodings->size()
-			    ? ((*encodings)[0].scalability_mode.has_value() ? (*encodings)[0].scalability_mode.value()
-			                                                    : "")
-			    : "";
+		auto it = this->dataChannels.find(streamId);
 
-			const json& layers = parseScalabilityMode(scalability_mode);
+		if (it == this->dataChannels.end())
+			return false;
 
-			auto spatialLayers = layers["spatialLayers"].get<int>();
+		auto state = it->second->state();
 
-			auto mimeType = sendingRtpParameters["codecs"][0]["mimeType"].get<std::string>();
+		return state == webrtc::DataChannelInterface::kConnecting ||
+		       state == webrtc::DataChannelInterface::kOpen;
+	}
 
-			std::transform(mimeType.begin(), mimeType.end(), mimeType.begin(), ::tolower);
+	void Handler::SetupTransport(const std::string& localDtlsRole, const Sdp::LocalSdp& localSdp)
+	{
+		MSC_TRACE();
 
-			if (encodings && encodings->size() == 1 && spatialLayers > 1 && mimeType == "video/vp9")
-			{
-				MSC_DEBUG("send() | enabling legacy simulcast for VP9 SVC");
+		// Get our local DTLS parameters.
+		auto dtlsParameters = localSdp.ExtractDtlsParameters();
 
-				hackVp9Svc             = true;
-				localSdpObject         = sdptransform::parse(offer);
-				json& offerMediaObject = localSdpObject["media"][mediaSectionIdx.idx];
+		// Set our DTLS role.
+		dtlsParameters["role"] = localDtlsRole;
 
-				Sdp::Utils::addLegacySimulcast(offerMediaObject, spatialLayers);
+		// Update the remote DTLS role in the SDP.
+		std::string remoteDtlsRole = localDtlsRole == "client" ? "server" : "client";
+		this->remoteSdp->UpdateDtlsRole(remoteDtlsRole);
 
-				offer = sdptransform::write(localSdpObject);
-			}
+		// May throw.
+		this->privateListener->OnConnect(dtlsParameters);
+		this->session->transportReady = true;
+	};
 
-			MSC_DEBUG("calling pc->SetLocalDescription():\n%s", offer.c_str());
+	void Handler::ProcessPendingOperations()
+	{
+		MSC_TRACE();
 
-			this->pc->SetLocalDescription(PeerConnection::SdpType::OFFER, offer);
+		{
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
 
-			// We can now get the transceiver.mid.
-			localId = transceiver->mid().value();
+			// The negotiating thread will take the new operations.
+			if (this->negotiating)
+				return;
 
-			// Set MID.
-			sendingRtpParameters["mid"] = localId;
+			this->negotiating = true;
 		}
-		catch (std::exception& error)
+
+		while (true)
 		{
-			// Panic here. Try to undo things.
-			transceiver->SetDirectionWithError(webrtc::RtpTransceiverDirection::kInactive);
-			transceiver->sender()->SetTrack(nullptr);
+			{
+				std::lock_guard<std::mutex> lock(this->pendingMutex);
 
-			throw;
-		}
+				if (!HasPendingOperations())
+				{
+					this->negotiating = false;
+
+					return;
+				}
+			}
+
+			try
+			{
+				std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
 
-		auto localSdp       = this->pc->GetLocalDescription();
-		auto localSdpObject = sdptransform::parse(localSdp);
+				NegotiatePendingOperations();
+			}
+			catch (...)
+			{
+				{
+					std::lock_guard<std::mutex> lock(this->pendingMutex);
 
-		json& offerMediaObject = localSdpObject["media"][mediaSectionIdx.idx];
+					// The callers of the operations queued meanwhile are waiting for them
+					// and nobody else may come to negotiate them.
+					RejectPendingOperations(std::current_exception());
 
-		// Set RTCP CNAME.
-		sendingRtpParameters["rtcp"]["cname"] = Sdp::Utils::getCname(offerMediaObject);
+					this->negotiating = false;
+				}
 
-		// Set RTP encodings by parsing the SDP offer if no encodings are given.
-		if (encodings == nullptr || encodings->empty())
-		{
-			sendingRtpParameters["encodings"] = Sdp::Utils::getRtpEncodings(offerMediaObject);
+				throw;
+			}
 		}
-		// Set RTP encodings by parsing the SDP offer and complete them with given
-		// one if just a single encoding has been given.
-		else if (encodings->size() == 1)
-		{
-			auto newEncodings = Sdp::Utils::getRtpEncodings(offerMediaObject);
+	}
 
-			fillJsonRtpEncodingParameters(newEncodings.front(), encodings->front());
+	/* SendHandler instance methods. */
 
-			// Hack for VP9 SVC.
-			if (hackVp9Svc)
-				newEncodings = json::array({ newEncodings[0] });
+	SendHandler::SendHandler(
+	  Handler::PrivateListener* privateListener,
+	  const json& iceParameters,
+	  const json& iceCandidates,
+	  const json& dtlsParameters,
+	  const json& sctpParameters,
+	  const PeerConnection::Options* peerConnectionOptions,
+	  const json& sendingRtpParametersByKind,
+	  const json& sendingRemoteRtpParametersByKind)
+	  : SendHandler(
+	      privateListener,
+	      iceParameters,
+	      iceCandidates,
+	      dtlsParameters,
+	      sctpParameters,
+	      peerConnectionOptions,
+	      std::make_shared<const json>(sendingRtpParametersByKind),
+	      std::make_shared<const json>(sendingRemoteRtpParametersByKind))
+	{
+		MSC_TRACE();
+	};
 
-			sendingRtpParameters["encodings"] = newEncodings;
-		}
-		// Otherwise if more than 1 encoding are given use them verbatim.
-		else
-		{
-			sendingRtpParameters["encodings"] = json::array();
+	SendHandler::SendHandler(
+	  Handler::PrivateListener* privateListener,
+	  const json& iceParameters,
+	  const json& iceCandidates,
+	  const json& dtlsParameters,
+	  const json& sctpParameters,
+	  const PeerConnection::Options* peerConnectionOptions,
+	  std::shared_ptr<const json> sendingRtpParametersByKind,
+	  std::shared_ptr<const json> sendingRemoteRtpParametersByKind)
+	  : Handler(
+	      privateListener, iceParameters, iceCandidates, dtlsParameters, sctpParameters, peerConnectionOptions),
+	    sendingRtpParametersByKind(std::move(sendingRtpParametersByKind)),
+	    sendingRemoteRtpParametersByKind(std::move(sendingRemoteRtpParametersByKind))
+	{
+		MSC_TRACE();
+	};
 
-			for (const auto& encoding : *encodings)
-			{
-				json jsonEncoding = {};
+	SendHandler::SendResult SendHandler::Send(
+	  webrtc::MediaStreamTrackInterface* track,
+	  std::vector<webrtc::RtpEncodingParameters>* encodings,
+	  const json* codecOptions,
+	  const json* codec)
+	{
+		MSC_TRACE();
 
-				fillJsonRtpEncodingParameters(jsonEncoding, encoding);
-				sendingRtpParameters["encodings"].push_back(jsonEncoding);
-			}
-		}
+		// May throw.
+		return SendAsync(track, encodings, codecOptions, codec).get();
+	}
+
+	/**
+	 * Queues the track to be sent in the next negotiation. The future is
+	 * fulfilled once such a negotiation is done.
+	 */
+	std::future<SendHandler::SendResult> SendHandler::SendAsync(
+	  webrtc::MediaStreamTrackInterface* track,
+	  const std::vector<webrtc::RtpEncodingParameters>* encodings,
+	  const json* codecOptions,
+	  const json* codec)
+	{
+		MSC_TRACE();
 
-		// If VP8 and there is effective simulcast, add scalabilityMode to each encoding.
-		auto mimeType = sendingRtpParameters["codecs"][0]["mimeType"].get<std::string>();
+		// Check if the track is a null pointer.
+		if (!track)
+			MSC_THROW_TYPE_ERROR("missing track");
 
-		std::transform(mimeType.begin(), mimeType.end(), mimeType.begin(), ::tolower);
+		MSC_DEBUG("[kind:%s, track->id():%s]", track->kind().c_str(), track->id().c_str());
 
-		// clang-format off
-		if (
-			sendingRtpParameters["encodings"].size() > 1 &&
-			(mimeType == "video/vp8" || mimeType == "video/h264")
-		)
-		// clang-format on
-		{
-			for (auto& encoding : sendingRtpParameters["encodings"])
-			{
-				encoding["scalabilityMode"] = "S1T3";
-			}
-		}
+		PendingSend pendingSend;
 
-		this->remoteSdp->Send(
-		  offerMediaObject,
-		  mediaSectionIdx.reuseMid,
-		  sendingRtpParameters,
-		  sendingRemoteRtpParameters,
-		  codecOptions);
+		pendingSend.track = track;
 
-		auto answer = this->remoteSdp->GetSdp();
+		if (encodings)
+			pendingSend.encodings = *encodings;
 
-		MSC_DEBUG("calling pc->SetRemoteDescription():\n%s", answer.c_str());
+		if (codecOptions)
+			pendingSend.codecOptions = *codecOptions;
 
-		this->pc->SetRemoteDescription(PeerConnection::SdpType::ANSWER, answer);
+		if (codec)
+			pendingSend.codec = *codec;
+
+		auto future = pendingSend.promise.get_future();
 
-		// Store in the map.
-		this->mapMidTransceiver[localId] = transceiver;
+		{
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
 
-		SendResult sendResult;
+			this->pendingSends.push_back(std::move(pendingSend));
+		}
 
-		sendResult.localId       = localId;
-		sendResult.rtpSender     = transceiver->sender();
-		sendResult.rtpParameters = sendingRtpParameters;
+		ProcessPendingOperations();
 
-		return sendResult;
+		return future;
 	}
 
 	Handler::DataChannel SendHandler::SendDataChannel(
@@ -370,8 +509,20 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
+
 		uint16_t streamId = this->nextSendSctpStreamId;
 
+		// Skip the stream ids taken by open DataChannels, such as the ones the server
+		// assigned to the DataConsumers of a RecvTransport sharing this PeerConnection.
+		for (uint16_t skipped{ 0u }; this->session->IsSctpStreamIdInUse(streamId); ++skipped)
+		{
+			if (skipped == SctpConnectStreamId)
+				MSC_THROW_ERROR("no SCTP stream id available");
+
+			streamId = (streamId + 1) % SctpConnectStreamId;
+		}
+
 		dataChannelInit.negotiated = true;
 		dataChannelInit.id         = streamId;
 
@@ -400,102 +551,544 @@ namespace mediasoupclient
 		rtc::scoped_refptr<webrtc::DataChannelInterface> webrtcDataChannel =
 		  this->pc->CreateDataChannel(label, &dataChannelInit);
 
+		this->session->dataChannels[streamId] = webrtcDataChannel;
+
 		// Increase next id.
-		this->nextSendSctpStreamId = (this->nextSendSctpStreamId + 1) % SctpNumStreamsMis;
+		this->nextSendSctpStreamId = (streamId + 1) % SctpConnectStreamId;
 
 		// If this is the first DataChannel we need to create the SDP answer with
 		// m=application section.
-		if (!this->hasDataChannelMediaSection)
-		{
-			webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
-			std::string offer   = this->pc->CreateOffer(options);
-			auto localSdpObject = sdptransform::parse(offer);
-			const Sdp::RemoteSdp::MediaSectionIdx mediaSectionIdx =
-			  this->remoteSdp->GetNextMediaSectionIdx();
+		if (!this->session->hasDataChannelMediaSection)
+			this->SendSctpAssociation();
 
-			auto offerMediaObject =
-			  find_if(localSdpObject["media"].begin(), localSdpObject["media"].end(), [](const json& m) {
-				  return m.at("type").get<std::string>() == "application";
-			  });
+		SendHandler::DataChannel dataChannel;
 
-			if (offerMediaObject == localSdpObject["media"].end())
-			{
-				MSC_THROW_ERROR("Missing 'application' media section in SDP offer");
-			}
+		dataChannel.dataChannel          = webrtcDataChannel;
+		dataChannel.sctpStreamParameters = sctpStreamParameters;
 
-			if (!this->transportReady)
-			{
-				this->SetupTransport(
-				  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "server", localSdpObject);
-			}
+		return dataChannel;
+	}
 
-			MSC_DEBUG("calling pc.setLocalDescription() [offer:%s]", offer.c_str());
+	/**
+	 * Negotiates the m=application section so ICE and DTLS start before the first
+	 * Producer or DataProducer is created.
+	 */
+	void SendHandler::Connect()
+	{
+		MSC_TRACE();
 
-			this->pc->SetLocalDescription(PeerConnection::SdpType::OFFER, offer);
-			this->remoteSdp->SendSctpAssociation(*offerMediaObject);
+		// The flags are set by any Handler of the session within a negotiation.
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
 
-			auto sdpAnswer = this->remoteSdp->GetSdp();
+		if (this->session->transportReady || this->session->hasDataChannelMediaSection)
+			return;
 
-			MSC_DEBUG("calling pc.setRemoteDescription() [answer:%s]", sdpAnswer.c_str());
+		if (!this->hasSctpParameters)
+			MSC_THROW_UNSUPPORTED_ERROR("cannot connect without SctpParameters");
 
-			this->pc->SetRemoteDescription(PeerConnection::SdpType::ANSWER, sdpAnswer);
-			this->hasDataChannelMediaSection = true;
-		}
+		// A local DataChannel is needed for the SDP offer to contain the
+		// m=application section. It takes a stream id never given to DataProducers
+		// and it is not used afterwards.
+		webrtc::DataChannelInit dataChannelInit;
 
-		SendHandler::DataChannel dataChannel;
+		dataChannelInit.negotiated = true;
+		dataChannelInit.id         = SctpConnectStreamId;
 
-		dataChannel.dataChannel          = webrtcDataChannel;
-		dataChannel.sctpStreamParameters = sctpStreamParameters;
+		auto webrtcDataChannel = this->pc->CreateDataChannel("", &dataChannelInit);
 
-		return dataChannel;
+		try
+		{
+			// May throw.
+			this->SendSctpAssociation();
+		}
+		catch (...)
+		{
+			webrtcDataChannel->Close();
+
+			throw;
+		}
+
+		webrtcDataChannel->Close();
 	}
 
-	void SendHandler::StopSending(const std::string& localId)
+	void SendHandler::SendSctpAssociation()
 	{
 		MSC_TRACE();
 
-		MSC_DEBUG("[localId:%s]", localId.c_str());
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
 
-		auto locaIdIt = this->mapMidTransceiver.find(localId);
+		webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+		Sdp::LocalSdp localSdp(this->pc->CreateOffer(options));
 
-		if (locaIdIt == this->mapMidTransceiver.end())
-			MSC_THROW_ERROR("associated RtpTransceiver not found");
+		size_t applicationIdx{ 0u };
 
-		auto* transceiver = locaIdIt->second;
+		while (applicationIdx < localSdp.GetMediaSectionCount() &&
+		       localSdp.GetMediaType(applicationIdx) != "application")
+		{
+			++applicationIdx;
+		}
 
-		transceiver->sender()->SetTrack(nullptr);
-		this->pc->RemoveTrack(transceiver->sender());
-		this->remoteSdp->CloseMediaSection(transceiver->mid().value());
+		if (applicationIdx == localSdp.GetMediaSectionCount())
+		{
+			MSC_THROW_ERROR("Missing 'application' media section in SDP offer");
+		}
 
-		// May throw.
-		webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+		auto offerMediaObject = localSdp.ParseMediaSection(applicationIdx);
 
-		auto offer = this->pc->CreateOffer(options);
+		if (!this->session->transportReady)
+		{
+			this->SetupTransport(
+			  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "server", localSdp);
+		}
 
-		MSC_DEBUG("calling pc->SetLocalDescription():\n%s", offer.c_str());
+		const auto& offer = localSdp.GetSdp();
+
+		MSC_DEBUG("calling pc.setLocalDescription() [offer:%s]", offer.c_str());
 
-		// May throw.
 		this->pc->SetLocalDescription(PeerConnection::SdpType::OFFER, offer);
+		this->remoteSdp->SendSctpAssociation(offerMediaObject);
 
-		auto localSdpObj = sdptransform::parse(this->pc->GetLocalDescription());
-		auto answer      = this->remoteSdp->GetSdp();
+		auto sdpAnswer = this->remoteSdp->GetSdp();
 
-		MSC_DEBUG("calling pc->SetRemoteDescription():\n%s", answer.c_str());
+		MSC_DEBUG("calling pc.setRemoteDescription() [answer:%s]", sdpAnswer.c_str());
 
-		// May throw.
-		this->pc->SetRemoteDescription(PeerConnection::SdpType::ANSWER, answer);
+		this->pc->SetRemoteDescription(PeerConnection::SdpType::ANSWER, sdpAnswer);
+		this->session->hasDataChannelMediaSection = true;
 	}
 
-	void SendHandler::ReplaceTrack(const std::string& localId, webrtc::MediaStreamTrackInterface* track)
+	void SendHandler::StopSending(const std::string& localId)
 	{
 		MSC_TRACE();
 
-		MSC_DEBUG(
-		  "[localId:%s, track->id():%s]",
-		  localId.c_str(),
-		  track == nullptr ? "nullptr" : track->id().c_str());
+		MSC_DEBUG("[localId:%s]", localId.c_str());
 
-		auto localIdIt = this->mapMidTransceiver.find(localId);
+		StopSending(std::vector<std::string>{ localId });
+	}
+
+	/**
+	 * Stops sending the given tracks and closes their m-sections within a single
+	 * SDP negotiation.
+	 */
+	void SendHandler::StopSending(const std::vector<std::string>& localIds)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG("[localIds:%zu]", localIds.size());
+
+		std::vector<std::future<void>> futures;
+
+		{
+			std::lock_guard<std::recursive_mutex> negotiationLock(this->session->negotiationMutex);
+
+			// Check them all before touching anything.
+			for (const auto& localId : localIds)
+			{
+				if (this->mapMidTransceiver.find(localId) == this->mapMidTransceiver.end())
+					MSC_THROW_ERROR("associated RtpTransceiver not found");
+			}
+
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
+
+			for (const auto& localId : localIds)
+			{
+				PendingStop pendingStop;
+
+				pendingStop.localId = localId;
+				futures.push_back(pendingStop.promise.get_future());
+
+				this->pendingStops.push_back(std::move(pendingStop));
+			}
+		}
+
+		ProcessPendingOperations();
+
+		for (auto& future : futures)
+		{
+			// May throw.
+			future.get();
+		}
+	}
+
+	/**
+	 * Queues the track to stop being sent in the next negotiation. The future is
+	 * fulfilled once such a negotiation is done.
+	 */
+	std::future<void> SendHandler::StopSendingAsync(const std::string& localId)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG("[localId:%s]", localId.c_str());
+
+		PendingStop pendingStop;
+
+		pendingStop.localId = localId;
+
+		auto future = pendingStop.promise.get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
+
+			this->pendingStops.push_back(std::move(pendingStop));
+		}
+
+		ProcessPendingOperations();
+
+		return future;
+	}
+
+	void SendHandler::StopTransceivers(const std::vector<std::string>& localIds)
+	{
+		MSC_TRACE();
+
+		this->StopSending(localIds);
+	}
+
+	bool SendHandler::HasPendingOperations() const
+	{
+		MSC_TRACE();
+
+		return !this->pendingSends.empty() || !this->pendingStops.empty();
+	}
+
+	void SendHandler::RejectPendingOperations(const std::exception_ptr& error)
+	{
+		MSC_TRACE();
+
+		for (auto& pendingSend : this->pendingSends)
+		{
+			rejectPromise(pendingSend.promise, error);
+		}
+
+		for (auto& pendingStop : this->pendingStops)
+		{
+			rejectPromise(pendingStop.promise, error);
+		}
+
+		this->pendingSends.clear();
+		this->pendingStops.clear();
+	}
+
+	/**
+	 * Adds the transceivers of the queued tracks and removes those of the
+	 * stopped ones, then does a single offer/answer exchange. Errors affecting a
+	 * single operation are reported in its future only.
+	 */
+	void SendHandler::NegotiatePendingOperations()
+	{
+		MSC_TRACE();
+
+		struct Sending
+		{
+			PendingSend* pendingSend;
+			webrtc::RtpTransceiverInterface* transceiver;
+			Sdp::RemoteSdp::MediaSectionIdx mediaSectionIdx;
+			json sendingRtpParameters;
+			json sendingRemoteRtpParameters;
+			// Special case for VP9 with SVC.
+			bool hackVp9Svc;
+			// Its m-section in the local offer.
+			json offerMediaObject;
+		};
+
+		std::vector<PendingSend> sends;
+		std::vector<PendingStop> stops;
+
+		{
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
+
+			sends.swap(this->pendingSends);
+			stops.swap(this->pendingStops);
+		}
+
+		MSC_DEBUG("[sends:%zu, stops:%zu]", sends.size(), stops.size());
+
+		std::vector<Sending> sendings;
+		std::vector<PendingStop*> stoppings;
+		std::vector<std::string> stoppingMids;
+
+		// Every queued operation taken is fulfilled or rejected, whatever fails.
+		try
+		{
+			for (auto& pendingSend : sends)
+			{
+				try
+				{
+					auto kind       = pendingSend.track->kind();
+					auto& encodings = pendingSend.encodings;
+
+					if (encodings.size() > 1)
+					{
+						uint8_t idx = 0;
+						for (webrtc::RtpEncodingParameters& encoding : encodings)
+						{
+							encoding.rid = std::string("r").append(std::to_string(idx++));
+						}
+					}
+
+					json sendingRtpParameters = this->sendingRtpParametersByKind->at(kind);
+
+					// This may throw.
+					sendingRtpParameters["codecs"] =
+					  ortc::reduceCodecs(sendingRtpParameters["codecs"], &pendingSend.codec);
+
+					json sendingRemoteRtpParameters = this->sendingRemoteRtpParametersByKind->at(kind);
+
+					// This may throw.
+					sendingRemoteRtpParameters["codecs"] =
+					  ortc::reduceCodecs(sendingRemoteRtpParameters["codecs"], &pendingSend.codec);
+
+					// New m-sections recycle the closed ones in order, as libwebrtc does, so
+					// skip those taken by the previous tracks in this negotiation.
+					const Sdp::RemoteSdp::MediaSectionIdx mediaSectionIdx =
+					  this->remoteSdp->GetNextMediaSectionIdx(sendings.size());
+
+					webrtc::RtpTransceiverInit transceiverInit;
+					transceiverInit.direction = webrtc::RtpTransceiverDirection::kSendOnly;
+
+					if (!encodings.empty())
+						transceiverInit.send_encodings = encodings;
+
+					webrtc::RtpTransceiverInterface* transceiver =
+					  this->pc->AddTransceiver(pendingSend.track, transceiverInit);
+
+					if (!transceiver)
+						MSC_THROW_ERROR("error creating transceiver");
+
+					sendings.push_back({ &pendingSend,
+					                     transceiver,
+					                     mediaSectionIdx,
+					                     sendingRtpParameters,
+					                     sendingRemoteRtpParameters,
+					                     false,
+					                     json() });
+				}
+				catch (...)
+				{
+					pendingSend.promise.set_exception(std::current_exception());
+				}
+			}
+
+			for (auto& pendingStop : stops)
+			{
+				auto localIdIt = this->mapMidTransceiver.find(pendingStop.localId);
+
+				if (localIdIt == this->mapMidTransceiver.end())
+				{
+					pendingStop.promise.set_exception(
+					  std::make_exception_ptr(MediaSoupClientError("associated RtpTransceiver not found")));
+
+					continue;
+				}
+
+				auto* transceiver = localIdIt->second;
+
+				transceiver->sender()->SetTrack(nullptr);
+				this->pc->RemoveTrack(transceiver->sender());
+				this->mapMidPausedEncodingsActive.erase(pendingStop.localId);
+
+				stoppings.push_back(&pendingStop);
+				stoppingMids.push_back(transceiver->mid().value());
+			}
+
+			if (sendings.empty() && stoppings.empty())
+				return;
+
+			webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+
+			// May throw.
+			Sdp::LocalSdp localSdp(this->pc->CreateOffer(options));
+
+			// Transport is not ready.
+			if (!sendings.empty() && !this->session->transportReady)
+				this->SetupTransport(
+				  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "server", localSdp);
+
+			for (auto& sending : sendings)
+			{
+				// Just the m-sections of the new tracks are parsed. The offer becomes
+				// the local description, so there is no need to read it again later.
+				sending.offerMediaObject = localSdp.ParseMediaSection(sending.mediaSectionIdx.idx);
+
+				const auto& encodings = sending.pendingSend->encodings;
+
+				std::string scalability_mode =
+				  !encodings.empty() && encodings[0].scalability_mode.has_value()
+				    ? encodings[0].scalability_mode.value()
+				    : "";
+
+				const json& layers = parseScalabilityMode(scalability_mode);
+
+				auto spatialLayers = layers["spatialLayers"].get<int>();
+
+				auto mimeType = sending.sendingRtpParameters["codecs"][0]["mimeType"].get<std::string>();
+
+				std::transform(mimeType.begin(), mimeType.end(), mimeType.begin(), ::tolower);
+
+				if (encodings.size() == 1 && spatialLayers > 1 && mimeType == "video/vp9")
+				{
+					MSC_DEBUG("send() | enabling legacy simulcast for VP9 SVC");
+
+					sending.hackVp9Svc = true;
+
+					Sdp::Utils::addLegacySimulcast(sending.offerMediaObject, spatialLayers);
+					localSdp.SetMediaSection(sending.mediaSectionIdx.idx, sending.offerMediaObject);
+				}
+			}
+
+			const auto& offer = localSdp.GetSdp();
+
+			MSC_DEBUG("calling pc->SetLocalDescription():\n%s", offer.c_str());
+
+			// May throw.
+			this->pc->SetLocalDescription(PeerConnection::SdpType::OFFER, offer);
+
+			for (auto& sending : sendings)
+			{
+				const auto& encodings      = sending.pendingSend->encodings;
+				auto& sendingRtpParameters = sending.sendingRtpParameters;
+
+				// We can now get the transceiver.mid.
+				auto localId = sending.transceiver->mid().value();
+
+				// Set MID.
+				sendingRtpParameters["mid"] = localId;
+
+				json& offerMediaObject = sending.offerMediaObject;
+
+				// Set RTCP CNAME.
+				sendingRtpParameters["rtcp"]["cname"] = Sdp::Utils::getCname(offerMediaObject);
+
+				// Set RTP encodings by parsing the SDP offer if no encodings are given.
+				if (encodings.empty())
+				{
+					sendingRtpParameters["encodings"] = Sdp::Utils::getRtpEncodings(offerMediaObject);
+				}
+				// Set RTP encodings by parsing the SDP offer and complete them with given
+				// one if just a single encoding has been given.
+				else if (encodings.size() == 1)
+				{
+					auto newEncodings = Sdp::Utils::getRtpEncodings(offerMediaObject);
+
+					fillJsonRtpEncodingParameters(newEncodings.front(), encodings.front());
+
+					// Hack for VP9 SVC.
+					if (sending.hackVp9Svc)
+						newEncodings = json::array({ newEncodings[0] });
+
+					sendingRtpParameters["encodings"] = newEncodings;
+				}
+				// Otherwise if more than 1 encoding are given use them verbatim.
+				else
+				{
+					sendingRtpParameters["encodings"] = json::array();
+
+					for (const auto& encoding : encodings)
+					{
+						json jsonEncoding = {};
+
+						fillJsonRtpEncodingParameters(jsonEncoding, encoding);
+						sendingRtpParameters["encodings"].push_back(jsonEncoding);
+					}
+				}
+
+				// If VP8 and there is effective simulcast, add scalabilityMode to each encoding.
+				auto mimeType = sendingRtpParameters["codecs"][0]["mimeType"].get<std::string>();
+
+				std::transform(mimeType.begin(), mimeType.end(), mimeType.begin(), ::tolower);
+
+				// clang-format off
+				if (
+					sendingRtpParameters["encodings"].size() > 1 &&
+					(mimeType == "video/vp8" || mimeType == "video/h264")
+				)
+				// clang-format on
+				{
+					for (auto& encoding : sendingRtpParameters["encodings"])
+					{
+						encoding["scalabilityMode"] = "S1T3";
+					}
+				}
+
+				const auto* codecOptions =
+				  sending.pendingSend->codecOptions.is_null() ? nullptr : &sending.pendingSend->codecOptions;
+
+				this->remoteSdp->Send(
+				  offerMediaObject,
+				  sending.mediaSectionIdx.reuseMid,
+				  sendingRtpParameters,
+				  sending.sendingRemoteRtpParameters,
+				  codecOptions);
+			}
+
+			// Close the m-sections once the new ones took their free ones.
+			for (const auto& mid : stoppingMids)
+			{
+				this->remoteSdp->CloseMediaSection(mid);
+			}
+
+			auto answer = this->remoteSdp->GetSdp();
+
+			MSC_DEBUG("calling pc->SetRemoteDescription():\n%s", answer.c_str());
+
+			// May throw.
+			this->pc->SetRemoteDescription(PeerConnection::SdpType::ANSWER, answer);
+		}
+		catch (...)
+		{
+			auto error = std::current_exception();
+
+			for (auto& sending : sendings)
+			{
+				// Panic here. Try to undo things.
+				sending.transceiver->SetDirectionWithError(webrtc::RtpTransceiverDirection::kInactive);
+				sending.transceiver->sender()->SetTrack(nullptr);
+			}
+
+			for (auto& pendingSend : sends)
+			{
+				rejectPromise(pendingSend.promise, error);
+			}
+
+			for (auto& pendingStop : stops)
+			{
+				rejectPromise(pendingStop.promise, error);
+			}
+
+			return;
+		}
+
+		for (auto& sending : sendings)
+		{
+			auto localId = sending.transceiver->mid().value();
+
+			// Store in the map.
+			this->mapMidTransceiver[localId] = sending.transceiver;
+
+			SendResult sendResult;
+
+			sendResult.localId       = localId;
+			sendResult.rtpSender     = sending.transceiver->sender();
+			sendResult.rtpParameters = sending.sendingRtpParameters;
+
+			sending.pendingSend->promise.set_value(sendResult);
+		}
+
+		for (auto* pendingStop : stoppings)
+		{
+			pendingStop->promise.set_value();
+		}
+	}
+
+	void SendHandler::ReplaceTrack(const std::string& localId, webrtc::MediaStreamTrackInterface* track)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG(
+		  "[localId:%s, track->id():%s]",
+		  localId.c_str(),
+		  track == nullptr ? "nullptr" : track->id().c_str());
+
+		auto localIdIt = this->mapMidTransceiver.find(localId);
 
 		if (localIdIt == this->mapMidTransceiver.end())
 			MSC_THROW_ERROR("associated RtpTransceiver not found");
@@ -516,60 +1109,191 @@ namespace mediasoupclient
 		if (localIdIt == this->mapMidTransceiver.end())
 			MSC_THROW_ERROR("associated RtpTransceiver not found");
 
+		// Nothing to edit.
+		if (spatialLayer == 0u)
+			return;
+
 		auto* transceiver = localIdIt->second;
 		auto parameters   = transceiver->sender()->GetParameters();
 
-		bool hasLowEncoding{ false };
-		bool hasMediumEncoding{ false };
-		bool hasHighEncoding{ false };
-		webrtc::RtpEncodingParameters* lowEncoding{ nullptr };
-		webrtc::RtpEncodingParameters* mediumEncoding{ nullptr };
-		webrtc::RtpEncodingParameters* highEncoding{ nullptr };
+		// If the sender is paused just remember the new layers, they will be
+		// applied once resumed.
+		auto pausedIt = this->mapMidPausedEncodingsActive.find(localId);
 
-		if (!parameters.encodings.empty())
+		if (pausedIt != this->mapMidPausedEncodingsActive.end())
 		{
-			hasLowEncoding = true;
-			lowEncoding    = &parameters.encodings[0];
-		}
+			auto& encodingsActive = pausedIt->second;
 
-		if (parameters.encodings.size() > 1)
-		{
-			hasMediumEncoding = true;
-			mediumEncoding    = &parameters.encodings[1];
+			for (size_t idx{ 0u }; idx < encodingsActive.size(); ++idx)
+			{
+				encodingsActive[idx] = idx < spatialLayer;
+			}
+
+			return;
 		}
 
-		if (parameters.encodings.size() > 2)
+		// Edit encodings. They are ordered from the lowest to the highest layer.
+		for (size_t idx{ 0u }; idx < parameters.encodings.size(); ++idx)
 		{
-			hasHighEncoding = true;
-			highEncoding    = &parameters.encodings[2];
+			parameters.encodings[idx].active = idx < spatialLayer;
 		}
 
-		// Edit encodings.
-		if (spatialLayer == 1u)
+		auto result = transceiver->sender()->SetParameters(parameters);
+
+		if (!result.ok())
+			MSC_THROW_ERROR("%s", result.message());
+	}
+
+	void SendHandler::SetRtpEncodingParameters(const std::string& localId, const json& encodings)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG("[localId:%s]", localId.c_str());
+
+		auto localIdIt = this->mapMidTransceiver.find(localId);
+
+		if (localIdIt == this->mapMidTransceiver.end())
+			MSC_THROW_ERROR("associated RtpTransceiver not found");
+
+		if (!encodings.is_array())
+			MSC_THROW_TYPE_ERROR("encodings is not an array");
+
+		auto* transceiver = localIdIt->second;
+		auto parameters   = transceiver->sender()->GetParameters();
+		auto pausedIt     = this->mapMidPausedEncodingsActive.find(localId);
+		bool paused       = pausedIt != this->mapMidPausedEncodingsActive.end();
+
+		if (encodings.size() > parameters.encodings.size())
+			MSC_THROW_TYPE_ERROR("too many encodings");
+
+		// Work on copies so nothing is modified if any given encoding is invalid.
+		std::vector<bool> encodingsActive = paused ? pausedIt->second : std::vector<bool>();
+
+		for (size_t idx{ 0u }; idx < encodings.size(); ++idx)
 		{
-			hasLowEncoding && (lowEncoding->active = true);
-			hasMediumEncoding && (mediumEncoding->active = false);
-			hasHighEncoding && (highEncoding->active = false);
+			const auto& jsonEncoding = encodings[idx];
+
+			if (!jsonEncoding.is_object())
+				MSC_THROW_TYPE_ERROR("encoding is not an object");
+
+			// Encodings are matched by rid if given, or by position otherwise.
+			webrtc::RtpEncodingParameters* encoding{ nullptr };
+			auto ridIt = jsonEncoding.find("rid");
+
+			if (ridIt != jsonEncoding.end())
+			{
+				if (!ridIt->is_string())
+					MSC_THROW_TYPE_ERROR("invalid encoding.rid");
+
+				auto rid = ridIt->get<std::string>();
+				auto encodingIt = std::find_if(
+				  parameters.encodings.begin(),
+				  parameters.encodings.end(),
+				  [&rid](const webrtc::RtpEncodingParameters& e) { return e.rid == rid; });
+
+				if (encodingIt == parameters.encodings.end())
+					MSC_THROW_TYPE_ERROR("encoding with rid '%s' not found", rid.c_str());
+
+				encoding = &(*encodingIt);
+			}
+			else
+			{
+				encoding = &parameters.encodings[idx];
+			}
+
+			// This may throw.
+			applyJsonRtpEncodingParameters(*encoding, jsonEncoding);
+
+			// If the sender is paused, keep every encoding inactive and remember the
+			// requested active flag for when it is resumed.
+			if (paused)
+			{
+				auto encodingIdx = static_cast<size_t>(encoding - parameters.encodings.data());
+
+				if (jsonEncoding.find("active") != jsonEncoding.end() && encodingIdx < encodingsActive.size())
+					encodingsActive[encodingIdx] = encoding->active;
+
+				encoding->active = false;
+			}
 		}
 
-		else if (spatialLayer == 2u)
+		// Apply all the changes at once. No renegotiation is needed.
+		auto result = transceiver->sender()->SetParameters(parameters);
+
+		if (!result.ok())
+			MSC_THROW_ERROR("%s", result.message());
+
+		if (paused)
+			pausedIt->second = encodingsActive;
+	}
+
+	void SendHandler::PauseSending(const std::string& localId)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG("[localId:%s]", localId.c_str());
+
+		auto localIdIt = this->mapMidTransceiver.find(localId);
+
+		if (localIdIt == this->mapMidTransceiver.end())
+			MSC_THROW_ERROR("associated RtpTransceiver not found");
+
+		// Already paused.
+		if (this->mapMidPausedEncodingsActive.find(localId) != this->mapMidPausedEncodingsActive.end())
+			return;
+
+		auto* transceiver = localIdIt->second;
+		auto parameters   = transceiver->sender()->GetParameters();
+		std::vector<bool> encodingsActive;
+
+		// Deactivate every encoding so the encoder stops and no RTP is sent.
+		for (auto& encoding : parameters.encodings)
 		{
-			hasLowEncoding && (lowEncoding->active = true);
-			hasMediumEncoding && (mediumEncoding->active = true);
-			hasHighEncoding && (highEncoding->active = false);
+			encodingsActive.push_back(encoding.active);
+			encoding.active = false;
 		}
 
-		else if (spatialLayer == 3u)
+		auto result = transceiver->sender()->SetParameters(parameters);
+
+		if (!result.ok())
+			MSC_THROW_ERROR("%s", result.message());
+
+		this->mapMidPausedEncodingsActive[localId] = encodingsActive;
+	}
+
+	void SendHandler::ResumeSending(const std::string& localId)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG("[localId:%s]", localId.c_str());
+
+		auto localIdIt = this->mapMidTransceiver.find(localId);
+
+		if (localIdIt == this->mapMidTransceiver.end())
+			MSC_THROW_ERROR("associated RtpTransceiver not found");
+
+		auto pausedIt = this->mapMidPausedEncodingsActive.find(localId);
+
+		// Not paused.
+		if (pausedIt == this->mapMidPausedEncodingsActive.end())
+			return;
+
+		auto* transceiver           = localIdIt->second;
+		auto parameters             = transceiver->sender()->GetParameters();
+		const auto& encodingsActive = pausedIt->second;
+
+		// Restore the encodings that were active before pausing.
+		for (size_t idx{ 0u }; idx < parameters.encodings.size() && idx < encodingsActive.size(); ++idx)
 		{
-			hasLowEncoding && (lowEncoding->active = true);
-			hasMediumEncoding && (mediumEncoding->active = true);
-			hasHighEncoding && (highEncoding->active = true);
+			parameters.encodings[idx].active = encodingsActive[idx];
 		}
 
 		auto result = transceiver->sender()->SetParameters(parameters);
 
 		if (!result.ok())
 			MSC_THROW_ERROR("%s", result.message());
+
+		this->mapMidPausedEncodingsActive.erase(pausedIt);
 	}
 
 	json SendHandler::GetSenderStats(const std::string& localId)
@@ -593,10 +1317,12 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
+
 		// Provide the remote SDP handler with new remote ICE parameters.
 		this->remoteSdp->UpdateIceParameters(iceParameters);
 
-		if (!this->transportReady)
+		if (!this->session->transportReady)
 			return;
 
 		webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
@@ -610,8 +1336,7 @@ namespace mediasoupclient
 		// May throw.
 		this->pc->SetLocalDescription(PeerConnection::SdpType::OFFER, offer);
 
-		auto localSdpObj = sdptransform::parse(this->pc->GetLocalDescription());
-		auto answer      = this->remoteSdp->GetSdp();
+		auto answer = this->remoteSdp->GetSdp();
 
 		MSC_DEBUG("calling pc->SetRemoteDescription():\n%s", answer.c_str());
 
@@ -634,81 +1359,74 @@ namespace mediasoupclient
 		MSC_TRACE();
 	};
 
+	RecvHandler::RecvHandler(Handler::PrivateListener* privateListener, SendHandler* sendHandler)
+	  : Handler(privateListener, sendHandler)
+	{
+		MSC_TRACE();
+	};
+
 	RecvHandler::RecvResult RecvHandler::Receive(
 	  const std::string& id, const std::string& kind, const json* rtpParameters)
 	{
 		MSC_TRACE();
 
-		MSC_DEBUG("[id:%s, kind:%s]", id.c_str(), kind.c_str());
-
-		std::string localId;
-
-		// mid is optional, check whether it exists and is a non empty string.
-		auto midIt = rtpParameters->find("mid");
-		if (midIt != rtpParameters->end() && (midIt->is_string() && !midIt->get<std::string>().empty()))
-			localId = midIt->get<std::string>();
-		else
-			localId = std::to_string(this->mapMidTransceiver.size());
-
-		const auto& cname = (*rtpParameters)["rtcp"]["cname"];
-
-		this->remoteSdp->Receive(localId, kind, *rtpParameters, cname, id);
-
-		auto offer = this->remoteSdp->GetSdp();
-
-		MSC_DEBUG("calling pc->setRemoteDescription():\n%s", offer.c_str());
-
 		// May throw.
-		this->pc->SetRemoteDescription(PeerConnection::SdpType::OFFER, offer);
+		return ReceiveAsync(id, kind, *rtpParameters).get();
+	}
 
-		webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+	/**
+	 * Queues the remote track to be received in the next negotiation. The future
+	 * is fulfilled once such a negotiation is done.
+	 */
+	std::future<RecvHandler::RecvResult> RecvHandler::ReceiveAsync(
+	  const std::string& id, const std::string& kind, const json& rtpParameters)
+	{
+		MSC_TRACE();
 
-		// May throw.
-		auto answer         = this->pc->CreateAnswer(options);
-		auto localSdpObject = sdptransform::parse(answer);
-		auto mediaIt        = find_if(
-      localSdpObject["media"].begin(), localSdpObject["media"].end(), [&localId](const json& m) {
-        return m["mid"].get<std::string>() == localId;
-      });
+		MSC_DEBUG("[id:%s, kind:%s]", id.c_str(), kind.c_str());
 
-		auto& answerMediaObject = *mediaIt;
+		ReceiveOptions options;
 
-		// May need to modify codec parameters in the answer based on codec
-		// parameters in the offer.
-		Sdp::Utils::applyCodecParameters(*rtpParameters, answerMediaObject);
+		options.id            = id;
+		options.kind          = kind;
+		options.rtpParameters = rtpParameters;
 
-		answer = sdptransform::write(localSdpObject);
+		return std::move(ReceiveAsync(std::vector<ReceiveOptions>{ options }).front());
+	}
 
-		if (!this->transportReady)
-			this->SetupTransport(
-			  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "client", localSdpObject);
+	/**
+	 * Queues the given remote tracks so they are received within the same
+	 * negotiation. Futures are returned in the same order.
+	 */
+	std::vector<std::future<RecvHandler::RecvResult>> RecvHandler::ReceiveAsync(
+	  const std::vector<ReceiveOptions>& optionsList)
+	{
+		MSC_TRACE();
 
-		MSC_DEBUG("calling pc->SetLocalDescription():\n%s", answer.c_str());
+		MSC_DEBUG("[optionsList:%zu]", optionsList.size());
 
-		// May throw.
-		this->pc->SetLocalDescription(PeerConnection::SdpType::ANSWER, answer);
+		std::vector<std::future<RecvResult>> futures;
 
-		auto transceivers  = this->pc->GetTransceivers();
-		auto transceiverIt = std::find_if(
-		  transceivers.begin(), transceivers.end(), [&localId](webrtc::RtpTransceiverInterface* t) {
-			  return t->mid() == localId;
-		  });
+		{
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
 
-		if (transceiverIt == transceivers.end())
-			MSC_THROW_ERROR("new RTCRtpTransceiver not found");
+			for (const auto& options : optionsList)
+			{
+				PendingReceive pendingReceive;
 
-		auto& transceiver = *transceiverIt;
+				pendingReceive.id            = options.id;
+				pendingReceive.kind          = options.kind;
+				pendingReceive.rtpParameters = options.rtpParameters;
 
-		// Store in the map.
-		this->mapMidTransceiver[localId] = transceiver;
+				futures.push_back(pendingReceive.promise.get_future());
 
-		RecvResult recvResult;
+				this->pendingReceives.push_back(std::move(pendingReceive));
+			}
+		}
 
-		recvResult.localId     = localId;
-		recvResult.rtpReceiver = transceiver->receiver();
-		recvResult.track       = transceiver->receiver()->track();
+		ProcessPendingOperations();
 
-		return recvResult;
+		return futures;
 	}
 
 	Handler::DataChannel RecvHandler::ReceiveDataChannel(
@@ -716,6 +1434,13 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
+
+		// The stream id is assigned by the server, so it may clash with a DataChannel
+		// of a SendHandler sharing this PeerConnection.
+		if (this->session->IsSctpStreamIdInUse(static_cast<uint16_t>(dataChannelInit.id)))
+			MSC_THROW_ERROR("SCTP stream id already in use [streamId:%d]", dataChannelInit.id);
+
 		dataChannelInit.negotiated = true;
 
 		/* clang-format off */
@@ -732,77 +1457,374 @@ namespace mediasoupclient
 		rtc::scoped_refptr<webrtc::DataChannelInterface> webrtcDataChannel =
 		  this->pc->CreateDataChannel(label, &dataChannelInit);
 
+		this->session->dataChannels[static_cast<uint16_t>(dataChannelInit.id)] = webrtcDataChannel;
+
 		// If this is the first DataChannel we need to create the SDP answer with
 		// m=application section.
-		if (!this->hasDataChannelMediaSection)
+		if (!this->session->hasDataChannelMediaSection)
+			this->ReceiveSctpAssociation();
+
+		RecvHandler::DataChannel dataChannel;
+
+		dataChannel.dataChannel          = webrtcDataChannel;
+		dataChannel.sctpStreamParameters = sctpStreamParameters;
+
+		return dataChannel;
+	}
+
+	/**
+	 * Negotiates the m=application section so ICE and DTLS start before the first
+	 * Consumer or DataConsumer is created.
+	 */
+	void RecvHandler::Connect()
+	{
+		MSC_TRACE();
+
+		// The flags are set by any Handler of the session within a negotiation.
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
+
+		if (this->session->transportReady || this->session->hasDataChannelMediaSection)
+			return;
+
+		if (!this->hasSctpParameters)
+			MSC_THROW_UNSUPPORTED_ERROR("cannot connect without SctpParameters");
+
+		// May throw.
+		this->ReceiveSctpAssociation();
+	}
+
+	void RecvHandler::ReceiveSctpAssociation()
+	{
+		MSC_TRACE();
+
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
+
+		this->remoteSdp->RecvSctpAssociation();
+		auto sdpOffer = this->remoteSdp->GetSdp();
+
+		MSC_DEBUG("calling pc->setRemoteDescription() [offer:%s]", sdpOffer.c_str());
+
+		// May throw.
+		this->pc->SetRemoteDescription(PeerConnection::SdpType::OFFER, sdpOffer);
+
+		webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+		auto sdpAnswer = this->pc->CreateAnswer(options);
+
+		if (!this->session->transportReady)
 		{
-			this->remoteSdp->RecvSctpAssociation();
-			auto sdpOffer = this->remoteSdp->GetSdp();
+			this->SetupTransport(
+			  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "client",
+			  Sdp::LocalSdp(sdpAnswer));
+		}
 
-			MSC_DEBUG("calling pc->setRemoteDescription() [offer:%s]", sdpOffer.c_str());
+		MSC_DEBUG("calling pc->setLocalDescription() [answer: %s]", sdpAnswer.c_str());
 
-			// May throw.
-			this->pc->SetRemoteDescription(PeerConnection::SdpType::OFFER, sdpOffer);
+		// May throw.
+		this->pc->SetLocalDescription(PeerConnection::SdpType::ANSWER, sdpAnswer);
 
-			webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
-			auto sdpAnswer = this->pc->CreateAnswer(options);
+		this->session->hasDataChannelMediaSection = true;
+	}
+
+	void RecvHandler::StopReceiving(const std::string& localId)
+	{
+		MSC_TRACE();
 
-			if (!this->transportReady)
+		MSC_DEBUG("[localId:%s]", localId.c_str());
+
+		StopReceiving(std::vector<std::string>{ localId });
+	}
+
+	/**
+	 * Stops receiving the given tracks and closes their m-sections within a
+	 * single SDP negotiation.
+	 */
+	void RecvHandler::StopReceiving(const std::vector<std::string>& localIds)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG("[localIds:%zu]", localIds.size());
+
+		std::vector<std::future<void>> futures;
+
+		{
+			std::lock_guard<std::recursive_mutex> negotiationLock(this->session->negotiationMutex);
+
+			// Check them all before touching anything.
+			for (const auto& localId : localIds)
 			{
-				auto localSdpObject = sdptransform::parse(sdpAnswer);
-				this->SetupTransport(
-				  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "client", localSdpObject);
+				if (this->mapMidTransceiver.find(localId) == this->mapMidTransceiver.end())
+					MSC_THROW_ERROR("associated RtpTransceiver not found");
+			}
+
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
+
+			for (const auto& localId : localIds)
+			{
+				PendingStop pendingStop;
+
+				pendingStop.localId = localId;
+				futures.push_back(pendingStop.promise.get_future());
+
+				this->pendingStops.push_back(std::move(pendingStop));
 			}
+		}
 
-			MSC_DEBUG("calling pc->setLocalDescription() [answer: %s]", sdpAnswer.c_str());
+		ProcessPendingOperations();
 
+		for (auto& future : futures)
+		{
 			// May throw.
-			this->pc->SetLocalDescription(PeerConnection::SdpType::ANSWER, sdpAnswer);
+			future.get();
+		}
+	}
+
+	/**
+	 * Queues the remote track to stop being received in the next negotiation.
+	 * The future is fulfilled once such a negotiation is done.
+	 */
+	std::future<void> RecvHandler::StopReceivingAsync(const std::string& localId)
+	{
+		MSC_TRACE();
+
+		MSC_DEBUG("[localId:%s]", localId.c_str());
+
+		PendingStop pendingStop;
+
+		pendingStop.localId = localId;
+
+		auto future = pendingStop.promise.get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
 
-			this->hasDataChannelMediaSection = true;
+			this->pendingStops.push_back(std::move(pendingStop));
 		}
 
-		RecvHandler::DataChannel dataChannel;
+		ProcessPendingOperations();
 
-		dataChannel.dataChannel          = webrtcDataChannel;
-		dataChannel.sctpStreamParameters = sctpStreamParameters;
+		return future;
+	}
 
-		return dataChannel;
+	void RecvHandler::StopTransceivers(const std::vector<std::string>& localIds)
+	{
+		MSC_TRACE();
+
+		this->StopReceiving(localIds);
 	}
 
-	void RecvHandler::StopReceiving(const std::string& localId)
+	bool RecvHandler::HasPendingOperations() const
 	{
 		MSC_TRACE();
 
-		MSC_DEBUG("[localId:%s]", localId.c_str());
+		return !this->pendingReceives.empty() || !this->pendingStops.empty();
+	}
 
-		auto localIdIt = this->mapMidTransceiver.find(localId);
+	void RecvHandler::RejectPendingOperations(const std::exception_ptr& error)
+	{
+		MSC_TRACE();
 
-		if (localIdIt == this->mapMidTransceiver.end())
-			MSC_THROW_ERROR("associated RtpTransceiver not found");
+		for (auto& pendingReceive : this->pendingReceives)
+		{
+			rejectPromise(pendingReceive.promise, error);
+		}
 
-		auto& transceiver = localIdIt->second;
+		for (auto& pendingStop : this->pendingStops)
+		{
+			rejectPromise(pendingStop.promise, error);
+		}
 
-		MSC_DEBUG("disabling mid:%s", transceiver->mid().value().c_str());
+		this->pendingReceives.clear();
+		this->pendingStops.clear();
+	}
 
-		this->remoteSdp->CloseMediaSection(transceiver->mid().value());
+	/**
+	 * Adds the m-sections of the queued remote tracks and closes those of the
+	 * stopped ones, then does a single offer/answer exchange. Errors affecting a
+	 * single operation are reported in its future only.
+	 */
+	void RecvHandler::NegotiatePendingOperations()
+	{
+		MSC_TRACE();
 
-		auto offer = this->remoteSdp->GetSdp();
+		std::vector<PendingReceive> receives;
+		std::vector<PendingStop> stops;
 
-		MSC_DEBUG("calling pc->setRemoteDescription():\n%s", offer.c_str());
+		{
+			std::lock_guard<std::mutex> lock(this->pendingMutex);
 
-		// May throw.
-		this->pc->SetRemoteDescription(PeerConnection::SdpType::OFFER, offer);
+			receives.swap(this->pendingReceives);
+			stops.swap(this->pendingStops);
+		}
 
-		webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+		MSC_DEBUG("[receives:%zu, stops:%zu]", receives.size(), stops.size());
 
-		// May throw.
-		auto answer = this->pc->CreateAnswer(options);
+		std::vector<PendingReceive*> receivings;
+		std::vector<std::string> receivingLocalIds;
+		std::vector<PendingStop*> stoppings;
 
-		MSC_DEBUG("calling pc->SetLocalDescription():\n%s", answer.c_str());
+		// Every queued operation taken is fulfilled or rejected, whatever fails.
+		try
+		{
+			for (auto& pendingReceive : receives)
+			{
+				const auto& rtpParameters = pendingReceive.rtpParameters;
+				std::string localId;
+
+				// mid is optional, check whether it exists and is a non empty string.
+				auto midIt = rtpParameters.find("mid");
+				if (midIt != rtpParameters.end() && (midIt->is_string() && !midIt->get<std::string>().empty()))
+				{
+					localId = midIt->get<std::string>();
+				}
+				else
+				{
+					auto nextMid = this->mapMidTransceiver.size() + receivings.size();
+
+					// Don't take the MID of an existing m-section (maybe a sending one if the
+					// PeerConnection is shared with a SendHandler).
+					while (this->remoteSdp->HasMediaSection(std::to_string(nextMid)))
+					{
+						++nextMid;
+					}
+
+					localId = std::to_string(nextMid);
+				}
+
+				try
+				{
+					const auto& cname = rtpParameters["rtcp"]["cname"];
+
+					// Closed m-sections (from previous negotiations) are recycled.
+					this->remoteSdp->Receive(localId, pendingReceive.kind, rtpParameters, cname, pendingReceive.id);
+				}
+				catch (...)
+				{
+					pendingReceive.promise.set_exception(std::current_exception());
+
+					continue;
+				}
+
+				receivings.push_back(&pendingReceive);
+				receivingLocalIds.push_back(localId);
+			}
 
-		// May throw.
-		this->pc->SetLocalDescription(PeerConnection::SdpType::ANSWER, answer);
+			for (auto& pendingStop : stops)
+			{
+				auto localIdIt = this->mapMidTransceiver.find(pendingStop.localId);
+
+				if (localIdIt == this->mapMidTransceiver.end())
+				{
+					pendingStop.promise.set_exception(
+					  std::make_exception_ptr(MediaSoupClientError("associated RtpTransceiver not found")));
+
+					continue;
+				}
+
+				auto& transceiver = localIdIt->second;
+
+				MSC_DEBUG("disabling mid:%s", transceiver->mid().value().c_str());
+
+				this->remoteSdp->CloseMediaSection(transceiver->mid().value());
+
+				stoppings.push_back(&pendingStop);
+			}
+
+			if (receivings.empty() && stoppings.empty())
+				return;
+
+			auto offer = this->remoteSdp->GetSdp();
+
+			MSC_DEBUG("calling pc->setRemoteDescription():\n%s", offer.c_str());
+
+			// May throw.
+			this->pc->SetRemoteDescription(PeerConnection::SdpType::OFFER, offer);
+
+			webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options;
+
+			// May throw.
+			Sdp::LocalSdp localSdp(this->pc->CreateAnswer(options));
+
+			for (size_t idx{ 0u }; idx < receivings.size(); ++idx)
+			{
+				// Codec parameters are just applied to audio (Opus) m-sections.
+				if (receivings[idx]->kind != "audio")
+					continue;
+
+				// The answer has the same m-sections as the offer, in the same order.
+				auto mediaSectionIdx   = this->remoteSdp->GetMediaSectionIdx(receivingLocalIds[idx]);
+				auto answerMediaObject = localSdp.ParseMediaSection(mediaSectionIdx);
+
+				// May need to modify codec parameters in the answer based on codec
+				// parameters in the offer.
+				Sdp::Utils::applyCodecParameters(receivings[idx]->rtpParameters, answerMediaObject);
+
+				localSdp.SetMediaSection(mediaSectionIdx, answerMediaObject);
+			}
+
+			if (!this->session->transportReady)
+				this->SetupTransport(
+				  !this->forcedLocalDtlsRole.empty() ? this->forcedLocalDtlsRole : "client", localSdp);
+
+			const auto& answer = localSdp.GetSdp();
+
+			MSC_DEBUG("calling pc->SetLocalDescription():\n%s", answer.c_str());
+
+			// May throw.
+			this->pc->SetLocalDescription(PeerConnection::SdpType::ANSWER, answer);
+		}
+		catch (...)
+		{
+			auto error = std::current_exception();
+
+			// Forget the transceivers signaled before the failure.
+			for (const auto& localId : receivingLocalIds)
+			{
+				(void)this->session->TakeReceivingTransceiver(localId);
+			}
+
+			for (auto& pendingReceive : receives)
+			{
+				rejectPromise(pendingReceive.promise, error);
+			}
+
+			for (auto& pendingStop : stops)
+			{
+				rejectPromise(pendingStop.promise, error);
+			}
+
+			return;
+		}
+
+		for (size_t idx{ 0u }; idx < receivings.size(); ++idx)
+		{
+			const auto& localId = receivingLocalIds[idx];
+			// Signaled by the PeerConnection while setting the remote offer.
+			auto transceiver = this->session->TakeReceivingTransceiver(localId);
+
+			if (!transceiver)
+			{
+				receivings[idx]->promise.set_exception(
+				  std::make_exception_ptr(MediaSoupClientError("new RTCRtpTransceiver not found")));
+
+				continue;
+			}
+
+			// Store in the map.
+			this->mapMidTransceiver[localId] = transceiver.get();
+
+			RecvResult recvResult;
+
+			recvResult.localId     = localId;
+			recvResult.rtpReceiver = transceiver->receiver();
+			recvResult.track       = transceiver->receiver()->track();
+
+			receivings[idx]->promise.set_value(recvResult);
+		}
+
+		for (auto* pendingStop : stoppings)
+		{
+			pendingStop->promise.set_value();
+		}
 	}
 
 	json RecvHandler::GetReceiverStats(const std::string& localId)
@@ -828,10 +1850,12 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 
+		std::lock_guard<std::recursive_mutex> lock(this->session->negotiationMutex);
+
 		// Provide the remote SDP handler with new remote ICE parameters.
 		this->remoteSdp->UpdateIceParameters(iceParameters);
 
-		if (!this->transportReady)
+		if (!this->session->transportReady)
 			return;
 
 		auto offer = this->remoteSdp->GetSdp();
@@ -878,3 +1902,87 @@ static void fillJsonRtpEncodingParameters(json& jsonEncoding, const webrtc::RtpE
 
 	jsonEncoding["networkPriority"] = encoding.network_priority;
 }
+
+// Only the given fields are modified. A null value removes the setting.
+static void applyJsonRtpEncodingParameters(webrtc::RtpEncodingParameters& encoding, const json& jsonEncoding)
+{
+	MSC_TRACE();
+
+	auto activeIt = jsonEncoding.find("active");
+
+	if (activeIt != jsonEncoding.end())
+	{
+		if (!activeIt->is_boolean())
+			MSC_THROW_TYPE_ERROR("invalid encoding.active");
+
+		encoding.active = activeIt->get<bool>();
+	}
+
+	auto maxBitrateIt = jsonEncoding.find("maxBitrate");
+
+	if (maxBitrateIt != jsonEncoding.end())
+	{
+		if (maxBitrateIt->is_null())
+			encoding.max_bitrate_bps.reset();
+		else if (
+		  maxBitrateIt->is_number_unsigned() &&
+		  maxBitrateIt->get<uint64_t>() <= static_cast<uint64_t>(std::numeric_limits<int>::max()))
+		{
+			encoding.max_bitrate_bps = static_cast<int>(maxBitrateIt->get<uint64_t>());
+		}
+		else
+			MSC_THROW_TYPE_ERROR("invalid encoding.maxBitrate");
+	}
+
+	auto maxFramerateIt = jsonEncoding.find("maxFramerate");
+
+	if (maxFramerateIt != jsonEncoding.end())
+	{
+		if (maxFramerateIt->is_null())
+			encoding.max_framerate.reset();
+		else if (maxFramerateIt->is_number() && maxFramerateIt->get<double>() >= 0)
+			encoding.max_framerate = maxFramerateIt->get<double>();
+		else
+			MSC_THROW_TYPE_ERROR("invalid encoding.maxFramerate");
+	}
+
+	auto scaleResolutionDownByIt = jsonEncoding.find("scaleResolutionDownBy");
+
+	if (scaleResolutionDownByIt != jsonEncoding.end())
+	{
+		if (scaleResolutionDownByIt->is_null())
+			encoding.scale_resolution_down_by.reset();
+		else if (scaleResolutionDownByIt->is_number() && scaleResolutionDownByIt->get<double>() >= 1)
+			encoding.scale_resolution_down_by = scaleResolutionDownByIt->get<double>();
+		else
+			MSC_THROW_TYPE_ERROR("invalid encoding.scaleResolutionDownBy");
+	}
+
+	auto scalabilityModeIt = jsonEncoding.find("scalabilityMode");
+
+	if (scalabilityModeIt != jsonEncoding.end())
+	{
+		if (scalabilityModeIt->is_null())
+			encoding.scalability_mode.reset();
+		else if (scalabilityModeIt->is_string())
+			encoding.scalability_mode = scalabilityModeIt->get<std::string>();
+		else
+			MSC_THROW_TYPE_ERROR("invalid encoding.scalabilityMode");
+	}
+}
+
+// Rejects the promise unless it has already been fulfilled or rejected.
+template<typename T>
+static void rejectPromise(std::promise<T>& promise, const std::exception_ptr& error)
+{
+	MSC_TRACE();
+
+	try
+	{
+		promise.set_exception(error);
+	}
+	catch (const std::future_error&)
+	{
+		// Already satisfied.
+	}
+}
@@ -10,9 +10,15 @@
 #include <api/video_codecs/builtin_video_decoder_factory.h>
 #include <api/video_codecs/builtin_video_encoder_factory.h>
 #include <rtc_base/ssl_adapter.h>
+#include <mutex>
 
 using json = nlohmann::json;
 
+// Static functions declaration.
+static json getNativeCodecs(webrtc::PeerConnectionFactoryInterface* factory);
+static json getCodecs(const webrtc::RtpCapabilities& capabilities);
+static webrtc::PeerConnectionFactoryInterface* getDefaultFactory();
+
 namespace mediasoupclient
 {
 	/* Static. */
@@ -57,10 +63,42 @@ namespace mediasoupclient
 	};
 	// clang-format on
 
+	/* Static methods. */
+
+	PeerConnection* PeerConnection::Create(
+	  PeerConnection::PrivateListener* privateListener, const PeerConnection::Options* options)
+	{
+		MSC_TRACE();
+
+		if ((options != nullptr) && (options->backend != nullptr))
+			return options->backend->CreatePeerConnection(privateListener, options);
+
+		return new PeerConnection(privateListener, options);
+	}
+
+	json PeerConnection::GetNativeCodecs(const PeerConnection::Options* options)
+	{
+		MSC_TRACE();
+
+		if ((options != nullptr) && (options->backend != nullptr))
+			return options->backend->GetNativeCodecs(options);
+
+		if ((options != nullptr) && (options->factory != nullptr))
+			return getNativeCodecs(options->factory);
+
+		auto* factory = getDefaultFactory();
+
+		if (!factory)
+			MSC_THROW_INVALID_STATE_ERROR("thread start errored");
+
+		return getNativeCodecs(factory);
+	}
+
 	/* Instance methods. */
 
 	PeerConnection::PeerConnection(
 	  PeerConnection::PrivateListener* privateListener, const PeerConnection::Options* options)
+	  : privateListenerProxy(privateListener)
 	{
 		MSC_TRACE();
 
@@ -106,9 +144,30 @@ namespace mediasoupclient
 		// Set SDP semantics to Unified Plan.
 		config.sdp_semantics = webrtc::SdpSemantics::kUnifiedPlan;
 
+		if ((options != nullptr) && options->continualGathering)
+		{
+			config.continual_gathering_policy = webrtc::PeerConnectionInterface::GATHER_CONTINUALLY;
+
+			// The initial gathering takes a pooled session and the first ICE restart
+			// takes another one, whose candidates are already gathered by then.
+			if (config.ice_candidate_pool_size < 2)
+				config.ice_candidate_pool_size = 2;
+		}
+
 		// Create the webrtc::Peerconnection.
-		this->pc =
-		  this->peerConnectionFactory->CreatePeerConnection(config, nullptr, nullptr, privateListener);
+		this->pc = this->peerConnectionFactory->CreatePeerConnection(
+		  config, nullptr, nullptr, &this->privateListenerProxy);
+	}
+
+	/**
+	 * Sets the listener of the PeerConnection events. Events happening while there
+	 * is no listener are discarded.
+	 */
+	void PeerConnection::SetPrivateListener(PeerConnection::PrivateListener* privateListener)
+	{
+		MSC_TRACE();
+
+		this->privateListenerProxy.privateListener = privateListener;
 	}
 
 	void PeerConnection::Close()
@@ -386,6 +445,17 @@ namespace mediasoupclient
 		return webrtcDataChannel;
 	}
 
+	/**
+	 * Codecs supported by the factory, which determine the native RTP
+	 * capabilities.
+	 */
+	json PeerConnection::GetNativeCodecs() const
+	{
+		MSC_TRACE();
+
+		return getNativeCodecs(this->peerConnectionFactory.get());
+	}
+
 	/* SetSessionDescriptionObserver */
 
 	std::future<void> PeerConnection::SetSessionDescriptionObserver::GetFuture()
@@ -658,4 +728,191 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 	}
+
+	/* PeerConnection::PrivateListenerProxy */
+
+	void PeerConnection::PrivateListenerProxy::OnSignalingChange(
+	  webrtc::PeerConnectionInterface::SignalingState newState)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnSignalingChange(newState);
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnAddStream(
+	  rtc::scoped_refptr<webrtc::MediaStreamInterface> stream)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnAddStream(std::move(stream));
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnRemoveStream(
+	  rtc::scoped_refptr<webrtc::MediaStreamInterface> stream)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnRemoveStream(std::move(stream));
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnDataChannel(
+	  rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnDataChannel(std::move(dataChannel));
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnRenegotiationNeeded()
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnRenegotiationNeeded();
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnIceConnectionChange(
+	  webrtc::PeerConnectionInterface::IceConnectionState newState)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnIceConnectionChange(newState);
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnIceGatheringChange(
+	  webrtc::PeerConnectionInterface::IceGatheringState newState)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnIceGatheringChange(newState);
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnIceCandidate(const webrtc::IceCandidateInterface* candidate)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnIceCandidate(candidate);
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnIceCandidatesRemoved(
+	  const std::vector<cricket::Candidate>& candidates)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnIceCandidatesRemoved(candidates);
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnIceConnectionReceivingChange(bool receiving)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnIceConnectionReceivingChange(receiving);
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnAddTrack(
+	  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
+	  const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>& streams)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnAddTrack(std::move(receiver), streams);
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnTrack(
+	  rtc::scoped_refptr<webrtc::RtpTransceiverInterface> transceiver)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnTrack(std::move(transceiver));
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnRemoveTrack(
+	  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnRemoveTrack(std::move(receiver));
+	}
+
+	void PeerConnection::PrivateListenerProxy::OnInterestingUsage(int usagePattern)
+	{
+		if (auto* listener = this->privateListener.load())
+			listener->OnInterestingUsage(usagePattern);
+	}
 } // namespace mediasoupclient
+
+// Private helpers used in this file.
+
+static json getNativeCodecs(webrtc::PeerConnectionFactoryInterface* factory)
+{
+	json codecs = json::object();
+
+	for (auto mediaType : { cricket::MEDIA_TYPE_AUDIO, cricket::MEDIA_TYPE_VIDEO })
+	{
+		auto kind = cricket::MediaTypeToString(mediaType);
+
+		codecs[kind]["send"] = getCodecs(factory->GetRtpSenderCapabilities(mediaType));
+		codecs[kind]["recv"] = getCodecs(factory->GetRtpReceiverCapabilities(mediaType));
+	}
+
+	return codecs;
+}
+
+static json getCodecs(const webrtc::RtpCapabilities& capabilities)
+{
+	json codecs = json::array();
+
+	for (const auto& codec : capabilities.codecs)
+	{
+		json jsonCodec = { { "mimeType", codec.mime_type() } };
+
+		if (codec.clock_rate)
+			jsonCodec["clockRate"] = *codec.clock_rate;
+
+		if (codec.num_channels)
+			jsonCodec["channels"] = *codec.num_channels;
+
+		jsonCodec["parameters"] = json::object();
+
+		for (const auto& kv : codec.parameters)
+		{
+			jsonCodec["parameters"][kv.first] = kv.second;
+		}
+
+		codecs.push_back(jsonCodec);
+	}
+
+	return codecs;
+}
+
+// Factory with the same codecs as the ones PeerConnections create when none is
+// given. Created on first use and never destroyed. Null if its threads fail to
+// start.
+static webrtc::PeerConnectionFactoryInterface* getDefaultFactory()
+{
+	static std::mutex mutex;
+	static webrtc::PeerConnectionFactoryInterface* factory{ nullptr };
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (factory)
+		return factory;
+
+	std::unique_ptr<rtc::Thread> networkThread   = rtc::Thread::CreateWithSocketServer();
+	std::unique_ptr<rtc::Thread> signalingThread = rtc::Thread::Create();
+	std::unique_ptr<rtc::Thread> workerThread    = rtc::Thread::Create();
+
+	networkThread->SetName("network_thread", nullptr);
+	signalingThread->SetName("signaling_thread", nullptr);
+	workerThread->SetName("worker_thread", nullptr);
+
+	if (!networkThread->Start() || !signalingThread->Start() || !workerThread->Start())
+		return nullptr;
+
+	auto defaultFactory = webrtc::CreatePeerConnectionFactory(
+	  networkThread.get(),
+	  workerThread.get(),
+	  signalingThread.get(),
+	  nullptr /*default_adm*/,
+	  webrtc::CreateBuiltinAudioEncoderFactory(),
+	  webrtc::CreateBuiltinAudioDecoderFactory(),
+	  webrtc::CreateBuiltinVideoEncoderFactory(),
+	  webrtc::CreateBuiltinVideoDecoderFactory(),
+	  nullptr /*audio_mixer*/,
+	  nullptr /*audio_processing*/);
+
+	factory = defaultFactory.release();
+
+	// The threads must outlive the factory.
+	(void)networkThread.release();
+	(void)signalingThread.release();
+	(void)workerThread.release();
+
+	return factory;
+}
@@ -16,9 +16,11 @@ namespace mediasoupclient
 	  webrtc::RtpSenderInterface* rtpSender,
 	  webrtc::MediaStreamTrackInterface* track,
 	  const json& rtpParameters,
-	  const json& appData)
+	  const json& appData,
+	  bool zeroRtpOnPause)
 	  : privateListener(privateListener), listener(listener), id(id), localId(localId),
-	    rtpSender(rtpSender), track(track), rtpParameters(rtpParameters), appData(appData)
+	    rtpSender(rtpSender), track(track), rtpParameters(rtpParameters), zeroRtpOnPause(zeroRtpOnPause),
+	    appData(appData)
 	{
 		MSC_TRACE();
 	}
@@ -118,6 +120,9 @@ namespace mediasoupclient
 
 	/**
 	 * Pauses sending media.
+	 *
+	 * If zeroRtpOnPause was requested, all the RtpSender encodings are also
+	 * deactivated so the encoder stops and no RTP is sent.
 	 */
 	void Producer::Pause()
 	{
@@ -130,11 +135,18 @@ namespace mediasoupclient
 			return;
 		}
 
+		// May throw.
+		if (this->zeroRtpOnPause)
+			this->privateListener->OnPause(this);
+
 		this->track->set_enabled(false);
 	}
 
 	/**
 	 * Resumes sending media.
+	 *
+	 * If zeroRtpOnPause was requested, the encodings active before pausing are
+	 * restored.
 	 */
 	void Producer::Resume()
 	{
@@ -147,6 +159,10 @@ namespace mediasoupclient
 			return;
 		}
 
+		// May throw.
+		if (this->zeroRtpOnPause)
+			this->privateListener->OnResume(this);
+
 		this->track->set_enabled(true);
 	}
 
@@ -210,6 +226,26 @@ namespace mediasoupclient
 		this->maxSpatialLayer = spatialLayer;
 	}
 
+	/**
+	 * Updates the RtpSender encodings at once, without renegotiation.
+	 *
+	 * Each entry may contain 'rid' (otherwise encodings are matched by position),
+	 * 'active', 'maxBitrate', 'maxFramerate', 'scaleResolutionDownBy' and
+	 * 'scalabilityMode'. Missing fields are left untouched.
+	 */
+	void Producer::SetRtpEncodingParameters(const json& encodings)
+	{
+		MSC_TRACE();
+
+		if (this->closed)
+			MSC_THROW_INVALID_STATE_ERROR("Producer closed");
+		else if (!encodings.is_array())
+			MSC_THROW_TYPE_ERROR("encodings must be an array");
+
+		// May throw.
+		this->privateListener->OnSetRtpEncodingParameters(this, encodings);
+	}
+
 	/**
 	 * Transport was closed.
 	 */
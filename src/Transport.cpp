@@ -4,6 +4,8 @@
 #include "Logger.hpp"
 #include "MediaSoupClientErrors.hpp"
 #include "ortc.hpp"
+#include <algorithm> // std::find_if
+#include <cmath>     // std::isfinite
 
 using json = nlohmann::json;
 
@@ -75,8 +77,36 @@ namespace mediasoupclient
 
 		if (this->closed)
 			MSC_THROW_INVALID_STATE_ERROR("Transport closed");
-		else
-			return this->handler->RestartIce(iceParameters);
+
+		{
+			std::lock_guard<std::mutex> lock(this->iceRestartMutex);
+
+			this->restartingIce  = true;
+			this->iceRestartTime = std::chrono::steady_clock::now();
+		}
+
+		try
+		{
+			// May throw.
+			this->handler->RestartIce(iceParameters);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(this->iceRestartMutex);
+
+			this->restartingIce = false;
+
+			throw;
+		}
+	}
+
+	std::chrono::milliseconds Transport::GetIceRestartLatency() const
+	{
+		MSC_TRACE();
+
+		std::lock_guard<std::mutex> lock(this->iceRestartMutex);
+
+		return this->iceRestartLatency;
 	}
 
 	void Transport::UpdateIceServers(const json& iceServers)
@@ -114,6 +144,31 @@ namespace mediasoupclient
 		// Update connection state.
 		this->connectionState = connectionState;
 
+		{
+			using IceConnectionState = webrtc::PeerConnectionInterface::IceConnectionState;
+
+			std::lock_guard<std::mutex> lock(this->iceRestartMutex);
+
+			// The ICE restart ends with the first state change other than checking,
+			// and it is measured only if the ICE connection is connected again.
+			if (this->restartingIce && connectionState != IceConnectionState::kIceConnectionChecking)
+			{
+				this->restartingIce = false;
+
+				if (
+				  connectionState == IceConnectionState::kIceConnectionConnected ||
+				  connectionState == IceConnectionState::kIceConnectionCompleted)
+				{
+					this->iceRestartLatency = std::chrono::duration_cast<std::chrono::milliseconds>(
+					  std::chrono::steady_clock::now() - this->iceRestartTime);
+
+					MSC_DEBUG(
+					  "ICE restarted [latency:%lldms]",
+					  static_cast<long long>(this->iceRestartLatency.count()));
+				}
+			}
+		}
+
 		return this->listener->OnConnectionStateChange(
 		  this, PeerConnection::iceConnectionState2String[connectionState]);
 	}
@@ -130,6 +185,8 @@ namespace mediasoupclient
 	  const PeerConnection::Options* peerConnectionOptions,
 	  const json* extendedRtpCapabilities,
 	  const std::map<std::string, bool>* canProduceByKind,
+	  std::shared_ptr<const json> sendingRtpParametersByKind,
+	  std::shared_ptr<const json> sendingRemoteRtpParametersByKind,
 	  const json& appData)
 
 	  : Transport(listener, id, extendedRtpCapabilities, appData), listener(listener),
@@ -146,16 +203,6 @@ namespace mediasoupclient
 				this->maxSctpMessageSize = maxMessageSizeIt->get<size_t>();
 		}
 
-		json sendingRtpParametersByKind = {
-			{ "audio", ortc::getSendingRtpParameters("audio", *extendedRtpCapabilities) },
-			{ "video", ortc::getSendingRtpParameters("video", *extendedRtpCapabilities) }
-		};
-
-		json sendingRemoteRtpParametersByKind = {
-			{ "audio", ortc::getSendingRemoteRtpParameters("audio", *extendedRtpCapabilities) },
-			{ "video", ortc::getSendingRemoteRtpParameters("video", *extendedRtpCapabilities) }
-		};
-
 		this->sendHandler.reset(new SendHandler(
 		  dynamic_cast<SendHandler::PrivateListener*>(this),
 		  iceParameters,
@@ -163,8 +210,8 @@ namespace mediasoupclient
 		  dtlsParameters,
 		  sctpParameters,
 		  peerConnectionOptions,
-		  sendingRtpParametersByKind,
-		  sendingRemoteRtpParametersByKind));
+		  std::move(sendingRtpParametersByKind),
+		  std::move(sendingRemoteRtpParametersByKind)));
 
 		Transport::SetHandler(this->sendHandler.get());
 	}
@@ -178,7 +225,8 @@ namespace mediasoupclient
 	  const std::vector<webrtc::RtpEncodingParameters>* encodings,
 	  const json* codecOptions,
 	  const json* codec,
-	  const json& appData)
+	  const json& appData,
+	  bool zeroRtpOnPause)
 	{
 		MSC_TRACE();
 
@@ -188,7 +236,9 @@ namespace mediasoupclient
 			MSC_THROW_TYPE_ERROR("missing track");
 		else if (track->state() == webrtc::MediaStreamTrackInterface::TrackState::kEnded)
 			MSC_THROW_INVALID_STATE_ERROR("track ended");
-		else if (this->canProduceByKind->find(track->kind()) == this->canProduceByKind->end())
+		else if (
+		  this->canProduceByKind->find(track->kind()) == this->canProduceByKind->end() ||
+		  !this->canProduceByKind->at(track->kind()))
 			MSC_THROW_UNSUPPORTED_ERROR("cannot produce track kind");
 
 		if (codecOptions)
@@ -243,7 +293,8 @@ namespace mediasoupclient
 		  sendResult.rtpSender,
 		  track,
 		  sendResult.rtpParameters,
-		  appData);
+		  appData,
+		  zeroRtpOnPause);
 
 		this->producers[producer->GetId()] = producer;
 
@@ -299,6 +350,40 @@ namespace mediasoupclient
 		return dataProducer;
 	}
 
+	/**
+	 * Closes the given Producers within a single SDP renegotiation. Already
+	 * closed ones are ignored.
+	 */
+	void SendTransport::CloseProducers(const std::vector<Producer*>& producers)
+	{
+		MSC_TRACE();
+
+		for (auto* producer : producers)
+		{
+			if (!producer->IsClosed() && this->producers.find(producer->GetId()) == this->producers.end())
+				MSC_THROW_TYPE_ERROR("Producer not found [id:%s]", producer->GetId().c_str());
+		}
+
+		std::vector<std::string> localIds;
+
+		for (auto* producer : producers)
+		{
+			if (producer->IsClosed())
+				continue;
+
+			producer->closed = true;
+
+			this->producers.erase(producer->GetId());
+			localIds.push_back(producer->GetLocalId());
+		}
+
+		if (this->closed)
+			return;
+
+		// May throw.
+		this->sendHandler->StopSending(localIds);
+	}
+
 	void SendTransport::Close()
 	{
 		MSC_TRACE();
@@ -325,6 +410,21 @@ namespace mediasoupclient
 		}
 	}
 
+	/**
+	 * Connects the transport before producing by negotiating the SCTP
+	 * association, which requires SCTP parameters.
+	 */
+	void SendTransport::Connect()
+	{
+		MSC_TRACE();
+
+		if (this->closed)
+			MSC_THROW_INVALID_STATE_ERROR("SendTransport closed");
+
+		// May throw.
+		this->sendHandler->Connect();
+	}
+
 	void SendTransport::OnClose(Producer* producer)
 	{
 		MSC_TRACE();
@@ -359,6 +459,27 @@ namespace mediasoupclient
 		return this->sendHandler->SetMaxSpatialLayer(producer->GetLocalId(), maxSpatialLayer);
 	}
 
+	void SendTransport::OnSetRtpEncodingParameters(const Producer* producer, const json& encodings)
+	{
+		MSC_TRACE();
+
+		return this->sendHandler->SetRtpEncodingParameters(producer->GetLocalId(), encodings);
+	}
+
+	void SendTransport::OnPause(const Producer* producer)
+	{
+		MSC_TRACE();
+
+		return this->sendHandler->PauseSending(producer->GetLocalId());
+	}
+
+	void SendTransport::OnResume(const Producer* producer)
+	{
+		MSC_TRACE();
+
+		return this->sendHandler->ResumeSending(producer->GetLocalId());
+	}
+
 	json SendTransport::OnGetStats(const Producer* producer)
 	{
 		MSC_TRACE();
@@ -398,6 +519,27 @@ namespace mediasoupclient
 		Transport::SetHandler(this->recvHandler.get());
 	}
 
+	/**
+	 * Receives over the PeerConnection of the given SendTransport, so a single
+	 * ICE/DTLS transport carries both directions.
+	 */
+	RecvTransport::RecvTransport(
+	  Listener* listener,
+	  SendTransport* sendTransport,
+	  const json* extendedRtpCapabilities,
+	  const json& appData)
+	  : Transport(listener, sendTransport->GetId(), extendedRtpCapabilities, appData)
+	{
+		MSC_TRACE();
+
+		this->hasSctpParameters = sendTransport->hasSctpParameters;
+
+		this->recvHandler.reset(new RecvHandler(
+		  dynamic_cast<RecvHandler::PrivateListener*>(this), sendTransport->sendHandler.get()));
+
+		Transport::SetHandler(this->recvHandler.get());
+	}
+
 	/**
 	 * Create a Consumer.
 	 */
@@ -407,53 +549,110 @@ namespace mediasoupclient
 	  const std::string& producerId,
 	  const std::string& kind,
 	  json* rtpParameters,
-	  const json& appData)
+	  const json& appData,
+	  absl::optional<double> latencyHint)
 	{
 		MSC_TRACE();
 
 		if (this->closed)
 			MSC_THROW_INVALID_STATE_ERROR("RecvTransport closed");
-		else if (id.empty())
-			MSC_THROW_TYPE_ERROR("missing id");
-		else if (producerId.empty())
-			MSC_THROW_TYPE_ERROR("missing producerId");
-		else if (kind != "audio" && kind != "video")
-			MSC_THROW_TYPE_ERROR("invalid kind");
 		else if (!rtpParameters)
 			MSC_THROW_TYPE_ERROR("missing rtpParameters");
-		else if (!appData.is_object())
-			MSC_THROW_TYPE_ERROR("appData must be a JSON object");
-		else if (!ortc::canReceive(*rtpParameters, *this->extendedRtpCapabilities))
-			MSC_THROW_UNSUPPORTED_ERROR("cannot consume this Producer");
+
+		ConsumeOptions options;
+
+		options.id            = id;
+		options.producerId    = producerId;
+		options.kind          = kind;
+		options.rtpParameters = *rtpParameters;
+		options.appData       = appData;
+		options.latencyHint   = latencyHint;
 
 		// May throw.
-		auto recvResult = this->recvHandler->Receive(id, kind, rtpParameters);
+		return Consume(consumerListener, std::vector<ConsumeOptions>{ options }).front();
+	}
 
-		auto* consumer = new Consumer(
-		  this,
-		  consumerListener,
-		  id,
-		  recvResult.localId,
-		  producerId,
-		  recvResult.rtpReceiver,
-		  recvResult.track,
-		  *rtpParameters,
-		  appData);
+	/**
+	 * Create several Consumers within a single SDP negotiation. They are returned
+	 * in the same order. If any of them cannot be created, none is.
+	 */
+	std::vector<Consumer*> RecvTransport::Consume(
+	  Consumer::Listener* consumerListener, const std::vector<ConsumeOptions>& optionsList)
+	{
+		MSC_TRACE();
+
+		if (this->closed)
+			MSC_THROW_INVALID_STATE_ERROR("RecvTransport closed");
+
+		// Check them all before touching anything.
+		for (const auto& options : optionsList)
+		{
+			if (options.id.empty())
+				MSC_THROW_TYPE_ERROR("missing id");
+			else if (options.producerId.empty())
+				MSC_THROW_TYPE_ERROR("missing producerId");
+			else if (options.kind != "audio" && options.kind != "video")
+				MSC_THROW_TYPE_ERROR("invalid kind");
+			else if (!options.rtpParameters.is_object())
+				MSC_THROW_TYPE_ERROR("missing rtpParameters");
+			else if (!options.appData.is_object())
+				MSC_THROW_TYPE_ERROR("appData must be a JSON object");
+			else if (
+			  options.latencyHint &&
+			  (!std::isfinite(*options.latencyHint) || *options.latencyHint < 0 ||
+			   *options.latencyHint > Consumer::MaxLatencyHint))
+				MSC_THROW_TYPE_ERROR("invalid latencyHint");
+			else if (!ortc::canReceive(options.rtpParameters, *this->extendedRtpCapabilities))
+				MSC_THROW_UNSUPPORTED_ERROR("cannot consume this Producer");
+		}
 
-		this->consumers[consumer->GetId()] = consumer;
+		std::vector<RecvHandler::ReceiveOptions> receiveOptionsList;
 
-		// If this is the first video Consumer and the Consumer for RTP probation
-		// has not yet been created, create it now.
-		if (!this->probatorConsumerCreated && kind == "video")
+		for (const auto& options : optionsList)
+		{
+			RecvHandler::ReceiveOptions receiveOptions;
+
+			receiveOptions.id            = options.id;
+			receiveOptions.kind          = options.kind;
+			receiveOptions.rtpParameters = options.rtpParameters;
+
+			receiveOptionsList.push_back(receiveOptions);
+		}
+
+		// If there is a video Consumer and the Consumer for RTP probation has not
+		// yet been created, negotiate it along with them.
+		auto videoOptionsIt =
+		  std::find_if(optionsList.begin(), optionsList.end(), [](const ConsumeOptions& options) {
+			  return options.kind == "video";
+		  });
+
+		if (!this->probatorConsumerCreated && videoOptionsIt != optionsList.end())
 		{
 			try
 			{
-				auto probatorRtpParameters =
-				  ortc::generateProbatorRtpParameters(consumer->GetRtpParameters());
-				std::string probatorId{ "probator" };
+				RecvHandler::ReceiveOptions probatorOptions;
+
+				probatorOptions.id            = "probator";
+				probatorOptions.kind          = "video";
+				probatorOptions.rtpParameters =
+				  ortc::generateProbatorRtpParameters(videoOptionsIt->rtpParameters);
+
+				receiveOptionsList.push_back(probatorOptions);
+			}
+			catch (std::runtime_error& error)
+			{
+				MSC_ERROR("failed to create Consumer for RTP probation: %s", error.what());
+			}
+		}
 
+		auto futures = this->recvHandler->ReceiveAsync(receiveOptionsList);
+
+		if (futures.size() > optionsList.size())
+		{
+			try
+			{
 				// May throw.
-				auto result = this->recvHandler->Receive(probatorId, kind, &probatorRtpParameters);
+				futures.back().get();
 
 				MSC_DEBUG("Consumer for RTP probation created");
 
@@ -465,7 +664,75 @@ namespace mediasoupclient
 			}
 		}
 
-		return consumer;
+		std::vector<RecvHandler::RecvResult> recvResults;
+		std::exception_ptr error;
+
+		for (size_t idx{ 0u }; idx < optionsList.size(); ++idx)
+		{
+			try
+			{
+				// May throw.
+				recvResults.push_back(futures[idx].get());
+			}
+			catch (...)
+			{
+				if (!error)
+					error = std::current_exception();
+			}
+		}
+
+		if (error)
+		{
+			// Stop receiving the tracks of the Consumers that could be created.
+			std::vector<std::string> localIds;
+
+			for (const auto& recvResult : recvResults)
+			{
+				localIds.push_back(recvResult.localId);
+			}
+
+			if (!localIds.empty())
+			{
+				try
+				{
+					this->recvHandler->StopReceiving(localIds);
+				}
+				catch (std::runtime_error& stopError)
+				{
+					MSC_WARN("failed to stop receiving: %s", stopError.what());
+				}
+			}
+
+			std::rethrow_exception(error);
+		}
+
+		std::vector<Consumer*> consumers;
+
+		for (size_t idx{ 0u }; idx < optionsList.size(); ++idx)
+		{
+			const auto& options    = optionsList[idx];
+			const auto& recvResult = recvResults[idx];
+
+			auto* consumer = new Consumer(
+			  this,
+			  consumerListener,
+			  options.id,
+			  recvResult.localId,
+			  options.producerId,
+			  recvResult.rtpReceiver,
+			  recvResult.track,
+			  options.rtpParameters,
+			  options.appData);
+
+			if (options.latencyHint)
+				consumer->SetLatencyHint(options.latencyHint);
+
+			this->consumers[consumer->GetId()] = consumer;
+
+			consumers.push_back(consumer);
+		}
+
+		return consumers;
 	}
 
 	/**
@@ -506,6 +773,80 @@ namespace mediasoupclient
 		return dataConsumer;
 	}
 
+	/**
+	 * Connects the transport before consuming by negotiating the SCTP
+	 * association or, if there are no SCTP parameters, the Consumer for RTP
+	 * probation.
+	 */
+	void RecvTransport::Connect()
+	{
+		MSC_TRACE();
+
+		if (this->closed)
+			MSC_THROW_INVALID_STATE_ERROR("RecvTransport closed");
+
+		if (this->hasSctpParameters)
+		{
+			// May throw.
+			this->recvHandler->Connect();
+
+			return;
+		}
+
+		if (this->probatorConsumerCreated)
+			return;
+
+		auto videoRtpParameters = ortc::getReceivingRtpParameters("video", *this->extendedRtpCapabilities);
+
+		if (videoRtpParameters["codecs"].empty())
+			MSC_THROW_UNSUPPORTED_ERROR("cannot connect without SctpParameters nor video codecs");
+
+		// May throw.
+		auto probatorRtpParameters = ortc::generateProbatorRtpParameters(videoRtpParameters);
+		std::string probatorId{ "probator" };
+
+		// May throw.
+		this->recvHandler->Receive(probatorId, "video", &probatorRtpParameters);
+
+		MSC_DEBUG("Consumer for RTP probation created");
+
+		this->probatorConsumerCreated = true;
+	}
+
+	/**
+	 * Closes the given Consumers within a single SDP renegotiation. Already
+	 * closed ones are ignored.
+	 */
+	void RecvTransport::CloseConsumers(const std::vector<Consumer*>& consumers)
+	{
+		MSC_TRACE();
+
+		for (auto* consumer : consumers)
+		{
+			if (!consumer->IsClosed() && this->consumers.find(consumer->GetId()) == this->consumers.end())
+				MSC_THROW_TYPE_ERROR("Consumer not found [id:%s]", consumer->GetId().c_str());
+		}
+
+		std::vector<std::string> localIds;
+
+		for (auto* consumer : consumers)
+		{
+			if (consumer->IsClosed())
+				continue;
+
+			consumer->closed = true;
+
+			this->consumers.erase(consumer->GetId());
+			localIds.push_back(consumer->GetLocalId());
+		}
+
+		if (this->closed)
+			return;
+
+		// May throw.
+		this->recvHandler->StopReceiving(localIds);
+	}
+
 	void RecvTransport::Close()
 	{
 		MSC_TRACE();
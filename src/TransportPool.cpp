@@ -0,0 +1,169 @@
+#define MSC_CLASS "TransportPool"
+
+#include "TransportPool.hpp"
+#include "Logger.hpp"
+#include "MediaSoupClientErrors.hpp"
+
+namespace mediasoupclient
+{
+	TransportPool::TransportPool(const PeerConnection::Options* peerConnectionOptions, size_t size)
+	  : size(size)
+	{
+		MSC_TRACE();
+
+		if (size == 0u)
+			MSC_THROW_TYPE_ERROR("invalid size");
+
+		if (peerConnectionOptions != nullptr)
+			this->peerConnectionOptions = *peerConnectionOptions;
+
+		// Pooled PeerConnections are never taken from another pool.
+		this->peerConnectionOptions.transportPool = nullptr;
+
+		// Make the PeerConnections gather ICE candidates as soon as they are created.
+		if (this->peerConnectionOptions.config.ice_candidate_pool_size == 0)
+			this->peerConnectionOptions.config.ice_candidate_pool_size = 1;
+	}
+
+	TransportPool::~TransportPool()
+	{
+		MSC_TRACE();
+
+		Close();
+	}
+
+	void TransportPool::Fill()
+	{
+		MSC_TRACE();
+
+		while (true)
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex);
+
+				if (this->closed)
+					MSC_THROW_INVALID_STATE_ERROR("TransportPool closed");
+
+				if (this->peerConnections.size() >= this->size)
+					return;
+			}
+
+			// Do not hold the lock while creating, so Acquire() is not blocked.
+			std::unique_ptr<PeerConnection> pc(PeerConnection::Create(nullptr, &this->peerConnectionOptions));
+
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			if (this->closed)
+			{
+				pc->Close();
+
+				MSC_THROW_INVALID_STATE_ERROR("TransportPool closed");
+			}
+
+			this->peerConnections.push_back(std::move(pc));
+		}
+	}
+
+	void TransportPool::Close()
+	{
+		MSC_TRACE();
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->closed)
+			return;
+
+		this->closed = true;
+
+		for (auto& pc : this->peerConnections)
+		{
+			pc->Close();
+		}
+
+		this->peerConnections.clear();
+	}
+
+	bool TransportPool::IsClosed() const
+	{
+		MSC_TRACE();
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		return this->closed;
+	}
+
+	size_t TransportPool::GetSize() const
+	{
+		MSC_TRACE();
+
+		return this->size;
+	}
+
+	size_t TransportPool::GetAvailable()
+	{
+		MSC_TRACE();
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		return this->peerConnections.size();
+	}
+
+	std::unique_ptr<PeerConnection> TransportPool::Acquire(
+	  PeerConnection::PrivateListener* privateListener,
+	  const PeerConnection::Options* peerConnectionOptions)
+	{
+		MSC_TRACE();
+
+		std::unique_ptr<PeerConnection> pc;
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			if (this->closed || this->peerConnections.empty())
+			{
+				MSC_DEBUG("no PeerConnection available");
+
+				return nullptr;
+			}
+
+			pc = std::move(this->peerConnections.front());
+
+			this->peerConnections.pop_front();
+		}
+
+		// Apply the configuration of the transport, keeping the settings the pooled
+		// PeerConnection was created with so it does not discard its gathered ICE
+		// candidates.
+		auto currentConfig = pc->GetConfiguration();
+		webrtc::PeerConnectionInterface::RTCConfiguration config;
+
+		if (peerConnectionOptions != nullptr)
+			config = peerConnectionOptions->config;
+
+		config.sdp_semantics = currentConfig.sdp_semantics;
+
+		if (config.ice_candidate_pool_size < currentConfig.ice_candidate_pool_size)
+			config.ice_candidate_pool_size = currentConfig.ice_candidate_pool_size;
+
+		if (peerConnectionOptions != nullptr && peerConnectionOptions->continualGathering)
+		{
+			config.continual_gathering_policy = webrtc::PeerConnectionInterface::GATHER_CONTINUALLY;
+
+			if (config.ice_candidate_pool_size < 2)
+				config.ice_candidate_pool_size = 2;
+		}
+
+		if (!pc->SetConfiguration(config))
+		{
+			MSC_WARN("cannot apply the transport configuration to a pooled PeerConnection");
+
+			pc->Close();
+
+			return nullptr;
+		}
+
+		pc->SetPrivateListener(privateListener);
+
+		return pc;
+	}
+} // namespace mediasoupclient
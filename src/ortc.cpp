@@ -6,10 +6,13 @@
 #include "media/base/codec.h"
 #include "media/base/sdp_video_format_utils.h"
 #include <api/video_codecs/h264_profile_level_id.h>
-#include <algorithm> // std::find_if
+#include <algorithm> // std::find_if, std::stable_sort
+#include <cctype>    // ::tolower
 #include <regex>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 using json = nlohmann::json;
 using namespace mediasoupclient;
@@ -1118,6 +1121,171 @@ namespace mediasoupclient
 			return extendedRtpCapabilities;
 		}
 
+		/**
+		 * Validates the profile given to Device::Load(). It may contain:
+		 *
+		 * - codecs: Array of allowed codec MIME types, in order of preference.
+		 * - headerExtensions: Array of allowed RTP header extension URIs.
+		 * - kinds: Array of allowed media kinds ("audio" and/or "video").
+		 */
+		void validateRtpCapabilitiesProfile(const json& profile)
+		{
+			MSC_TRACE();
+
+			if (!profile.is_object())
+				MSC_THROW_TYPE_ERROR("profile is not an object");
+
+			for (const auto* key : { "codecs", "headerExtensions", "kinds" })
+			{
+				auto it = profile.find(key);
+
+				if (it == profile.end())
+					continue;
+
+				if (!it->is_array())
+					MSC_THROW_TYPE_ERROR("profile.%s is not an array", key);
+
+				for (const auto& item : *it)
+				{
+					if (!item.is_string())
+						MSC_THROW_TYPE_ERROR("invalid profile.%s entry", key);
+				}
+			}
+
+			auto kindsIt = profile.find("kinds");
+
+			if (kindsIt != profile.end())
+			{
+				for (const auto& kind : *kindsIt)
+				{
+					if (kind != "audio" && kind != "video")
+						MSC_THROW_TYPE_ERROR("invalid profile.kinds entry");
+				}
+			}
+		}
+
+		/**
+		 * Removes from the extended RTP capabilities the codecs and header
+		 * extensions not allowed by the given profile, and sorts the codecs in the
+		 * order given by it. Every SDP media section gets smaller.
+		 */
+		void applyRtpCapabilitiesProfile(json& extendedRtpCapabilities, const json& profile)
+		{
+			MSC_TRACE();
+
+			// This may throw.
+			validateRtpCapabilitiesProfile(profile);
+
+			reduceRtpCapabilitiesKinds(extendedRtpCapabilities, getRtpCapabilitiesProfileKinds(profile));
+
+			auto codecsIt = profile.find("codecs");
+
+			if (codecsIt != profile.end())
+			{
+				std::vector<std::string> mimeTypes;
+
+				for (const auto& item : *codecsIt)
+				{
+					auto mimeType = item.get<std::string>();
+
+					std::transform(mimeType.begin(), mimeType.end(), mimeType.begin(), ::tolower);
+
+					mimeTypes.push_back(mimeType);
+				}
+
+				// Codecs paired with their position in the profile.
+				std::vector<std::pair<size_t, json>> codecs;
+
+				for (auto& codec : extendedRtpCapabilities["codecs"])
+				{
+					auto mimeType = codec["mimeType"].get<std::string>();
+
+					std::transform(mimeType.begin(), mimeType.end(), mimeType.begin(), ::tolower);
+
+					auto mimeTypeIt = std::find(mimeTypes.begin(), mimeTypes.end(), mimeType);
+
+					if (mimeTypeIt == mimeTypes.end())
+						continue;
+
+					codecs.emplace_back(mimeTypeIt - mimeTypes.begin(), std::move(codec));
+				}
+
+				// Keep the router order among codecs with same MIME type.
+				std::stable_sort(
+				  codecs.begin(),
+				  codecs.end(),
+				  [](const std::pair<size_t, json>& a, const std::pair<size_t, json>& b) {
+					  return a.first < b.first;
+				  });
+
+				extendedRtpCapabilities["codecs"] = json::array();
+
+				for (auto& codec : codecs)
+				{
+					extendedRtpCapabilities["codecs"].push_back(std::move(codec.second));
+				}
+			}
+
+			auto headerExtensionsIt = profile.find("headerExtensions");
+
+			if (headerExtensionsIt != profile.end())
+			{
+				auto& extendedExts = extendedRtpCapabilities["headerExtensions"];
+
+				extendedExts.erase(
+				  std::remove_if(
+				    extendedExts.begin(),
+				    extendedExts.end(),
+				    [&headerExtensionsIt](const json& extendedExt) {
+					    return std::find(
+					             headerExtensionsIt->begin(), headerExtensionsIt->end(), extendedExt["uri"]) ==
+					           headerExtensionsIt->end();
+				    }),
+				  extendedExts.end());
+			}
+		}
+
+		/**
+		 * Media kinds allowed by the given profile.
+		 */
+		std::vector<std::string> getRtpCapabilitiesProfileKinds(const json& profile)
+		{
+			MSC_TRACE();
+
+			auto kindsIt = profile.find("kinds");
+
+			if (kindsIt == profile.end())
+				return { "audio", "video" };
+
+			return kindsIt->get<std::vector<std::string>>();
+		}
+
+		/**
+		 * Removes the codecs and header extensions of other media kinds from the
+		 * given RTP capabilities or extended RTP capabilities.
+		 */
+		void reduceRtpCapabilitiesKinds(json& caps, const std::vector<std::string>& kinds)
+		{
+			MSC_TRACE();
+
+			auto isOtherKind = [&kinds](const json& item) {
+				auto kindIt = item.find("kind");
+
+				return kindIt != item.end() && kindIt->is_string() &&
+				       std::find(kinds.begin(), kinds.end(), kindIt->get<std::string>()) == kinds.end();
+			};
+
+			for (const auto* key : { "codecs", "headerExtensions" })
+			{
+				auto it = caps.find(key);
+
+				if (it == caps.end() || !it->is_array())
+					continue;
+
+				it->erase(std::remove_if(it->begin(), it->end(), isOtherKind), it->end());
+			}
+		}
+
 		/**
 		 * Generate RTP capabilities for receiving media based on the given extended
 		 * RTP capabilities.
@@ -1463,6 +1631,72 @@ namespace mediasoupclient
 			return rtpParameters;
 		}
 
+		/**
+		 * Generate RTP parameters of the given kind for receiving media.
+		 */
+		json getReceivingRtpParameters(const std::string& kind, const json& extendedRtpCapabilities)
+		{
+			MSC_TRACE();
+
+			// clang-format off
+			json rtpParameters =
+			{
+				{ "codecs",           json::array()  },
+				{ "headerExtensions", json::array()  },
+				{ "encodings",        json::array()  },
+				{ "rtcp",             json::object() }
+			};
+			// clang-format on
+
+			for (const auto& extendedCodec : extendedRtpCapabilities["codecs"])
+			{
+				if (kind != extendedCodec["kind"].get<std::string>())
+					continue;
+
+				// clang-format off
+				json codec =
+				{
+					{ "mimeType",     extendedCodec["mimeType"]          },
+					{ "payloadType",  extendedCodec["remotePayloadType"] },
+					{ "clockRate",    extendedCodec["clockRate"]         },
+					{ "parameters",   extendedCodec["remoteParameters"]  },
+					{ "rtcpFeedback", extendedCodec["rtcpFeedback"]      }
+				};
+				// clang-format on
+
+				if (extendedCodec.contains("channels"))
+					codec["channels"] = extendedCodec["channels"];
+
+				rtpParameters["codecs"].push_back(codec);
+			}
+
+			for (const auto& extendedExtension : extendedRtpCapabilities["headerExtensions"])
+			{
+				if (kind != extendedExtension["kind"].get<std::string>())
+					continue;
+
+				std::string direction = extendedExtension["direction"].get<std::string>();
+
+				// Ignore RTP extensions not valid for receiving.
+				if (direction != "sendrecv" && direction != "recvonly")
+					continue;
+
+				// clang-format off
+				json ext =
+				{
+					{ "uri",        extendedExtension["uri"]     },
+					{ "id",         extendedExtension["recvId"]  },
+					{ "encrypt",    extendedExtension["encrypt"] },
+					{ "parameters", json::object()               }
+				};
+				// clang-format on
+
+				rtpParameters["headerExtensions"].push_back(ext);
+			}
+
+			return rtpParameters;
+		}
+
 		/**
 		 * Create RTP parameters for a Consumer for the RTP probator.
 		 */
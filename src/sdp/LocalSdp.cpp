@@ -0,0 +1,298 @@
+#define MSC_CLASS "Sdp::LocalSdp"
+
+#include "sdp/LocalSdp.hpp"
+#include "Logger.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "sdp/Utils.hpp"
+#include <sdptransform.hpp>
+
+using json = nlohmann::json;
+
+// Static functions declaration.
+static absl::string_view nextLine(absl::string_view text, size_t& pos);
+
+namespace mediasoupclient
+{
+	/* Sdp::LocalSdp methods */
+
+	Sdp::LocalSdp::LocalSdp(std::string sdp) : sdp(std::move(sdp))
+	{
+		MSC_TRACE();
+
+		this->IndexMediaSections();
+	}
+
+	const std::string& Sdp::LocalSdp::GetSdp() const
+	{
+		MSC_TRACE();
+
+		return this->sdp;
+	}
+
+	size_t Sdp::LocalSdp::GetMediaSectionCount() const
+	{
+		MSC_TRACE();
+
+		return this->sections.size() - 1;
+	}
+
+	absl::optional<size_t> Sdp::LocalSdp::GetMediaSectionIdx(const std::string& mid) const
+	{
+		MSC_TRACE();
+
+		if (!this->midsIndexed)
+		{
+			for (size_t idx{ 0u }; idx < this->GetMediaSectionCount(); ++idx)
+			{
+				auto value = this->GetAttribute(idx, "mid");
+
+				if (value)
+					this->midToIndex[std::string(value->data(), value->size())] = idx;
+			}
+
+			this->midsIndexed = true;
+		}
+
+		auto idxIt = this->midToIndex.find(mid);
+
+		if (idxIt == this->midToIndex.end())
+			return absl::nullopt;
+
+		return idxIt->second;
+	}
+
+	absl::string_view Sdp::LocalSdp::GetMediaType(size_t idx) const
+	{
+		MSC_TRACE();
+
+		// m=<type> <port> <protocol> <payloads>
+		auto mediaLine = this->GetSection(idx + 1);
+		size_t pos{ 0u };
+
+		mediaLine = nextLine(mediaLine, pos).substr(2);
+
+		return mediaLine.substr(0, mediaLine.find(' '));
+	}
+
+	bool Sdp::LocalSdp::IsMediaSectionClosed(size_t idx) const
+	{
+		MSC_TRACE();
+
+		auto mediaLine = this->GetSection(idx + 1);
+		size_t pos{ 0u };
+
+		mediaLine = nextLine(mediaLine, pos);
+
+		auto portPos = mediaLine.find(' ');
+
+		return mediaLine.substr(portPos + 1, 2) == "0 ";
+	}
+
+	absl::optional<absl::string_view> Sdp::LocalSdp::GetSessionAttribute(absl::string_view name) const
+	{
+		MSC_TRACE();
+
+		return this->FindAttribute(this->GetSection(0), name);
+	}
+
+	absl::optional<absl::string_view> Sdp::LocalSdp::GetAttribute(size_t idx, absl::string_view name) const
+	{
+		MSC_TRACE();
+
+		return this->FindAttribute(this->GetSection(idx + 1), name);
+	}
+
+	std::vector<absl::string_view> Sdp::LocalSdp::GetAttributes(size_t idx, absl::string_view name) const
+	{
+		MSC_TRACE();
+
+		std::vector<absl::string_view> values;
+		auto section = this->GetSection(idx + 1);
+		size_t pos{ 0u };
+
+		while (pos < section.size())
+		{
+			auto line = nextLine(section, pos);
+
+			if (line.size() < name.size() + 2 || line.substr(0, 2) != "a=" || line.substr(2, name.size()) != name)
+				continue;
+
+			auto value = line.substr(2 + name.size());
+
+			if (value.empty())
+				values.push_back(value);
+			else if (value[0] == ':')
+				values.push_back(value.substr(1));
+		}
+
+		return values;
+	}
+
+	json Sdp::LocalSdp::ParseMediaSection(size_t idx) const
+	{
+		MSC_TRACE();
+
+		auto section = this->GetSection(idx + 1);
+
+		// Media attributes only depend on the lines of their media section.
+		auto sdpObject = sdptransform::parse(std::string(section.data(), section.size()));
+
+		return sdpObject["media"][0];
+	}
+
+	void Sdp::LocalSdp::SetMediaSection(size_t idx, const json& mediaObject)
+	{
+		MSC_TRACE();
+
+		// May throw.
+		this->GetSection(idx + 1);
+
+		const auto& section = this->sections[idx + 1];
+
+		this->sdp.replace(section.first, section.second - section.first, Sdp::Utils::writeMediaObject(mediaObject));
+
+		// Offsets of the following media sections have changed.
+		this->IndexMediaSections();
+		this->midToIndex.clear();
+		this->midsIndexed = false;
+	}
+
+	json Sdp::LocalSdp::ExtractDtlsParameters() const
+	{
+		MSC_TRACE();
+
+		absl::optional<absl::string_view> fingerprint;
+		absl::optional<absl::string_view> setup;
+
+		for (size_t idx{ 0u }; idx < this->GetMediaSectionCount(); ++idx)
+		{
+			if (!this->GetAttribute(idx, "ice-ufrag") || this->IsMediaSectionClosed(idx))
+				continue;
+
+			fingerprint = this->GetAttribute(idx, "fingerprint");
+			setup       = this->GetAttribute(idx, "setup");
+
+			break;
+		}
+
+		if (!fingerprint)
+			fingerprint = this->GetSessionAttribute("fingerprint");
+
+		if (!fingerprint)
+			MSC_THROW_ERROR("no a=fingerprint line found");
+
+		std::string role;
+
+		if (setup && *setup == "active")
+			role = "client";
+		else if (setup && *setup == "passive")
+			role = "server";
+		else if (setup && *setup == "actpass")
+			role = "auto";
+
+		// a=fingerprint:<type> <hash>
+		auto spacePos = fingerprint->find(' ');
+
+		// clang-format off
+		json dtlsParameters =
+		{
+			{ "role",         role },
+			{ "fingerprints",
+				{
+					{
+						{ "algorithm", std::string(fingerprint->substr(0, spacePos)) },
+						{ "value",     std::string(fingerprint->substr(spacePos + 1)) }
+					}
+				}
+			}
+		};
+		// clang-format on
+
+		return dtlsParameters;
+	}
+
+	void Sdp::LocalSdp::IndexMediaSections()
+	{
+		MSC_TRACE();
+
+		this->sections.clear();
+
+		absl::string_view text(this->sdp);
+		size_t sectionBegin{ 0u };
+		size_t pos{ 0u };
+
+		while (pos < text.size())
+		{
+			auto lineBegin = pos;
+			auto line      = nextLine(text, pos);
+
+			if (line.substr(0, 2) != "m=")
+				continue;
+
+			this->sections.emplace_back(sectionBegin, lineBegin);
+			sectionBegin = lineBegin;
+		}
+
+		this->sections.emplace_back(sectionBegin, text.size());
+	}
+
+	absl::string_view Sdp::LocalSdp::GetSection(size_t sectionIdx) const
+	{
+		MSC_TRACE();
+
+		if (sectionIdx >= this->sections.size())
+			MSC_THROW_ERROR("media section not found [idx:%zu]", sectionIdx - 1);
+
+		const auto& section = this->sections[sectionIdx];
+
+		return absl::string_view(this->sdp).substr(section.first, section.second - section.first);
+	}
+
+	absl::optional<absl::string_view> Sdp::LocalSdp::FindAttribute(
+	  absl::string_view section, absl::string_view name) const
+	{
+		MSC_TRACE();
+
+		size_t pos{ 0u };
+
+		while (pos < section.size())
+		{
+			auto line = nextLine(section, pos);
+
+			if (line.size() < name.size() + 2 || line.substr(0, 2) != "a=" || line.substr(2, name.size()) != name)
+				continue;
+
+			auto value = line.substr(2 + name.size());
+
+			if (value.empty())
+				return value;
+			else if (value[0] == ':')
+				return value.substr(1);
+		}
+
+		return absl::nullopt;
+	}
+} // namespace mediasoupclient
+
+// Private helpers used in this file.
+
+/**
+ * Line starting at the given position, without its line break. The position
+ * is moved to the beginning of the next line.
+ */
+static absl::string_view nextLine(absl::string_view text, size_t& pos)
+{
+	auto end = text.find('\n', pos);
+
+	if (end == absl::string_view::npos)
+		end = text.size();
+
+	auto line = text.substr(pos, end - pos);
+
+	pos = end + 1;
+
+	if (!line.empty() && line.back() == '\r')
+		line.remove_suffix(1);
+
+	return line;
+}
@@ -51,11 +51,11 @@ namespace mediasoupclient
 			this->mediaObject["iceOptions"]      = "renomination";
 		}
 
-		std::string MediaSection::GetMid() const
+		const std::string& MediaSection::GetMid() const
 		{
 			MSC_TRACE();
 
-			return this->mediaObject["mid"].get<std::string>();
+			return this->mediaObject["mid"].get_ref<const std::string&>();
 		}
 
 		bool MediaSection::IsClosed() const
@@ -65,7 +65,7 @@ namespace mediasoupclient
 			return this->mediaObject["port"] == 0;
 		}
 
-		json MediaSection::GetObject() const
+		const json& MediaSection::GetObject() const
 		{
 			MSC_TRACE();
 
@@ -80,6 +80,23 @@ namespace mediasoupclient
 			this->mediaObject["icePwd"]   = iceParameters["password"];
 		}
 
+		void MediaSection::RemoveIceParameters()
+		{
+			MSC_TRACE();
+
+			this->mediaObject.erase("iceUfrag");
+			this->mediaObject.erase("icePwd");
+			this->mediaObject.erase("iceOptions");
+		}
+
+		void MediaSection::RemoveIceCandidates()
+		{
+			MSC_TRACE();
+
+			this->mediaObject.erase("candidates");
+			this->mediaObject.erase("endOfCandidates");
+		}
+
 		void MediaSection::Disable()
 		{
 			MSC_TRACE();
@@ -108,6 +125,18 @@ namespace mediasoupclient
 			this->mediaObject.erase("extmapAllowMixed");
 		}
 
+		void MediaSection::ForceDtlsRole(const std::string& role)
+		{
+			MSC_TRACE();
+
+			if (role == "client")
+				this->mediaObject["setup"] = "active";
+			else if (role == "server")
+				this->mediaObject["setup"] = "passive";
+			else if (role == "auto")
+				this->mediaObject["setup"] = "actpass";
+		}
+
 		AnswerMediaSection::AnswerMediaSection(
 		  const json& iceParameters,
 		  const json& iceCandidates,
@@ -400,12 +429,7 @@ namespace mediasoupclient
 		{
 			MSC_TRACE();
 
-			if (role == "client")
-				this->mediaObject["setup"] = "active";
-			else if (role == "server")
-				this->mediaObject["setup"] = "passive";
-			else if (role == "auto")
-				this->mediaObject["setup"] = "actpass";
+			this->ForceDtlsRole(role);
 		}
 
 		OfferMediaSection::OfferMediaSection(
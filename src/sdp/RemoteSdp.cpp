@@ -2,6 +2,8 @@
 
 #include "sdp/RemoteSdp.hpp"
 #include "Logger.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "sdp/Utils.hpp"
 #include "algorithm" // find_if.
 #include "sdptransform.hpp"
 
@@ -77,13 +79,35 @@ namespace mediasoupclient
 		// clang-format on
 	}
 
-	Sdp::RemoteSdp::~RemoteSdp()
+	void Sdp::RemoteSdp::SetMixedRoles()
 	{
 		MSC_TRACE();
 
-		for (const auto* mediaSection : this->mediaSections)
+		this->mixedRoles = true;
+
+		for (auto idx{ 0u }; idx < this->mediaSections.size(); ++idx)
 		{
-			delete mediaSection;
+			this->ApplyMixedDtlsRole(this->mediaSections[idx].get());
+
+			// Update SDP media section.
+			this->UpdateMediaObject(idx);
+		}
+	}
+
+	void Sdp::RemoteSdp::SetCompact()
+	{
+		MSC_TRACE();
+
+		this->compact = true;
+
+		this->SetSessionIceParameters();
+
+		for (auto idx{ 0u }; idx < this->mediaSections.size(); ++idx)
+		{
+			this->ApplyCompactTransport(idx);
+
+			// Update SDP media section.
+			this->UpdateMediaObject(idx);
 		}
 	}
 
@@ -96,14 +120,20 @@ namespace mediasoupclient
 		if (iceParameters.find("iceLite") != iceParameters.end())
 			sdpObject["icelite"] = "ice-lite";
 
-		for (auto idx{ 0u }; idx < this->mediaSections.size(); ++idx)
+		// Media sections do not carry ICE parameters in compact mode.
+		if (this->compact)
 		{
-			auto* mediaSection = this->mediaSections[idx];
+			this->SetSessionIceParameters();
+
+			return;
+		}
 
-			mediaSection->SetIceParameters(iceParameters);
+		for (auto idx{ 0u }; idx < this->mediaSections.size(); ++idx)
+		{
+			this->mediaSections[idx]->SetIceParameters(iceParameters);
 
 			// Update SDP media section.
-			this->sdpObject["media"][idx] = mediaSection->GetObject();
+			this->UpdateMediaObject(idx);
 		}
 	}
 
@@ -118,30 +148,39 @@ namespace mediasoupclient
 
 		for (auto idx{ 0u }; idx < this->mediaSections.size(); ++idx)
 		{
-			auto* mediaSection = this->mediaSections[idx];
+			auto& mediaSection = this->mediaSections[idx];
 
-			mediaSection->SetDtlsRole(role);
+			// Offer media sections must also honor the role once it is known.
+			if (this->mixedRoles)
+				mediaSection->ForceDtlsRole(role);
+			else
+				mediaSection->SetDtlsRole(role);
 
 			// Update SDP media section.
-			this->sdpObject["media"][idx] = mediaSection->GetObject();
+			this->UpdateMediaObject(idx);
 		}
 	}
 
-	Sdp::RemoteSdp::MediaSectionIdx Sdp::RemoteSdp::GetNextMediaSectionIdx()
+	Sdp::RemoteSdp::MediaSectionIdx Sdp::RemoteSdp::GetNextMediaSectionIdx(size_t skip)
 	{
 		MSC_TRACE();
 
 		// If a closed media section is found, return its index.
 		for (auto idx{ 0u }; idx < this->mediaSections.size(); ++idx)
 		{
-			auto* mediaSection = this->mediaSections[idx];
+			const auto& mediaSection = this->mediaSections[idx];
 
-			if (mediaSection->IsClosed())
+			if (!mediaSection->IsClosed())
+				continue;
+
+			if (skip == 0u)
 				return { idx, mediaSection->GetMid() };
+
+			--skip;
 		}
 
 		// If no closed media section is found, return next one.
-		return { this->mediaSections.size() };
+		return { this->mediaSections.size() + skip };
 	}
 
 	void Sdp::RemoteSdp::Send(
@@ -153,7 +192,7 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 
-		auto* mediaSection = new AnswerMediaSection(
+		std::unique_ptr<MediaSection> mediaSection(new AnswerMediaSection(
 		  this->iceParameters,
 		  this->iceCandidates,
 		  this->dtlsParameters,
@@ -161,23 +200,23 @@ namespace mediasoupclient
 		  offerMediaObject,
 		  offerRtpParameters,
 		  answerRtpParameters,
-		  codecOptions);
+		  codecOptions));
 
 		// Closed media section replacement.
 		if (!reuseMid.empty())
 		{
-			this->ReplaceMediaSection(mediaSection, reuseMid);
+			this->ReplaceMediaSection(std::move(mediaSection), reuseMid);
 		}
 		else
 		{
-			this->AddMediaSection(mediaSection);
+			this->AddMediaSection(std::move(mediaSection));
 		}
 	}
 
 	void Sdp::RemoteSdp::SendSctpAssociation(json& offerMediaObject)
 	{
 		nlohmann::json emptyJson;
-		auto* mediaSection = new AnswerMediaSection(
+		std::unique_ptr<MediaSection> mediaSection(new AnswerMediaSection(
 		  this->iceParameters,
 		  this->iceCandidates,
 		  this->dtlsParameters,
@@ -185,15 +224,15 @@ namespace mediasoupclient
 		  offerMediaObject,
 		  emptyJson,
 		  emptyJson,
-		  nullptr);
+		  nullptr));
 
-		this->AddMediaSection(mediaSection);
+		this->AddMediaSection(std::move(mediaSection));
 	}
 
 	void Sdp::RemoteSdp::RecvSctpAssociation()
 	{
 		nlohmann::json emptyJson;
-		auto* mediaSection = new OfferMediaSection(
+		std::unique_ptr<MediaSection> mediaSection(new OfferMediaSection(
 		  this->iceParameters,
 		  this->iceCandidates,
 		  this->dtlsParameters,
@@ -203,8 +242,9 @@ namespace mediasoupclient
 		  emptyJson,     // offerRtpParameters
 		  "",            // streamId
 		  ""             // trackId
-		);
-		this->AddMediaSection(mediaSection);
+		  ));
+		this->ApplyMixedDtlsRole(mediaSection.get());
+		this->AddMediaSection(std::move(mediaSection));
 	}
 
 	void Sdp::RemoteSdp::Receive(
@@ -216,7 +256,7 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 
-		auto* mediaSection = new OfferMediaSection(
+		std::unique_ptr<MediaSection> mediaSection(new OfferMediaSection(
 		  this->iceParameters,
 		  this->iceCandidates,
 		  this->dtlsParameters,
@@ -225,22 +265,27 @@ namespace mediasoupclient
 		  kind,
 		  offerRtpParameters,
 		  streamId,
-		  trackId);
+		  trackId));
+
+		this->ApplyMixedDtlsRole(mediaSection.get());
 
 		// Let's try to recycle a closed media section (if any).
 		// NOTE: We can recycle a closed m=audio section with a new m=video.
 		auto mediaSectionIt = find_if(
-		  this->mediaSections.begin(), this->mediaSections.end(), [](const MediaSection* mediaSection) {
-			  return mediaSection->IsClosed();
-		  });
+		  this->mediaSections.begin(),
+		  this->mediaSections.end(),
+		  [](const std::unique_ptr<MediaSection>& mediaSection) { return mediaSection->IsClosed(); });
 
 		if (mediaSectionIt != this->mediaSections.end())
 		{
-			this->ReplaceMediaSection(mediaSection, (*mediaSectionIt)->GetMid());
+			// Copied since the closed media section is going to be deleted.
+			auto reuseMid = (*mediaSectionIt)->GetMid();
+
+			this->ReplaceMediaSection(std::move(mediaSection), reuseMid);
 		}
 		else
 		{
-			this->AddMediaSection(mediaSection);
+			this->AddMediaSection(std::move(mediaSection));
 		}
 	}
 
@@ -248,10 +293,12 @@ namespace mediasoupclient
 	{
 		MSC_TRACE();
 
-		const auto idx     = this->midToIndex[mid];
-		auto* mediaSection = this->mediaSections[idx];
+		const auto idx = this->midToIndex[mid];
 
-		mediaSection->Disable();
+		this->mediaSections[idx]->Disable();
+
+		// Update SDP media section.
+		this->UpdateMediaObject(idx);
 	}
 
 	void Sdp::RemoteSdp::CloseMediaSection(const std::string& mid)
@@ -259,7 +306,7 @@ namespace mediasoupclient
 		MSC_TRACE();
 
 		const auto idx     = this->midToIndex[mid];
-		auto* mediaSection = this->mediaSections[idx];
+		auto& mediaSection = this->mediaSections[idx];
 
 		// NOTE: Closing the first m section is a pain since it invalidates the
 		// bundled transport, so let's avoid it.
@@ -269,12 +316,31 @@ namespace mediasoupclient
 			mediaSection->Close();
 
 		// Update SDP media section.
-		this->sdpObject["media"][idx] = mediaSection->GetObject();
+		this->UpdateMediaObject(idx);
 
 		// Regenerate BUNDLE mids.
 		this->RegenerateBundleMids();
 	}
 
+	bool Sdp::RemoteSdp::HasMediaSection(const std::string& mid) const
+	{
+		MSC_TRACE();
+
+		return this->midToIndex.find(mid) != this->midToIndex.end();
+	}
+
+	size_t Sdp::RemoteSdp::GetMediaSectionIdx(const std::string& mid) const
+	{
+		MSC_TRACE();
+
+		auto idxIt = this->midToIndex.find(mid);
+
+		if (idxIt == this->midToIndex.end())
+			MSC_THROW_ERROR("media section not found [mid:%s]", mid.c_str());
+
+		return idxIt->second;
+	}
+
 	std::string Sdp::RemoteSdp::GetSdp()
 	{
 		MSC_TRACE();
@@ -284,77 +350,134 @@ namespace mediasoupclient
 
 		this->sdpObject["origin"]["sessionVersion"] = ++version;
 
-		return sdptransform::write(this->sdpObject);
+		// Write the session level lines alone.
+		auto sessionSdp = sdptransform::write(this->sdpObject);
+
+		size_t size{ sessionSdp.size() };
+
+		for (size_t idx{ 0u }; idx < this->mediaSdps.size(); ++idx)
+		{
+			// Just write the media sections that changed.
+			if (this->mediaSdps[idx].empty())
+				this->mediaSdps[idx] = Sdp::Utils::writeMediaObject(this->mediaSections[idx]->GetObject());
+
+			size += this->mediaSdps[idx].size();
+		}
+
+		std::string sdp;
+
+		sdp.reserve(size);
+		sdp.append(sessionSdp);
+
+		for (const auto& mediaSdp : this->mediaSdps)
+		{
+			sdp.append(mediaSdp);
+		}
+
+		return sdp;
 	}
 
-	void Sdp::RemoteSdp::AddMediaSection(MediaSection* newMediaSection)
+	void Sdp::RemoteSdp::AddMediaSection(std::unique_ptr<MediaSection> newMediaSection)
 	{
 		MSC_TRACE();
 
 		if (this->firstMid.empty())
 			this->firstMid = newMediaSection->GetMid();
 
-		// Add it in the vector.
-		this->mediaSections.push_back(newMediaSection);
-
 		// Add to the map.
-		this->midToIndex[newMediaSection->GetMid()] = this->mediaSections.size() - 1;
+		this->midToIndex[newMediaSection->GetMid()] = this->mediaSections.size();
+
+		// Add it in the vector.
+		this->mediaSections.push_back(std::move(newMediaSection));
+		this->mediaSdps.emplace_back();
 
-		// Add to the SDP object.
-		this->sdpObject["media"].push_back(newMediaSection->GetObject());
+		this->ApplyCompactTransport(this->mediaSections.size() - 1);
 
 		this->RegenerateBundleMids();
 	}
 
-	void Sdp::RemoteSdp::ReplaceMediaSection(MediaSection* newMediaSection, const std::string& reuseMid)
+	void Sdp::RemoteSdp::ReplaceMediaSection(
+	  std::unique_ptr<MediaSection> newMediaSection, const std::string& reuseMid)
 	{
 		MSC_TRACE();
 
 		// Store it in the map.
 		if (!reuseMid.empty())
 		{
-			const auto idx              = this->midToIndex[reuseMid];
-			auto* const oldMediaSection = this->mediaSections[idx];
-
-			// Replace the index in the vector with the new media section.
-			this->mediaSections[idx] = newMediaSection;
+			const auto idx = this->midToIndex[reuseMid];
 
 			// Update the map.
-			this->midToIndex.erase(oldMediaSection->GetMid());
+			this->midToIndex.erase(reuseMid);
 			this->midToIndex[newMediaSection->GetMid()] = idx;
 
-			// Delete old MediaSection.
-			delete oldMediaSection;
+			// Replace the index in the vector with the new media section, deleting
+			// the old one.
+			this->mediaSections[idx] = std::move(newMediaSection);
+
+			this->ApplyCompactTransport(idx);
 
 			// Update the SDP object.
-			this->sdpObject["media"][idx] = newMediaSection->GetObject();
+			this->UpdateMediaObject(idx);
 
 			// Regenerate BUNDLE mids.
 			this->RegenerateBundleMids();
 		}
 		else
 		{
-			const auto idx              = this->midToIndex[newMediaSection->GetMid()];
-			auto* const oldMediaSection = this->mediaSections[idx];
+			const auto idx = this->midToIndex[newMediaSection->GetMid()];
 
-			// Replace the index in the vector with the new media section.
-			this->mediaSections[idx] = newMediaSection;
+			// Replace the index in the vector with the new media section, deleting
+			// the old one.
+			this->mediaSections[idx] = std::move(newMediaSection);
 
-			// Delete old MediaSection.
-			delete oldMediaSection;
+			this->ApplyCompactTransport(idx);
 
 			// Update the SDP object.
-			this->sdpObject["media"][this->mediaSections.size() - 1] = newMediaSection->GetObject();
+			this->UpdateMediaObject(idx);
 		}
 	}
 
+	void Sdp::RemoteSdp::UpdateMediaObject(size_t idx)
+	{
+		MSC_TRACE();
+
+		// Written again on next GetSdp().
+		this->mediaSdps[idx].clear();
+	}
+
+	void Sdp::RemoteSdp::ApplyCompactTransport(size_t idx)
+	{
+		MSC_TRACE();
+
+		if (!this->compact)
+			return;
+
+		auto& mediaSection = this->mediaSections[idx];
+
+		// ICE parameters are given at session level.
+		mediaSection->RemoveIceParameters();
+
+		// The first media section is never closed so it is the BUNDLE tagged one.
+		if (idx != 0u)
+			mediaSection->RemoveIceCandidates();
+	}
+
+	void Sdp::RemoteSdp::SetSessionIceParameters()
+	{
+		MSC_TRACE();
+
+		this->sdpObject["iceUfrag"]   = this->iceParameters["usernameFragment"];
+		this->sdpObject["icePwd"]     = this->iceParameters["password"];
+		this->sdpObject["iceOptions"] = "renomination";
+	}
+
 	void Sdp::RemoteSdp::RegenerateBundleMids()
 	{
 		MSC_TRACE();
 
 		std::string mids;
 
-		for (const auto* mediaSection : this->mediaSections)
+		for (const auto& mediaSection : this->mediaSections)
 		{
 			if (!mediaSection->IsClosed())
 			{
@@ -367,4 +490,22 @@ namespace mediasoupclient
 
 		this->sdpObject["groups"][0]["mids"] = mids;
 	}
+
+	/**
+	 * With mixed roles the SDP is given as an answer too, so an offer media
+	 * section must not stay in a=setup:actpass once the DTLS role is known.
+	 */
+	void Sdp::RemoteSdp::ApplyMixedDtlsRole(MediaSection* mediaSection) const
+	{
+		MSC_TRACE();
+
+		if (!this->mixedRoles)
+			return;
+
+		auto roleIt = this->dtlsParameters.find("role");
+
+		if (roleIt != this->dtlsParameters.end() && roleIt->is_string())
+			mediaSection->ForceDtlsRole(roleIt->get<std::string>());
+	}
 } // namespace mediasoupclient
+
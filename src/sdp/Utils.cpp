@@ -550,6 +550,29 @@ namespace mediasoupclient
 					fmtp["config"] = config.str();
 				}
 			}
+
+			/**
+			 * sdptransform::write() writes the session lines and then each media
+			 * section on its own, so the lines of a media section do not depend on
+			 * the rest of the SDP.
+			 */
+			std::string writeMediaObject(const json& mediaObject)
+			{
+				MSC_TRACE();
+
+				// clang-format off
+				json sdpObject =
+				{
+					{ "version", 0                            },
+					{ "name",    "-"                          },
+					{ "media",   json::array({ mediaObject }) }
+				};
+				// clang-format on
+
+				auto sdp = sdptransform::write(sdpObject);
+
+				return sdp.substr(sdp.find("\r\nm=") + 2);
+			}
 		} // namespace Utils
 	}   // namespace Sdp
 } // namespace mediasoupclient
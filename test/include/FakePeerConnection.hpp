@@ -0,0 +1,262 @@
+#ifndef MSC_TEST_FAKE_PEERCONNECTION_HPP
+#define MSC_TEST_FAKE_PEERCONNECTION_HPP
+
+#include "PeerConnection.hpp"
+#include <json.hpp>
+#include <api/data_channel_interface.h>
+#include <api/media_stream_interface.h>
+#include <api/rtp_receiver_interface.h>
+#include <api/rtp_sender_interface.h>
+#include <api/rtp_transceiver_interface.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Deterministic in-memory PeerConnection. It produces canned SDP offers and
+ * answers with stable MIDs and keeps fake transceivers, so the library logic
+ * (ortc, RemoteSdp, Handler bookkeeping) can be exercised and benchmarked
+ * without libwebrtc negotiation costs. No media nor network is involved.
+ */
+
+class FakeMediaStreamTrack : public webrtc::MediaStreamTrackInterface
+{
+public:
+	FakeMediaStreamTrack(const std::string& kind, const std::string& id);
+
+	/* Virtual methods inherited from webrtc::MediaStreamTrackInterface. */
+public:
+	std::string kind() const override;
+	std::string id() const override;
+	bool enabled() const override;
+	bool set_enabled(bool enable) override;
+	TrackState state() const override;
+	void RegisterObserver(webrtc::ObserverInterface* observer) override;
+	void UnregisterObserver(webrtc::ObserverInterface* observer) override;
+
+private:
+	std::string trackKind;
+	std::string trackId;
+	bool isEnabled{ true };
+};
+
+class FakeRtpSender : public webrtc::RtpSenderInterface
+{
+public:
+	FakeRtpSender(
+	  cricket::MediaType mediaType,
+	  rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track,
+	  const std::vector<webrtc::RtpEncodingParameters>& encodings);
+
+	/* Virtual methods inherited from webrtc::RtpSenderInterface. */
+public:
+	bool SetTrack(webrtc::MediaStreamTrackInterface* track) override;
+	rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track() const override;
+	rtc::scoped_refptr<webrtc::DtlsTransportInterface> dtls_transport() const override;
+	uint32_t ssrc() const override;
+	cricket::MediaType media_type() const override;
+	std::string id() const override;
+	std::vector<std::string> stream_ids() const override;
+	void SetStreams(const std::vector<std::string>& streamIds) override;
+	std::vector<webrtc::RtpEncodingParameters> init_send_encodings() const override;
+	webrtc::RtpParameters GetParameters() const override;
+	webrtc::RTCError SetParameters(const webrtc::RtpParameters& parameters) override;
+	rtc::scoped_refptr<webrtc::DtmfSenderInterface> GetDtmfSender() const override;
+	void SetFrameEncryptor(rtc::scoped_refptr<webrtc::FrameEncryptorInterface> frameEncryptor) override;
+	rtc::scoped_refptr<webrtc::FrameEncryptorInterface> GetFrameEncryptor() const override;
+
+private:
+	cricket::MediaType mediaType;
+	rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> currentTrack;
+	std::vector<std::string> streamIds;
+	webrtc::RtpParameters parameters;
+	std::vector<webrtc::RtpEncodingParameters> initEncodings;
+};
+
+class FakeRtpReceiver : public webrtc::RtpReceiverInterface
+{
+public:
+	FakeRtpReceiver(cricket::MediaType mediaType, rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track);
+
+	/* Virtual methods inherited from webrtc::RtpReceiverInterface. */
+public:
+	rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track() const override;
+	std::vector<std::string> stream_ids() const override;
+	cricket::MediaType media_type() const override;
+	std::string id() const override;
+	webrtc::RtpParameters GetParameters() const override;
+	void SetObserver(webrtc::RtpReceiverObserverInterface* observer) override;
+	void SetJitterBufferMinimumDelay(absl::optional<double> delaySeconds) override;
+
+public:
+	// Last value given to SetJitterBufferMinimumDelay().
+	absl::optional<double> jitterBufferMinimumDelay;
+
+private:
+	cricket::MediaType mediaType;
+	rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> currentTrack;
+};
+
+class FakeRtpTransceiver : public webrtc::RtpTransceiverInterface
+{
+public:
+	FakeRtpTransceiver(
+	  cricket::MediaType mediaType,
+	  webrtc::RtpTransceiverDirection direction,
+	  rtc::scoped_refptr<webrtc::RtpSenderInterface> sender,
+	  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver);
+
+	void SetMid(const std::string& mid);
+	void SetStopped();
+
+	/* Virtual methods inherited from webrtc::RtpTransceiverInterface. */
+public:
+	cricket::MediaType media_type() const override;
+	absl::optional<std::string> mid() const override;
+	rtc::scoped_refptr<webrtc::RtpSenderInterface> sender() const override;
+	rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver() const override;
+	bool stopped() const override;
+	bool stopping() const override;
+	webrtc::RtpTransceiverDirection direction() const override;
+	webrtc::RTCError SetDirectionWithError(webrtc::RtpTransceiverDirection newDirection) override;
+	absl::optional<webrtc::RtpTransceiverDirection> current_direction() const override;
+	webrtc::RTCError StopStandard() override;
+	void StopInternal() override;
+
+private:
+	cricket::MediaType mediaType;
+	webrtc::RtpTransceiverDirection transceiverDirection;
+	rtc::scoped_refptr<webrtc::RtpSenderInterface> transceiverSender;
+	rtc::scoped_refptr<webrtc::RtpReceiverInterface> transceiverReceiver;
+	absl::optional<std::string> transceiverMid;
+	bool isStopped{ false };
+};
+
+class FakeDataChannel : public webrtc::DataChannelInterface
+{
+public:
+	FakeDataChannel(const std::string& label, const webrtc::DataChannelInit& config);
+
+	/* Virtual methods inherited from webrtc::DataChannelInterface. */
+public:
+	void RegisterObserver(webrtc::DataChannelObserver* observer) override;
+	void UnregisterObserver() override;
+	std::string label() const override;
+	bool reliable() const override;
+	bool ordered() const override;
+	std::string protocol() const override;
+	bool negotiated() const override;
+	int id() const override;
+	DataState state() const override;
+	uint32_t messages_sent() const override;
+	uint64_t bytes_sent() const override;
+	uint32_t messages_received() const override;
+	uint64_t bytes_received() const override;
+	uint64_t buffered_amount() const override;
+	void Close() override;
+	bool Send(const webrtc::DataBuffer& buffer) override;
+
+private:
+	std::string channelLabel;
+	webrtc::DataChannelInit config;
+	DataState channelState{ kOpen };
+	uint32_t messagesSent{ 0u };
+	uint64_t bytesSent{ 0u };
+};
+
+class FakePeerConnection : public mediasoupclient::PeerConnection
+{
+public:
+	class Backend : public mediasoupclient::PeerConnection::Backend
+	{
+	public:
+		mediasoupclient::PeerConnection* CreatePeerConnection(
+		  mediasoupclient::PeerConnection::PrivateListener* privateListener,
+		  const mediasoupclient::PeerConnection::Options* options) override;
+		nlohmann::json GetNativeCodecs(
+		  const mediasoupclient::PeerConnection::Options* options) const override;
+
+	public:
+		// Last PeerConnection created, owned by whoever took it.
+		FakePeerConnection* lastPeerConnection{ nullptr };
+		// Codecs of the created PeerConnections.
+		nlohmann::json nativeCodecs = nlohmann::json::object();
+	};
+
+public:
+	FakePeerConnection(PrivateListener* privateListener, const Options* options);
+
+	/* Virtual methods inherited from mediasoupclient::PeerConnection. */
+public:
+	void SetPrivateListener(PrivateListener* privateListener) override;
+	void Close() override;
+	webrtc::PeerConnectionInterface::RTCConfiguration GetConfiguration() const override;
+	bool SetConfiguration(const webrtc::PeerConnectionInterface::RTCConfiguration& config) override;
+	std::string CreateOffer(const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& options) override;
+	std::string CreateAnswer(const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& options) override;
+	void SetLocalDescription(PeerConnection::SdpType type, const std::string& sdp) override;
+	void SetRemoteDescription(PeerConnection::SdpType type, const std::string& sdp) override;
+	const std::string GetLocalDescription() override;
+	const std::string GetRemoteDescription() override;
+	std::vector<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>> GetTransceivers() const override;
+	rtc::scoped_refptr<webrtc::RtpTransceiverInterface> AddTransceiver(
+	  cricket::MediaType mediaType) override;
+	rtc::scoped_refptr<webrtc::RtpTransceiverInterface> AddTransceiver(
+	  rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track,
+	  webrtc::RtpTransceiverInit rtpTransceiverInit) override;
+	std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> GetSenders() override;
+	bool RemoveTrack(webrtc::RtpSenderInterface* sender) override;
+	nlohmann::json GetStats() override;
+	nlohmann::json GetStats(rtc::scoped_refptr<webrtc::RtpSenderInterface> selector) override;
+	nlohmann::json GetStats(rtc::scoped_refptr<webrtc::RtpReceiverInterface> selector) override;
+	rtc::scoped_refptr<webrtc::DataChannelInterface> CreateDataChannel(
+	  const std::string& label, const webrtc::DataChannelInit* config) override;
+	nlohmann::json GetNativeCodecs() const override;
+
+public:
+	// Notifies the listener as the signaling thread of a real PeerConnection would.
+	void SetIceConnectionState(webrtc::PeerConnectionInterface::IceConnectionState state);
+
+public:
+	// Number of SDP offers and answers created.
+	size_t createOfferCount{ 0u };
+	size_t createAnswerCount{ 0u };
+	// If set, called at the start of every SetRemoteDescription().
+	std::function<void()> onSetRemoteDescription;
+	// Returned by GetNativeCodecs().
+	nlohmann::json nativeCodecs = nlohmann::json::object();
+
+private:
+	struct MediaSection
+	{
+		std::string mid;
+		std::string kind;
+		// Null for the application section.
+		rtc::scoped_refptr<FakeRtpTransceiver> transceiver;
+		// Rejected sections can be recycled by new transceivers.
+		bool rejected{ false };
+		std::vector<uint32_t> ssrcs;
+	};
+
+private:
+	nlohmann::json CreateSessionObject();
+	nlohmann::json CreateMediaObject(const MediaSection& section, const std::string& setup);
+	void CheckClosed() const;
+
+private:
+	PrivateListener* privateListener{ nullptr };
+	webrtc::PeerConnectionInterface::RTCConfiguration config;
+	bool closed{ false };
+	std::vector<rtc::scoped_refptr<FakeRtpTransceiver>> transceivers;
+	// Local m-sections, in SDP order.
+	std::vector<MediaSection> sections;
+	bool hasDataChannel{ false };
+	uint32_t nextMid{ 0u };
+	uint32_t nextSsrc{ 1000000u };
+	uint32_t sessionVersion{ 0u };
+	std::string localDescription;
+	std::string remoteDescription;
+	nlohmann::json remoteSdpObject;
+};
+
+#endif
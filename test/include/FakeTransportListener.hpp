@@ -164,6 +164,48 @@ public:
 	size_t onTransportCloseExpectedTimesCalled{ 0 };
 };
 
+class FakeBandwidthMonitorListener : public mediasoupclient::BandwidthMonitor::Listener
+{
+public:
+	void OnBandwidthEstimation(
+	  const mediasoupclient::BandwidthMonitor::Estimation& /*estimation*/) override
+	{
+		this->onBandwidthEstimationTimesCalled++;
+	}
+
+	void OnCongestion(
+	  const mediasoupclient::BandwidthMonitor::Estimation& /*estimation*/,
+	  uint64_t previousBitrate) override
+	{
+		this->onCongestionTimesCalled++;
+		this->previousBitrate = previousBitrate;
+	}
+
+public:
+	size_t onBandwidthEstimationTimesCalled{ 0 };
+	size_t onCongestionTimesCalled{ 0 };
+	uint64_t previousBitrate{ 0u };
+};
+
+class FakeConnectionQualityMonitorListener
+  : public mediasoupclient::ConnectionQualityMonitor::Listener
+{
+public:
+	void OnQualityChange(
+	  mediasoupclient::ConnectionQualityMonitor::Quality quality,
+	  const mediasoupclient::ConnectionQualityMonitor::Metrics& /*metrics*/) override
+	{
+		this->onQualityChangeTimesCalled++;
+		this->quality = quality;
+	}
+
+public:
+	size_t onQualityChangeTimesCalled{ 0 };
+	mediasoupclient::ConnectionQualityMonitor::Quality quality{
+		mediasoupclient::ConnectionQualityMonitor::Quality::UNKNOWN
+	};
+};
+
 class FakeConsumerListener : public mediasoupclient::Consumer::Listener
 {
 public:
@@ -0,0 +1,72 @@
+#ifndef MSC_TEST_LOOPBACK_ROUTER_HPP
+#define MSC_TEST_LOOPBACK_ROUTER_HPP
+
+#include "mediasoupclient.hpp"
+#include <json.hpp>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+/*
+ * In-process stand-in for a mediasoup Router and its signaling. It answers
+ * the SendTransport and RecvTransport listeners and turns every Producer into
+ * Consumer parameters the way mediasoup does (router payload types, new SSRCs),
+ * so produce -> consume round trips can be measured without a server.
+ */
+class LoopbackRouter : public mediasoupclient::SendTransport::Listener,
+                       public mediasoupclient::RecvTransport::Listener
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct ProducerInfo
+	{
+		std::string kind;
+		nlohmann::json rtpParameters;
+		Clock::time_point producedAt;
+	};
+
+public:
+	LoopbackRouter();
+
+	const nlohmann::json& GetRtpCapabilities() const;
+	// Same fields as the ones returned by mediasoup router.createWebRtcTransport().
+	nlohmann::json CreateWebRtcTransport() const;
+	// Consumer parameters (id, producerId, kind and rtpParameters). May throw.
+	nlohmann::json Consume(const std::string& producerId);
+	const ProducerInfo& GetProducer(const std::string& producerId);
+	size_t GetConnectCount();
+
+	/* Virtual methods inherited from Transport::Listener. */
+public:
+	std::future<void> OnConnect(
+	  mediasoupclient::Transport* transport, const nlohmann::json& dtlsParameters) override;
+	void OnConnectionStateChange(
+	  mediasoupclient::Transport* transport, const std::string& connectionState) override;
+
+	/* Virtual methods inherited from SendTransport::Listener. */
+public:
+	std::future<std::string> OnProduce(
+	  mediasoupclient::SendTransport* transport,
+	  const std::string& kind,
+	  nlohmann::json rtpParameters,
+	  const nlohmann::json& appData) override;
+	std::future<std::string> OnProduceData(
+	  mediasoupclient::SendTransport* transport,
+	  const nlohmann::json& sctpStreamParameters,
+	  const std::string& label,
+	  const std::string& protocol,
+	  const nlohmann::json& appData) override;
+
+private:
+	nlohmann::json rtpCapabilities;
+	// Producers indexed by id.
+	std::map<std::string, ProducerInfo> producers;
+	// Transport DTLS parameters indexed by transport id.
+	std::map<std::string, nlohmann::json> connectedTransports;
+	// Listeners may be called from any thread.
+	std::mutex mutex;
+};
+
+#endif
@@ -1,9 +1,14 @@
 #include "Device.hpp"
+#include "FakePeerConnection.hpp"
 #include "FakeTransportListener.hpp"
 #include "MediaSoupClientErrors.hpp"
 #include "fakeParameters.hpp"
 #include "ortc.hpp"
 #include <catch.hpp>
+#include <cstdio> // std::remove
+#include <fstream>
+#include <iterator> // std::istreambuf_iterator
+#include <vector>
 
 TEST_CASE("Device", "[Device]")
 {
@@ -105,3 +110,209 @@ TEST_CASE("Device", "[Device]")
 		  TransportRemoteParameters["dtlsParameters"]));
 	}
 }
+
+TEST_CASE("Device::Save() and Device::Restore()", "[Device]")
+{
+	static const std::string Path{ "device_capabilities.tmp" };
+
+	auto routerRtpCapabilities = generateRouterRtpCapabilities();
+
+	mediasoupclient::Device device;
+
+	REQUIRE_THROWS_AS(device.Save(Path), MediaSoupClientInvalidStateError);
+
+	device.Load(routerRtpCapabilities);
+	device.Save(Path);
+
+	SECTION("device.Restore() succeeds for the same router RTP capabilities")
+	{
+		mediasoupclient::Device restoredDevice;
+
+		REQUIRE(restoredDevice.Restore(Path, routerRtpCapabilities));
+		REQUIRE(restoredDevice.IsLoaded());
+		REQUIRE(restoredDevice.GetRtpCapabilities() == device.GetRtpCapabilities());
+		REQUIRE(restoredDevice.GetSctpCapabilities() == device.GetSctpCapabilities());
+		REQUIRE(restoredDevice.CanProduce("audio") == device.CanProduce("audio"));
+		REQUIRE(restoredDevice.CanProduce("video") == device.CanProduce("video"));
+		// Identical capabilities are shared.
+		REQUIRE(&restoredDevice.GetRtpCapabilities() == &device.GetRtpCapabilities());
+		REQUIRE_THROWS_AS(restoredDevice.Restore(Path, routerRtpCapabilities), MediaSoupClientInvalidStateError);
+	}
+
+	SECTION("device.Restore() fails for other router RTP capabilities or profile")
+	{
+		mediasoupclient::Device restoredDevice;
+
+		routerRtpCapabilities["codecs"].erase(0);
+
+		REQUIRE(!restoredDevice.Restore(Path, routerRtpCapabilities));
+		REQUIRE(!restoredDevice.Restore(
+		  Path, generateRouterRtpCapabilities(), nullptr, { { "codecs", { "audio/opus" } } }));
+		REQUIRE(!restoredDevice.IsLoaded());
+	}
+
+	SECTION("device.Restore() fails if there is no file")
+	{
+		mediasoupclient::Device restoredDevice;
+
+		REQUIRE(!restoredDevice.Restore("unknown_file.tmp", routerRtpCapabilities));
+	}
+
+	SECTION("device.Restore() fails for invalid RTP capabilities")
+	{
+		mediasoupclient::Device restoredDevice;
+
+		std::ifstream inFile(Path, std::ios::binary);
+		std::vector<uint8_t> data(
+		  (std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+
+		inFile.close();
+
+		auto cache = json::from_cbor(data);
+
+		cache["recvRtpCapabilities"]["codecs"][0].erase("mimeType");
+		data = json::to_cbor(cache);
+
+		std::ofstream outFile(Path, std::ios::binary | std::ios::trunc);
+
+		outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+		outFile.close();
+
+		REQUIRE(!restoredDevice.Restore(Path, routerRtpCapabilities));
+		REQUIRE(!restoredDevice.IsLoaded());
+	}
+
+	SECTION("device.Restore() does not share capabilities differing from the interned ones")
+	{
+		mediasoupclient::Device restoredDevice;
+
+		std::ifstream inFile(Path, std::ios::binary);
+		std::vector<uint8_t> data(
+		  (std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+
+		inFile.close();
+
+		auto cache = json::from_cbor(data);
+
+		// Same extended RTP capabilities, so same hash.
+		cache["recvRtpCapabilities"]["headerExtensions"].erase(0);
+		data = json::to_cbor(cache);
+
+		std::ofstream outFile(Path, std::ios::binary | std::ios::trunc);
+
+		outFile.write(reinterpret_cast<const char*>(data.data()), data.size());
+		outFile.close();
+
+		REQUIRE(restoredDevice.Restore(Path, routerRtpCapabilities));
+		REQUIRE(&restoredDevice.GetRtpCapabilities() != &device.GetRtpCapabilities());
+		REQUIRE(restoredDevice.GetRtpCapabilities() != device.GetRtpCapabilities());
+	}
+
+	std::remove(Path.c_str());
+}
+
+TEST_CASE("Device::Restore() with other native codecs", "[Device]")
+{
+	static const std::string Path{ "device_capabilities.tmp" };
+
+	auto routerRtpCapabilities = generateRouterRtpCapabilities();
+
+	FakePeerConnection::Backend backend;
+	mediasoupclient::PeerConnection::Options peerConnectionOptions;
+
+	peerConnectionOptions.backend = &backend;
+	backend.nativeCodecs = json::parse(R"({ "video": { "send": [ { "mimeType": "video/VP8" } ] } })");
+
+	mediasoupclient::Device device;
+
+	device.Load(routerRtpCapabilities, &peerConnectionOptions);
+	device.Save(Path);
+
+	SECTION("device.Restore() succeeds for the same native codecs")
+	{
+		mediasoupclient::Device restoredDevice;
+
+		backend.lastPeerConnection = nullptr;
+
+		REQUIRE(restoredDevice.Restore(Path, routerRtpCapabilities, &peerConnectionOptions));
+		// The native codecs are read without a PeerConnection.
+		REQUIRE(backend.lastPeerConnection == nullptr);
+	}
+
+	SECTION("a restored Device can be saved again")
+	{
+		mediasoupclient::Device restoredDevice;
+		mediasoupclient::Device restoredAgainDevice;
+
+		REQUIRE(restoredDevice.Restore(Path, routerRtpCapabilities, &peerConnectionOptions));
+		REQUIRE_NOTHROW(restoredDevice.Save(Path));
+		REQUIRE(restoredAgainDevice.Restore(Path, routerRtpCapabilities, &peerConnectionOptions));
+	}
+
+	SECTION("device.Restore() fails if the native codecs changed")
+	{
+		mediasoupclient::Device restoredDevice;
+
+		backend.nativeCodecs["video"]["send"].push_back(json{ { "mimeType", "video/H264" } });
+
+		REQUIRE(!restoredDevice.Restore(Path, routerRtpCapabilities, &peerConnectionOptions));
+		REQUIRE(!restoredDevice.IsLoaded());
+	}
+
+	std::remove(Path.c_str());
+}
+
+TEST_CASE("Device capabilities are shared", "[Device]")
+{
+	auto routerRtpCapabilities = generateRouterRtpCapabilities();
+
+	mediasoupclient::Device device1;
+	mediasoupclient::Device device2;
+
+	device1.Load(routerRtpCapabilities);
+
+	SECTION("device.Load() with a loaded Device shares its capabilities")
+	{
+		REQUIRE_NOTHROW(device2.Load(device1));
+		REQUIRE(device2.IsLoaded());
+		REQUIRE(&device2.GetRtpCapabilities() == &device1.GetRtpCapabilities());
+		REQUIRE(device2.CanProduce("audio") == device1.CanProduce("audio"));
+		REQUIRE_THROWS_AS(device2.Load(device1), MediaSoupClientInvalidStateError);
+	}
+
+	SECTION("device.Load() with a Device not loaded throws")
+	{
+		mediasoupclient::Device device3;
+
+		REQUIRE_THROWS_AS(device2.Load(device3), MediaSoupClientInvalidStateError);
+	}
+
+	SECTION("devices loaded with the same capabilities share them")
+	{
+		device2.Load(routerRtpCapabilities);
+
+		REQUIRE(&device2.GetRtpCapabilities() == &device1.GetRtpCapabilities());
+	}
+
+	SECTION("device.Load() with just audio kind cannot produce nor receive video")
+	{
+		device2.Load(routerRtpCapabilities, nullptr, { { "kinds", { "audio" } } });
+
+		REQUIRE(device2.CanProduce("audio"));
+		REQUIRE(!device2.CanProduce("video"));
+
+		for (const auto& codec : device2.GetRtpCapabilities()["codecs"])
+		{
+			REQUIRE(codec["kind"] == "audio");
+		}
+	}
+
+	SECTION("devices loaded with different capabilities do not share them")
+	{
+		device2.Load(routerRtpCapabilities, nullptr, { { "codecs", { "audio/opus" } } });
+
+		REQUIRE(&device2.GetRtpCapabilities() != &device1.GetRtpCapabilities());
+		REQUIRE(!device2.CanProduce("video"));
+		REQUIRE(device1.CanProduce("video"));
+	}
+}
@@ -0,0 +1,973 @@
+#include "FakePeerConnection.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "sdptransform.hpp"
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+using json = nlohmann::json;
+
+static const std::string FakeFingerprint(
+  "A7:24:A6:9B:0D:4F:E6:8B:B5:49:5F:61:3F:34:4F:4A:47:2A:95:68:C4:A2:5C:6D:84:2A:6B:5E:D9:14:1C:D2");
+
+static std::string kindToString(cricket::MediaType mediaType)
+{
+	return mediaType == cricket::MediaType::MEDIA_TYPE_AUDIO ? "audio" : "video";
+}
+
+static cricket::MediaType stringToKind(const std::string& kind)
+{
+	return kind == "audio" ? cricket::MediaType::MEDIA_TYPE_AUDIO : cricket::MediaType::MEDIA_TYPE_VIDEO;
+}
+
+static std::string directionToString(webrtc::RtpTransceiverDirection direction)
+{
+	switch (direction)
+	{
+		case webrtc::RtpTransceiverDirection::kSendRecv:
+			return "sendrecv";
+		case webrtc::RtpTransceiverDirection::kSendOnly:
+			return "sendonly";
+		case webrtc::RtpTransceiverDirection::kRecvOnly:
+			return "recvonly";
+		default:
+			return "inactive";
+	}
+}
+
+// Canned native codecs and header extensions, similar to the libwebrtc ones.
+static void fillNativeMediaObject(json& mediaObject, const std::string& kind)
+{
+	if (kind == "audio")
+	{
+		/* clang-format off */
+		mediaObject["payloads"] = "111";
+		mediaObject["rtp"] =
+		{
+			{ { "payload", 111 }, { "codec", "opus" }, { "rate", 48000 }, { "encoding", 2 } }
+		};
+		mediaObject["fmtp"] =
+		{
+			{ { "payload", 111 }, { "config", "minptime=10;useinbandfec=1" } }
+		};
+		mediaObject["rtcpFb"] =
+		{
+			{ { "payload", "111" }, { "type", "transport-cc" } }
+		};
+		mediaObject["ext"] =
+		{
+			{ { "value", 1 }, { "uri", "urn:ietf:params:rtp-hdrext:ssrc-audio-level" } },
+			{ { "value", 2 }, { "uri", "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time" } },
+			{ { "value", 3 }, { "uri", "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01" } },
+			{ { "value", 4 }, { "uri", "urn:ietf:params:rtp-hdrext:sdes:mid" } }
+		};
+		/* clang-format on */
+	}
+	else
+	{
+		/* clang-format off */
+		mediaObject["payloads"] = "96 97 98 99";
+		mediaObject["rtp"] =
+		{
+			{ { "payload", 96 }, { "codec", "VP8"  }, { "rate", 90000 } },
+			{ { "payload", 97 }, { "codec", "rtx"  }, { "rate", 90000 } },
+			{ { "payload", 98 }, { "codec", "H264" }, { "rate", 90000 } },
+			{ { "payload", 99 }, { "codec", "rtx"  }, { "rate", 90000 } }
+		};
+		mediaObject["fmtp"] =
+		{
+			{ { "payload", 97 }, { "config", "apt=96" } },
+			{ { "payload", 98 }, { "config", "level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f" } },
+			{ { "payload", 99 }, { "config", "apt=98" } }
+		};
+		mediaObject["rtcpFb"] = json::array();
+
+		for (const auto* payload : { "96", "98" })
+		{
+			mediaObject["rtcpFb"].push_back({ { "payload", payload }, { "type", "goog-remb" } });
+			mediaObject["rtcpFb"].push_back({ { "payload", payload }, { "type", "transport-cc" } });
+			mediaObject["rtcpFb"].push_back({ { "payload", payload }, { "type", "ccm" }, { "subtype", "fir" } });
+			mediaObject["rtcpFb"].push_back({ { "payload", payload }, { "type", "nack" } });
+			mediaObject["rtcpFb"].push_back({ { "payload", payload }, { "type", "nack" }, { "subtype", "pli" } });
+		}
+
+		mediaObject["ext"] =
+		{
+			{ { "value", 2  }, { "uri", "urn:ietf:params:rtp-hdrext:toffset" } },
+			{ { "value", 3  }, { "uri", "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time" } },
+			{ { "value", 4  }, { "uri", "urn:3gpp:video-orientation" } },
+			{ { "value", 5  }, { "uri", "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01" } },
+			{ { "value", 9  }, { "uri", "urn:ietf:params:rtp-hdrext:sdes:mid" } },
+			{ { "value", 10 }, { "uri", "urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id" } },
+			{ { "value", 11 }, { "uri", "urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id" } }
+		};
+		/* clang-format on */
+	}
+}
+
+/* FakeMediaStreamTrack */
+
+FakeMediaStreamTrack::FakeMediaStreamTrack(const std::string& kind, const std::string& id)
+  : trackKind(kind), trackId(id)
+{
+}
+
+std::string FakeMediaStreamTrack::kind() const
+{
+	return this->trackKind;
+}
+
+std::string FakeMediaStreamTrack::id() const
+{
+	return this->trackId;
+}
+
+bool FakeMediaStreamTrack::enabled() const
+{
+	return this->isEnabled;
+}
+
+bool FakeMediaStreamTrack::set_enabled(bool enable)
+{
+	this->isEnabled = enable;
+
+	return true;
+}
+
+webrtc::MediaStreamTrackInterface::TrackState FakeMediaStreamTrack::state() const
+{
+	return TrackState::kLive;
+}
+
+void FakeMediaStreamTrack::RegisterObserver(webrtc::ObserverInterface* /*observer*/)
+{
+}
+
+void FakeMediaStreamTrack::UnregisterObserver(webrtc::ObserverInterface* /*observer*/)
+{
+}
+
+/* FakeRtpSender */
+
+FakeRtpSender::FakeRtpSender(
+  cricket::MediaType mediaType,
+  rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track,
+  const std::vector<webrtc::RtpEncodingParameters>& encodings)
+  : mediaType(mediaType), currentTrack(std::move(track)), initEncodings(encodings)
+{
+	this->parameters.encodings = encodings;
+
+	if (this->parameters.encodings.empty())
+		this->parameters.encodings.emplace_back();
+}
+
+bool FakeRtpSender::SetTrack(webrtc::MediaStreamTrackInterface* track)
+{
+	this->currentTrack = track;
+
+	return true;
+}
+
+rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> FakeRtpSender::track() const
+{
+	return this->currentTrack;
+}
+
+rtc::scoped_refptr<webrtc::DtlsTransportInterface> FakeRtpSender::dtls_transport() const
+{
+	return nullptr;
+}
+
+uint32_t FakeRtpSender::ssrc() const
+{
+	return 0u;
+}
+
+cricket::MediaType FakeRtpSender::media_type() const
+{
+	return this->mediaType;
+}
+
+std::string FakeRtpSender::id() const
+{
+	return this->currentTrack ? this->currentTrack->id() : "";
+}
+
+std::vector<std::string> FakeRtpSender::stream_ids() const
+{
+	return this->streamIds;
+}
+
+void FakeRtpSender::SetStreams(const std::vector<std::string>& streamIds)
+{
+	this->streamIds = streamIds;
+}
+
+std::vector<webrtc::RtpEncodingParameters> FakeRtpSender::init_send_encodings() const
+{
+	return this->initEncodings;
+}
+
+webrtc::RtpParameters FakeRtpSender::GetParameters() const
+{
+	return this->parameters;
+}
+
+webrtc::RTCError FakeRtpSender::SetParameters(const webrtc::RtpParameters& parameters)
+{
+	if (parameters.encodings.size() != this->parameters.encodings.size())
+	{
+		return webrtc::RTCError(
+		  webrtc::RTCErrorType::INVALID_MODIFICATION, "number of encodings cannot be modified");
+	}
+
+	this->parameters = parameters;
+
+	return webrtc::RTCError::OK();
+}
+
+rtc::scoped_refptr<webrtc::DtmfSenderInterface> FakeRtpSender::GetDtmfSender() const
+{
+	return nullptr;
+}
+
+void FakeRtpSender::SetFrameEncryptor(rtc::scoped_refptr<webrtc::FrameEncryptorInterface> /*frameEncryptor*/)
+{
+}
+
+rtc::scoped_refptr<webrtc::FrameEncryptorInterface> FakeRtpSender::GetFrameEncryptor() const
+{
+	return nullptr;
+}
+
+/* FakeRtpReceiver */
+
+FakeRtpReceiver::FakeRtpReceiver(
+  cricket::MediaType mediaType, rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track)
+  : mediaType(mediaType), currentTrack(std::move(track))
+{
+}
+
+rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> FakeRtpReceiver::track() const
+{
+	return this->currentTrack;
+}
+
+std::vector<std::string> FakeRtpReceiver::stream_ids() const
+{
+	return {};
+}
+
+cricket::MediaType FakeRtpReceiver::media_type() const
+{
+	return this->mediaType;
+}
+
+std::string FakeRtpReceiver::id() const
+{
+	return this->currentTrack->id();
+}
+
+webrtc::RtpParameters FakeRtpReceiver::GetParameters() const
+{
+	return webrtc::RtpParameters();
+}
+
+void FakeRtpReceiver::SetObserver(webrtc::RtpReceiverObserverInterface* /*observer*/)
+{
+}
+
+void FakeRtpReceiver::SetJitterBufferMinimumDelay(absl::optional<double> delaySeconds)
+{
+	this->jitterBufferMinimumDelay = delaySeconds;
+}
+
+/* FakeRtpTransceiver */
+
+FakeRtpTransceiver::FakeRtpTransceiver(
+  cricket::MediaType mediaType,
+  webrtc::RtpTransceiverDirection direction,
+  rtc::scoped_refptr<webrtc::RtpSenderInterface> sender,
+  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver)
+  : mediaType(mediaType), transceiverDirection(direction), transceiverSender(std::move(sender)),
+    transceiverReceiver(std::move(receiver))
+{
+}
+
+void FakeRtpTransceiver::SetMid(const std::string& mid)
+{
+	this->transceiverMid = mid;
+}
+
+void FakeRtpTransceiver::SetStopped()
+{
+	this->isStopped            = true;
+	this->transceiverDirection = webrtc::RtpTransceiverDirection::kStopped;
+}
+
+cricket::MediaType FakeRtpTransceiver::media_type() const
+{
+	return this->mediaType;
+}
+
+absl::optional<std::string> FakeRtpTransceiver::mid() const
+{
+	return this->transceiverMid;
+}
+
+rtc::scoped_refptr<webrtc::RtpSenderInterface> FakeRtpTransceiver::sender() const
+{
+	return this->transceiverSender;
+}
+
+rtc::scoped_refptr<webrtc::RtpReceiverInterface> FakeRtpTransceiver::receiver() const
+{
+	return this->transceiverReceiver;
+}
+
+bool FakeRtpTransceiver::stopped() const
+{
+	return this->isStopped;
+}
+
+bool FakeRtpTransceiver::stopping() const
+{
+	return this->isStopped;
+}
+
+webrtc::RtpTransceiverDirection FakeRtpTransceiver::direction() const
+{
+	return this->transceiverDirection;
+}
+
+webrtc::RTCError FakeRtpTransceiver::SetDirectionWithError(webrtc::RtpTransceiverDirection newDirection)
+{
+	if (this->isStopped)
+		return webrtc::RTCError(webrtc::RTCErrorType::INVALID_STATE, "transceiver stopped");
+
+	this->transceiverDirection = newDirection;
+
+	return webrtc::RTCError::OK();
+}
+
+absl::optional<webrtc::RtpTransceiverDirection> FakeRtpTransceiver::current_direction() const
+{
+	if (!this->transceiverMid.has_value())
+		return absl::nullopt;
+
+	return this->transceiverDirection;
+}
+
+webrtc::RTCError FakeRtpTransceiver::StopStandard()
+{
+	SetStopped();
+
+	return webrtc::RTCError::OK();
+}
+
+void FakeRtpTransceiver::StopInternal()
+{
+	SetStopped();
+}
+
+/* FakeDataChannel */
+
+FakeDataChannel::FakeDataChannel(const std::string& label, const webrtc::DataChannelInit& config)
+  : channelLabel(label), config(config)
+{
+}
+
+void FakeDataChannel::RegisterObserver(webrtc::DataChannelObserver* /*observer*/)
+{
+}
+
+void FakeDataChannel::UnregisterObserver()
+{
+}
+
+std::string FakeDataChannel::label() const
+{
+	return this->channelLabel;
+}
+
+bool FakeDataChannel::reliable() const
+{
+	return this->config.ordered && !this->config.maxRetransmits && !this->config.maxRetransmitTime;
+}
+
+bool FakeDataChannel::ordered() const
+{
+	return this->config.ordered;
+}
+
+std::string FakeDataChannel::protocol() const
+{
+	return this->config.protocol;
+}
+
+bool FakeDataChannel::negotiated() const
+{
+	return this->config.negotiated;
+}
+
+int FakeDataChannel::id() const
+{
+	return this->config.id;
+}
+
+webrtc::DataChannelInterface::DataState FakeDataChannel::state() const
+{
+	return this->channelState;
+}
+
+uint32_t FakeDataChannel::messages_sent() const
+{
+	return this->messagesSent;
+}
+
+uint64_t FakeDataChannel::bytes_sent() const
+{
+	return this->bytesSent;
+}
+
+uint32_t FakeDataChannel::messages_received() const
+{
+	return 0u;
+}
+
+uint64_t FakeDataChannel::bytes_received() const
+{
+	return 0u;
+}
+
+uint64_t FakeDataChannel::buffered_amount() const
+{
+	return 0u;
+}
+
+void FakeDataChannel::Close()
+{
+	this->channelState = kClosed;
+}
+
+bool FakeDataChannel::Send(const webrtc::DataBuffer& buffer)
+{
+	if (this->channelState != kOpen)
+		return false;
+
+	this->messagesSent++;
+	this->bytesSent += buffer.size();
+
+	return true;
+}
+
+/* FakePeerConnection::Backend */
+
+mediasoupclient::PeerConnection* FakePeerConnection::Backend::CreatePeerConnection(
+  mediasoupclient::PeerConnection::PrivateListener* privateListener,
+  const mediasoupclient::PeerConnection::Options* options)
+{
+	this->lastPeerConnection = new FakePeerConnection(privateListener, options);
+	this->lastPeerConnection->nativeCodecs = this->nativeCodecs;
+
+	return this->lastPeerConnection;
+}
+
+json FakePeerConnection::Backend::GetNativeCodecs(
+  const mediasoupclient::PeerConnection::Options* /*options*/) const
+{
+	return this->nativeCodecs;
+}
+
+/* FakePeerConnection */
+
+FakePeerConnection::FakePeerConnection(PrivateListener* privateListener, const Options* options)
+  : privateListener(privateListener)
+{
+	if (options != nullptr)
+		this->config = options->config;
+}
+
+void FakePeerConnection::SetPrivateListener(PrivateListener* privateListener)
+{
+	this->privateListener = privateListener;
+}
+
+void FakePeerConnection::Close()
+{
+	this->closed = true;
+
+	for (auto& transceiver : this->transceivers)
+	{
+		transceiver->SetStopped();
+	}
+}
+
+webrtc::PeerConnectionInterface::RTCConfiguration FakePeerConnection::GetConfiguration() const
+{
+	return this->config;
+}
+
+bool FakePeerConnection::SetConfiguration(const webrtc::PeerConnectionInterface::RTCConfiguration& config)
+{
+	this->config = config;
+
+	return true;
+}
+
+std::string FakePeerConnection::CreateOffer(
+  const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& /*options*/)
+{
+	CheckClosed();
+
+	++this->createOfferCount;
+
+	// Assign an m-section to every new transceiver, recycling rejected ones.
+	for (auto& transceiver : this->transceivers)
+	{
+		if (transceiver->stopped() || transceiver->mid().has_value())
+			continue;
+
+		auto sectionIt =
+		  std::find_if(this->sections.begin(), this->sections.end(), [](const MediaSection& section) {
+			  return section.rejected;
+		  });
+
+		if (sectionIt == this->sections.end())
+			sectionIt = this->sections.insert(this->sections.end(), MediaSection());
+
+		sectionIt->mid         = std::to_string(this->nextMid++);
+		sectionIt->kind        = kindToString(transceiver->media_type());
+		sectionIt->transceiver = transceiver;
+		sectionIt->rejected    = false;
+		sectionIt->ssrcs       = { this->nextSsrc++, this->nextSsrc++ };
+
+		transceiver->SetMid(sectionIt->mid);
+	}
+
+	if (this->hasDataChannel)
+	{
+		auto sectionIt =
+		  std::find_if(this->sections.begin(), this->sections.end(), [](const MediaSection& section) {
+			  return section.kind == "application";
+		  });
+
+		if (sectionIt == this->sections.end())
+		{
+			MediaSection section;
+
+			section.mid  = std::to_string(this->nextMid++);
+			section.kind = "application";
+
+			this->sections.push_back(section);
+		}
+	}
+
+	auto sdpObject = CreateSessionObject();
+
+	for (const auto& section : this->sections)
+	{
+		sdpObject["media"].push_back(CreateMediaObject(section, "actpass"));
+	}
+
+	return sdptransform::write(sdpObject);
+}
+
+std::string FakePeerConnection::CreateAnswer(
+  const webrtc::PeerConnectionInterface::RTCOfferAnswerOptions& /*options*/)
+{
+	CheckClosed();
+
+	++this->createAnswerCount;
+
+	if (this->remoteSdpObject.empty())
+		MSC_THROW_INVALID_STATE_ERROR("no remote offer");
+
+	auto sdpObject = CreateSessionObject();
+
+	for (const auto& offerMediaObject : this->remoteSdpObject["media"])
+	{
+		json mediaObject = offerMediaObject;
+
+		mediaObject.erase("candidates");
+		mediaObject.erase("endOfCandidates");
+		mediaObject.erase("iceOptions");
+		mediaObject.erase("ssrcs");
+		mediaObject.erase("ssrcGroups");
+		mediaObject.erase("msid");
+
+		mediaObject["iceUfrag"]    = "fakeufrag";
+		mediaObject["icePwd"]      = "fakepasswordfakepassword";
+		mediaObject["fingerprint"] = { { "type", "sha-256" }, { "hash", FakeFingerprint } };
+		mediaObject["setup"]       = "active";
+
+		if (mediaObject["type"] != "application")
+			mediaObject["direction"] = mediaObject["port"] == 0 ? "inactive" : "recvonly";
+
+		sdpObject["media"].push_back(mediaObject);
+	}
+
+	return sdptransform::write(sdpObject);
+}
+
+void FakePeerConnection::SetLocalDescription(PeerConnection::SdpType /*type*/, const std::string& sdp)
+{
+	CheckClosed();
+
+	this->localDescription = sdp;
+}
+
+void FakePeerConnection::SetRemoteDescription(PeerConnection::SdpType type, const std::string& sdp)
+{
+	CheckClosed();
+
+	if (this->onSetRemoteDescription)
+		this->onSetRemoteDescription();
+
+	auto sdpObject = sdptransform::parse(sdp);
+	// Transceivers to signal to the listener once the description is set.
+	std::vector<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>> newTransceivers;
+
+	if (type == PeerConnection::SdpType::OFFER)
+	{
+		// Mirror the remote m-sections, creating a receiving transceiver for each
+		// new audio/video one.
+		for (size_t idx{ 0u }; idx < sdpObject["media"].size(); ++idx)
+		{
+			const auto& mediaObject = sdpObject["media"][idx];
+			auto mid                = mediaObject["mid"].get<std::string>();
+			auto kind               = mediaObject["type"].get<std::string>();
+			bool rejected           = mediaObject["port"] == 0;
+
+			if (idx == this->sections.size())
+				this->sections.emplace_back();
+
+			auto& section = this->sections[idx];
+
+			if (section.mid != mid)
+			{
+				section.mid         = mid;
+				section.kind        = kind;
+				section.transceiver = nullptr;
+
+				if (kind != "application")
+				{
+					auto mediaType = stringToKind(kind);
+					rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track(
+					  new rtc::RefCountedObject<FakeMediaStreamTrack>(kind, "remote-" + mid));
+					rtc::scoped_refptr<webrtc::RtpSenderInterface> sender(
+					  new rtc::RefCountedObject<FakeRtpSender>(
+					    mediaType, nullptr, std::vector<webrtc::RtpEncodingParameters>()));
+					rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver(
+					  new rtc::RefCountedObject<FakeRtpReceiver>(mediaType, track));
+
+					section.transceiver = new rtc::RefCountedObject<FakeRtpTransceiver>(
+					  mediaType, webrtc::RtpTransceiverDirection::kRecvOnly, sender, receiver);
+
+					section.transceiver->SetMid(mid);
+					this->transceivers.push_back(section.transceiver);
+
+					if (!rejected)
+						newTransceivers.push_back(section.transceiver);
+				}
+			}
+
+			if (rejected && !section.rejected && section.transceiver)
+				section.transceiver->SetStopped();
+
+			section.rejected = rejected;
+		}
+	}
+	else
+	{
+		// Remote answer rejecting m-sections stops their transceivers.
+		for (size_t idx{ 0u }; idx < sdpObject["media"].size() && idx < this->sections.size(); ++idx)
+		{
+			auto& section = this->sections[idx];
+
+			if (sdpObject["media"][idx]["port"] != 0 || section.rejected)
+				continue;
+
+			section.rejected = true;
+
+			if (section.transceiver)
+				section.transceiver->SetStopped();
+		}
+	}
+
+	this->remoteDescription = sdp;
+	this->remoteSdpObject   = std::move(sdpObject);
+
+	if (!this->privateListener)
+		return;
+
+	for (auto& transceiver : newTransceivers)
+	{
+		this->privateListener->OnTrack(transceiver);
+	}
+}
+
+const std::string FakePeerConnection::GetLocalDescription()
+{
+	return this->localDescription;
+}
+
+const std::string FakePeerConnection::GetRemoteDescription()
+{
+	return this->remoteDescription;
+}
+
+std::vector<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>> FakePeerConnection::GetTransceivers() const
+{
+	return { this->transceivers.begin(), this->transceivers.end() };
+}
+
+rtc::scoped_refptr<webrtc::RtpTransceiverInterface> FakePeerConnection::AddTransceiver(
+  cricket::MediaType mediaType)
+{
+	CheckClosed();
+
+	rtc::scoped_refptr<webrtc::RtpSenderInterface> sender(new rtc::RefCountedObject<FakeRtpSender>(
+	  mediaType, nullptr, std::vector<webrtc::RtpEncodingParameters>()));
+	rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver(new rtc::RefCountedObject<FakeRtpReceiver>(
+	  mediaType, new rtc::RefCountedObject<FakeMediaStreamTrack>(kindToString(mediaType), "")));
+	rtc::scoped_refptr<FakeRtpTransceiver> transceiver(new rtc::RefCountedObject<FakeRtpTransceiver>(
+	  mediaType, webrtc::RtpTransceiverDirection::kSendRecv, sender, receiver));
+
+	this->transceivers.push_back(transceiver);
+
+	return transceiver;
+}
+
+rtc::scoped_refptr<webrtc::RtpTransceiverInterface> FakePeerConnection::AddTransceiver(
+  rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track,
+  webrtc::RtpTransceiverInit rtpTransceiverInit)
+{
+	CheckClosed();
+
+	auto mediaType = stringToKind(track->kind());
+	rtc::scoped_refptr<webrtc::RtpSenderInterface> sender(
+	  new rtc::RefCountedObject<FakeRtpSender>(mediaType, track, rtpTransceiverInit.send_encodings));
+	rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver(new rtc::RefCountedObject<FakeRtpReceiver>(
+	  mediaType, new rtc::RefCountedObject<FakeMediaStreamTrack>(track->kind(), "")));
+	rtc::scoped_refptr<FakeRtpTransceiver> transceiver(
+	  new rtc::RefCountedObject<FakeRtpTransceiver>(mediaType, rtpTransceiverInit.direction, sender, receiver));
+
+	this->transceivers.push_back(transceiver);
+
+	return transceiver;
+}
+
+std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> FakePeerConnection::GetSenders()
+{
+	std::vector<rtc::scoped_refptr<webrtc::RtpSenderInterface>> senders;
+
+	for (const auto& transceiver : this->transceivers)
+	{
+		if (!transceiver->stopped())
+			senders.push_back(transceiver->sender());
+	}
+
+	return senders;
+}
+
+bool FakePeerConnection::RemoveTrack(webrtc::RtpSenderInterface* sender)
+{
+	CheckClosed();
+
+	for (auto& transceiver : this->transceivers)
+	{
+		if (transceiver->sender().get() != sender)
+			continue;
+
+		sender->SetTrack(nullptr);
+
+		// Same as libwebrtc with Unified Plan, the transceiver stops sending.
+		auto direction = transceiver->direction();
+
+		if (direction == webrtc::RtpTransceiverDirection::kSendRecv)
+			transceiver->SetDirectionWithError(webrtc::RtpTransceiverDirection::kRecvOnly);
+		else if (direction == webrtc::RtpTransceiverDirection::kSendOnly)
+			transceiver->SetDirectionWithError(webrtc::RtpTransceiverDirection::kInactive);
+
+		return true;
+	}
+
+	return false;
+}
+
+json FakePeerConnection::GetStats()
+{
+	return json::array();
+}
+
+json FakePeerConnection::GetStats(rtc::scoped_refptr<webrtc::RtpSenderInterface> /*selector*/)
+{
+	return json::array();
+}
+
+json FakePeerConnection::GetStats(rtc::scoped_refptr<webrtc::RtpReceiverInterface> /*selector*/)
+{
+	return json::array();
+}
+
+rtc::scoped_refptr<webrtc::DataChannelInterface> FakePeerConnection::CreateDataChannel(
+  const std::string& label, const webrtc::DataChannelInit* config)
+{
+	CheckClosed();
+
+	this->hasDataChannel = true;
+
+	return new rtc::RefCountedObject<FakeDataChannel>(
+	  label, config != nullptr ? *config : webrtc::DataChannelInit());
+}
+
+json FakePeerConnection::GetNativeCodecs() const
+{
+	return this->nativeCodecs;
+}
+
+void FakePeerConnection::SetIceConnectionState(
+  webrtc::PeerConnectionInterface::IceConnectionState state)
+{
+	CheckClosed();
+
+	this->privateListener->OnIceConnectionChange(state);
+}
+
+json FakePeerConnection::CreateSessionObject()
+{
+	std::string mids;
+
+	for (const auto& section : this->sections)
+	{
+		if (section.rejected)
+			continue;
+
+		if (!mids.empty())
+			mids.append(" ");
+
+		mids.append(section.mid);
+	}
+
+	/* clang-format off */
+	json sdpObject =
+	{
+		{ "version", 0 },
+		{ "origin",
+			{
+				{ "address",        "127.0.0.1"              },
+				{ "ipVer",          4                        },
+				{ "netType",        "IN"                     },
+				{ "sessionId",      1234567890               },
+				{ "sessionVersion", this->sessionVersion++   },
+				{ "username",       "-"                      }
+			}
+		},
+		{ "name",   "-" },
+		{ "timing", { { "start", 0 }, { "stop", 0 } } },
+		{ "groups", json::array() },
+		{ "msidSemantic", { { "semantic", "WMS" }, { "token", "*" } } },
+		{ "media", json::array() }
+	};
+	/* clang-format on */
+
+	if (!mids.empty())
+		sdpObject["groups"].push_back({ { "type", "BUNDLE" }, { "mids", mids } });
+
+	return sdpObject;
+}
+
+json FakePeerConnection::CreateMediaObject(const MediaSection& section, const std::string& setup)
+{
+	/* clang-format off */
+	json mediaObject =
+	{
+		{ "type",        section.kind                                          },
+		{ "port",        section.rejected ? 0 : 9                              },
+		{ "connection",  { { "version", 4 }, { "ip", "0.0.0.0" } }             },
+		{ "iceUfrag",    "fakeufrag"                                           },
+		{ "icePwd",      "fakepasswordfakepassword"                            },
+		{ "fingerprint", { { "type", "sha-256" }, { "hash", FakeFingerprint } } },
+		{ "setup",       setup                                                 },
+		{ "mid",         section.mid                                           }
+	};
+	/* clang-format on */
+
+	if (section.kind == "application")
+	{
+		mediaObject["protocol"]       = "UDP/DTLS/SCTP";
+		mediaObject["payloads"]       = "webrtc-datachannel";
+		mediaObject["sctpPort"]       = 5000;
+		mediaObject["maxMessageSize"] = 262144;
+
+		return mediaObject;
+	}
+
+	mediaObject["protocol"]  = "UDP/TLS/RTP/SAVPF";
+	mediaObject["rtcpMux"]   = "rtcp-mux";
+	mediaObject["rtcpRsize"] = "rtcp-rsize";
+	mediaObject["direction"] =
+	  section.rejected ? "inactive" : directionToString(section.transceiver->direction());
+
+	fillNativeMediaObject(mediaObject, section.kind);
+
+	if (section.rejected)
+		return mediaObject;
+
+	auto sender = section.transceiver->sender();
+	auto track  = sender->track();
+
+	// Senders with several encodings use RID based simulcast.
+	auto encodings = sender->GetParameters().encodings;
+
+	if (encodings.size() > 1)
+	{
+		std::string list;
+
+		mediaObject["rids"] = json::array();
+
+		for (const auto& encoding : encodings)
+		{
+			mediaObject["rids"].push_back({ { "id", encoding.rid }, { "direction", "send" } });
+
+			if (!list.empty())
+				list.append(";");
+
+			list.append(encoding.rid);
+		}
+
+		mediaObject["simulcast"] = { { "dir1", "send" }, { "list1", list } };
+	}
+
+	std::string cname("fakecname");
+	std::string msid("- ");
+
+	msid.append(track ? track->id() : "");
+
+	mediaObject["ssrcs"] = json::array();
+	mediaObject["ssrcs"].push_back(
+	  { { "id", section.ssrcs[0] }, { "attribute", "cname" }, { "value", cname } });
+	mediaObject["ssrcs"].push_back({ { "id", section.ssrcs[0] }, { "attribute", "msid" }, { "value", msid } });
+
+	if (section.kind == "video")
+	{
+		mediaObject["ssrcs"].push_back(
+		  { { "id", section.ssrcs[1] }, { "attribute", "cname" }, { "value", cname } });
+		mediaObject["ssrcs"].push_back(
+		  { { "id", section.ssrcs[1] }, { "attribute", "msid" }, { "value", msid } });
+
+		mediaObject["ssrcGroups"] = json::array();
+		mediaObject["ssrcGroups"].push_back(
+		  { { "semantics", "FID" },
+		    { "ssrcs", std::to_string(section.ssrcs[0]) + " " + std::to_string(section.ssrcs[1]) } });
+	}
+
+	return mediaObject;
+}
+
+void FakePeerConnection::CheckClosed() const
+{
+	if (this->closed)
+		MSC_THROW_INVALID_STATE_ERROR("FakePeerConnection closed");
+}
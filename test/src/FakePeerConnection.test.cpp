@@ -0,0 +1,527 @@
+#include "FakePeerConnection.hpp"
+#include "FakeTransportListener.hpp"
+#include "Handler.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "fakeParameters.hpp"
+#include "mediasoupclient.hpp"
+#include "sdptransform.hpp"
+#include <catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class FakeBackendHandlerListener : public mediasoupclient::Handler::PrivateListener
+{
+public:
+	void OnConnect(json& /*transportLocalParameters*/) override{};
+
+	void OnConnectionStateChange(
+	  webrtc::PeerConnectionInterface::IceConnectionState /*connectionState*/) override{};
+};
+
+class ClosingSendTransportListener : public FakeSendTransportListener
+{
+public:
+	void OnConnectionStateChange(
+	  mediasoupclient::Transport* transport, const std::string& connectionState) override
+	{
+		FakeSendTransportListener::OnConnectionStateChange(transport, connectionState);
+
+		transport->Close();
+	};
+};
+
+class FakeDataConsumerListener : public mediasoupclient::DataConsumer::Listener
+{
+public:
+	void OnConnecting(mediasoupclient::DataConsumer* /*dataConsumer*/) override{};
+	void OnOpen(mediasoupclient::DataConsumer* /*dataConsumer*/) override{};
+	void OnClosing(mediasoupclient::DataConsumer* /*dataConsumer*/) override{};
+	void OnClose(mediasoupclient::DataConsumer* /*dataConsumer*/) override{};
+	void OnMessage(
+	  mediasoupclient::DataConsumer* /*dataConsumer*/,
+	  const webrtc::DataBuffer& /*buffer*/) override{};
+	void OnTransportClose(mediasoupclient::DataConsumer* /*dataConsumer*/) override{};
+};
+
+TEST_CASE("FakePeerConnection", "[FakePeerConnection]")
+{
+	static const json TransportRemoteParameters = generateTransportRemoteParameters();
+
+	static FakePeerConnection::Backend backend;
+	static mediasoupclient::PeerConnection::Options peerConnectionOptions;
+	static FakeBackendHandlerListener handlerListener;
+
+	peerConnectionOptions.backend = &backend;
+
+	SECTION("PeerConnection::Create() uses the given backend")
+	{
+		std::unique_ptr<mediasoupclient::PeerConnection> pc(
+		  mediasoupclient::PeerConnection::Create(nullptr, &peerConnectionOptions));
+
+		REQUIRE(dynamic_cast<FakePeerConnection*>(pc.get()) != nullptr);
+	}
+
+	SECTION("Handler::GetNativeRtpCapabilities() succeeds")
+	{
+		json rtpCapabilities;
+
+		REQUIRE_NOTHROW(
+		  rtpCapabilities = mediasoupclient::Handler::GetNativeRtpCapabilities(&peerConnectionOptions));
+
+		REQUIRE(rtpCapabilities["codecs"].size() == 5);
+		REQUIRE(rtpCapabilities["headerExtensions"].is_array());
+	}
+
+	SECTION("Handler::GetNativeRtpCapabilities() with just audio succeeds")
+	{
+		auto rtpCapabilities =
+		  mediasoupclient::Handler::GetNativeRtpCapabilities(&peerConnectionOptions, { "audio" });
+
+		REQUIRE(!rtpCapabilities["codecs"].empty());
+
+		for (const auto& codec : rtpCapabilities["codecs"])
+		{
+			REQUIRE(codec["kind"] == "audio");
+		}
+
+		REQUIRE_THROWS_AS(
+		  mediasoupclient::Handler::GetNativeRtpCapabilities(&peerConnectionOptions, { "data" }),
+		  MediaSoupClientTypeError);
+	}
+
+	SECTION("recvHandler.Receive() and recvHandler.StopReceiving() succeed")
+	{
+		mediasoupclient::RecvHandler recvHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions);
+
+		std::vector<std::string> localIds;
+
+		for (auto i = 0; i < 3; ++i)
+		{
+			auto consumerRemoteParameters = generateConsumerRemoteParameters("video/VP8");
+			auto rtpParameters            = consumerRemoteParameters["rtpParameters"];
+			mediasoupclient::RecvHandler::RecvResult recvResult;
+
+			REQUIRE_NOTHROW(
+			  recvResult = recvHandler.Receive(consumerRemoteParameters["id"], "video", &rtpParameters));
+
+			REQUIRE(recvResult.track != nullptr);
+			REQUIRE(recvResult.track->kind() == "video");
+
+			localIds.push_back(recvResult.localId);
+		}
+
+		REQUIRE(localIds == std::vector<std::string>{ "0", "1", "2" });
+
+		for (const auto& localId : localIds)
+		{
+			REQUIRE_NOTHROW(recvHandler.StopReceiving(localId));
+		}
+
+		// Closed m-sections are reused.
+		auto consumerRemoteParameters = generateConsumerRemoteParameters("audio/opus");
+		auto rtpParameters            = consumerRemoteParameters["rtpParameters"];
+		mediasoupclient::RecvHandler::RecvResult recvResult;
+
+		REQUIRE_NOTHROW(
+		  recvResult = recvHandler.Receive(consumerRemoteParameters["id"], "audio", &rtpParameters));
+
+		REQUIRE(recvResult.localId == "3");
+	}
+
+	SECTION("recvTransport.Consume() negotiates the probator along with the first video Consumer")
+	{
+		FakeRecvTransportListener recvTransportListener;
+		FakeConsumerListener consumerListener;
+		mediasoupclient::Device device;
+
+		device.Load(generateRouterRtpCapabilities(), &peerConnectionOptions);
+
+		std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(device.CreateRecvTransport(
+		  &recvTransportListener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  &peerConnectionOptions));
+
+		auto* pc                      = backend.lastPeerConnection;
+		auto consumerRemoteParameters = generateConsumerRemoteParameters("video/VP8");
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+		  &consumerListener,
+		  consumerRemoteParameters["id"].get<std::string>(),
+		  consumerRemoteParameters["producerId"].get<std::string>(),
+		  consumerRemoteParameters["kind"].get<std::string>(),
+		  &consumerRemoteParameters["rtpParameters"]));
+
+		// A single negotiation for both.
+		REQUIRE(pc->createAnswerCount == 1u);
+
+		auto remoteSdpObject = sdptransform::parse(pc->GetRemoteDescription());
+		auto& media          = remoteSdpObject["media"];
+
+		REQUIRE(media.size() == 2);
+		REQUIRE(media[0]["mid"] == consumer->GetLocalId());
+		REQUIRE(media[1]["mid"] == "probator");
+		REQUIRE(media[1]["type"] == "video");
+
+		// Not again for the next video Consumer.
+		consumerRemoteParameters = generateConsumerRemoteParameters("video/VP8");
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer2(recvTransport->Consume(
+		  &consumerListener,
+		  consumerRemoteParameters["id"].get<std::string>(),
+		  consumerRemoteParameters["producerId"].get<std::string>(),
+		  consumerRemoteParameters["kind"].get<std::string>(),
+		  &consumerRemoteParameters["rtpParameters"]));
+
+		REQUIRE(pc->createAnswerCount == 2u);
+		REQUIRE(sdptransform::parse(pc->GetRemoteDescription())["media"].size() == 3);
+
+		recvTransport->Close();
+	}
+
+	SECTION("consumer.SetLatencyHint() sets the jitter buffer minimum delay")
+	{
+		static const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+		FakeRecvTransportListener recvTransportListener;
+		FakeConsumerListener consumerListener;
+		mediasoupclient::Device device;
+
+		device.Load(generateRouterRtpCapabilities(), &peerConnectionOptions);
+
+		std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(device.CreateRecvTransport(
+		  &recvTransportListener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  &peerConnectionOptions));
+
+		auto consumerRemoteParameters = generateConsumerRemoteParameters("audio/opus");
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+		  &consumerListener,
+		  consumerRemoteParameters["id"].get<std::string>(),
+		  consumerRemoteParameters["producerId"].get<std::string>(),
+		  consumerRemoteParameters["kind"].get<std::string>(),
+		  &consumerRemoteParameters["rtpParameters"],
+		  json::object(),
+		  0.5));
+
+		auto* rtpReceiver = static_cast<FakeRtpReceiver*>(consumer->GetRtpReceiver());
+
+		REQUIRE(rtpReceiver->jitterBufferMinimumDelay == 0.5);
+
+		consumer->SetLatencyHint(0.2);
+
+		REQUIRE(rtpReceiver->jitterBufferMinimumDelay == 0.2);
+
+		consumer->SetLatencyHint(absl::nullopt);
+
+		REQUIRE(!rtpReceiver->jitterBufferMinimumDelay);
+
+		// Non-finite values are rejected and not applied.
+		REQUIRE_THROWS_AS(consumer->SetLatencyHint(NaN), MediaSoupClientTypeError);
+		REQUIRE_THROWS_AS(
+		  consumer->SetLatencyHint(std::numeric_limits<double>::infinity()), MediaSoupClientTypeError);
+		REQUIRE(!rtpReceiver->jitterBufferMinimumDelay);
+		REQUIRE(!consumer->GetLatencyHint());
+
+		consumerRemoteParameters = generateConsumerRemoteParameters("audio/opus");
+
+		mediasoupclient::RecvTransport::ConsumeOptions options;
+
+		options.id            = consumerRemoteParameters["id"].get<std::string>();
+		options.producerId    = consumerRemoteParameters["producerId"].get<std::string>();
+		options.kind          = consumerRemoteParameters["kind"].get<std::string>();
+		options.rtpParameters = consumerRemoteParameters["rtpParameters"];
+		options.latencyHint   = NaN;
+
+		std::vector<mediasoupclient::RecvTransport::ConsumeOptions> optionsList{ options };
+
+		REQUIRE_THROWS_AS(
+		  recvTransport->Consume(&consumerListener, optionsList), MediaSoupClientTypeError);
+
+		recvTransport->Close();
+	}
+
+	SECTION("a transport sharing the PeerConnection can be closed from OnConnectionStateChange()")
+	{
+		ClosingSendTransportListener sendTransportListener;
+		FakeRecvTransportListener recvTransportListener;
+		mediasoupclient::Device device;
+
+		device.Load(generateRouterRtpCapabilities(), &peerConnectionOptions);
+
+		std::unique_ptr<mediasoupclient::SendTransport> sendTransport(device.CreateSendTransport(
+		  &sendTransportListener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  &peerConnectionOptions));
+
+		auto* pc = backend.lastPeerConnection;
+
+		std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(
+		  device.CreateRecvTransport(&recvTransportListener, sendTransport.get()));
+
+		pc->SetIceConnectionState(
+		  webrtc::PeerConnectionInterface::IceConnectionState::kIceConnectionChecking);
+
+		REQUIRE(sendTransport->IsClosed());
+		REQUIRE(sendTransportListener.onConnectionStateChangeTimesCalled == 1);
+		REQUIRE(recvTransportListener.onConnectionStateChangeTimesCalled == 1);
+
+		// The closed transport is no longer notified.
+		pc->SetIceConnectionState(
+		  webrtc::PeerConnectionInterface::IceConnectionState::kIceConnectionConnected);
+
+		REQUIRE(sendTransportListener.onConnectionStateChangeTimesCalled == 1);
+		REQUIRE(recvTransportListener.onConnectionStateChangeTimesCalled == 2);
+		REQUIRE(recvTransport->GetConnectionState() == "connected");
+
+		recvTransport->Close();
+	}
+
+	SECTION("transport.GetIceRestartLatency() measures the ICE restart until connected")
+	{
+		using IceConnectionState = webrtc::PeerConnectionInterface::IceConnectionState;
+
+		FakeRecvTransportListener recvTransportListener;
+		FakeConsumerListener consumerListener;
+		mediasoupclient::Device device;
+
+		device.Load(generateRouterRtpCapabilities(), &peerConnectionOptions);
+
+		std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(device.CreateRecvTransport(
+		  &recvTransportListener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  &peerConnectionOptions));
+
+		auto* pc                      = backend.lastPeerConnection;
+		auto consumerRemoteParameters = generateConsumerRemoteParameters("audio/opus");
+		auto iceParameters            = TransportRemoteParameters["iceParameters"];
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+		  &consumerListener,
+		  consumerRemoteParameters["id"].get<std::string>(),
+		  consumerRemoteParameters["producerId"].get<std::string>(),
+		  consumerRemoteParameters["kind"].get<std::string>(),
+		  &consumerRemoteParameters["rtpParameters"]));
+
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionConnected);
+
+		// Not measured without a restart.
+		REQUIRE(recvTransport->GetIceRestartLatency().count() == 0);
+
+		auto answerCount = pc->createAnswerCount;
+
+		recvTransport->RestartIce(iceParameters);
+
+		REQUIRE(pc->createAnswerCount == answerCount + 1);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionChecking);
+
+		REQUIRE(recvTransport->GetIceRestartLatency().count() == 0);
+
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionConnected);
+
+		auto latency = recvTransport->GetIceRestartLatency();
+
+		REQUIRE(latency >= std::chrono::milliseconds(20));
+
+		// A reconnection without a restart keeps the measurement.
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionDisconnected);
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionConnected);
+
+		REQUIRE(recvTransport->GetIceRestartLatency() == latency);
+
+		// A restart whose ICE connection fails is not measured.
+		recvTransport->RestartIce(iceParameters);
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionFailed);
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionConnected);
+
+		REQUIRE(recvTransport->GetIceRestartLatency() == latency);
+
+		// Nor a restart that throws.
+		pc->onSetRemoteDescription = []() {
+			throw MediaSoupClientError("setRemoteDescription() failed");
+		};
+
+		REQUIRE_THROWS_AS(recvTransport->RestartIce(iceParameters), MediaSoupClientError);
+
+		pc->onSetRemoteDescription = nullptr;
+		pc->SetIceConnectionState(IceConnectionState::kIceConnectionConnected);
+
+		REQUIRE(recvTransport->GetIceRestartLatency() == latency);
+
+		recvTransport->Close();
+	}
+
+	SECTION("recvTransport.Close() closes its m-sections and keeps the shared PeerConnection")
+	{
+		FakeSendTransportListener sendTransportListener;
+		FakeRecvTransportListener recvTransportListener;
+		FakeConsumerListener consumerListener;
+		mediasoupclient::Device device;
+
+		device.Load(generateRouterRtpCapabilities(), &peerConnectionOptions);
+
+		std::unique_ptr<mediasoupclient::SendTransport> sendTransport(device.CreateSendTransport(
+		  &sendTransportListener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  &peerConnectionOptions));
+
+		auto* pc = backend.lastPeerConnection;
+
+		std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(
+		  device.CreateRecvTransport(&recvTransportListener, sendTransport.get()));
+
+		auto consumerRemoteParameters = generateConsumerRemoteParameters("video/VP8");
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+		  &consumerListener,
+		  consumerRemoteParameters["id"].get<std::string>(),
+		  consumerRemoteParameters["producerId"].get<std::string>(),
+		  consumerRemoteParameters["kind"].get<std::string>(),
+		  &consumerRemoteParameters["rtpParameters"]));
+
+		REQUIRE(pc->createAnswerCount == 1u);
+
+		recvTransport->Close();
+
+		// The Consumer and the probator m-sections are closed in a single negotiation.
+		REQUIRE(pc->createAnswerCount == 2u);
+
+		auto remoteSdpObject = sdptransform::parse(pc->GetRemoteDescription());
+		auto& media          = remoteSdpObject["media"];
+
+		REQUIRE(media.size() == 2);
+		REQUIRE(media[0]["mid"] == consumer->GetLocalId());
+		REQUIRE(media[0]["direction"] == "inactive");
+		REQUIRE(media[1]["mid"] == "probator");
+		REQUIRE(media[1]["port"] == 0);
+
+		// The SendTransport still uses the PeerConnection.
+		REQUIRE_NOTHROW(sendTransport->GetStats());
+
+		sendTransport->Close();
+	}
+
+	SECTION("DataChannels sharing the PeerConnection do not take the same SCTP stream id")
+	{
+		FakeSendTransportListener sendTransportListener;
+		FakeRecvTransportListener recvTransportListener;
+		FakeProducerListener producerListener;
+		FakeDataConsumerListener dataConsumerListener;
+		mediasoupclient::Device device;
+
+		device.Load(generateRouterRtpCapabilities(), &peerConnectionOptions);
+
+		std::unique_ptr<mediasoupclient::SendTransport> sendTransport(device.CreateSendTransport(
+		  &sendTransportListener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions));
+
+		std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(
+		  device.CreateRecvTransport(&recvTransportListener, sendTransport.get()));
+
+		std::unique_ptr<mediasoupclient::DataProducer> dataProducer(
+		  sendTransport->ProduceData(&producerListener));
+
+		REQUIRE(dataProducer->GetSctpStreamParameters()["streamId"] == 0);
+
+		// The server assigned the stream id of the DataProducer.
+		REQUIRE_THROWS_AS(
+		  recvTransport->ConsumeData(
+		    &dataConsumerListener, "dataConsumerId1", "dataProducerId1", 0, "foo"),
+		  MediaSoupClientError);
+
+		std::unique_ptr<mediasoupclient::DataConsumer> dataConsumer(
+		  recvTransport->ConsumeData(
+		    &dataConsumerListener, "dataConsumerId2", "dataProducerId2", 1, "foo"));
+
+		// The stream id of the DataConsumer is skipped.
+		std::unique_ptr<mediasoupclient::DataProducer> dataProducer2(
+		  sendTransport->ProduceData(&producerListener));
+
+		REQUIRE(dataProducer2->GetSctpStreamParameters()["streamId"] == 2);
+
+		recvTransport->Close();
+		sendTransport->Close();
+	}
+}
+
+// Hidden benchmark, run it with: test_mediasoupclient "[benchmark]"
+TEST_CASE("FakePeerConnection benchmark", "[.][benchmark]")
+{
+	static const json TransportRemoteParameters = generateTransportRemoteParameters();
+	static const size_t NumConsumers{ 1000u };
+
+	FakePeerConnection::Backend backend;
+	mediasoupclient::PeerConnection::Options peerConnectionOptions;
+	FakeBackendHandlerListener handlerListener;
+
+	peerConnectionOptions.backend = &backend;
+
+	mediasoupclient::RecvHandler recvHandler(
+	  &handlerListener,
+	  TransportRemoteParameters["iceParameters"],
+	  TransportRemoteParameters["iceCandidates"],
+	  TransportRemoteParameters["dtlsParameters"],
+	  TransportRemoteParameters["sctpParameters"],
+	  &peerConnectionOptions);
+
+	std::vector<std::string> localIds;
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t i{ 0u }; i < NumConsumers; ++i)
+	{
+		auto consumerRemoteParameters = generateConsumerRemoteParameters("video/VP8");
+		auto rtpParameters            = consumerRemoteParameters["rtpParameters"];
+
+		localIds.push_back(
+		  recvHandler.Receive(consumerRemoteParameters["id"], "video", &rtpParameters).localId);
+	}
+
+	auto received = std::chrono::steady_clock::now();
+
+	for (const auto& localId : localIds)
+	{
+		recvHandler.StopReceiving(localId);
+	}
+
+	auto stopped = std::chrono::steady_clock::now();
+
+	std::cout << "Receive() x " << NumConsumers << ": "
+	          << std::chrono::duration_cast<std::chrono::milliseconds>(received - start).count() << " ms"
+	          << std::endl;
+	std::cout << "StopReceiving() x " << NumConsumers << ": "
+	          << std::chrono::duration_cast<std::chrono::milliseconds>(stopped - received).count()
+	          << " ms" << std::endl;
+}
@@ -1,9 +1,13 @@
+#include "FakePeerConnection.hpp"
 #include "Handler.hpp"
 #include "MediaSoupClientErrors.hpp"
 #include "MediaStreamTrackFactory.hpp"
 #include "fakeParameters.hpp"
 #include <catch.hpp>
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <memory>
 
 static const json TransportRemoteParameters = generateTransportRemoteParameters();
@@ -20,6 +24,25 @@ public:
 	  webrtc::PeerConnectionInterface::IceConnectionState /*connectionState*/) override{};
 };
 
+// Fails its negotiations after queuing another track to send meanwhile.
+class FailingSendHandler : public mediasoupclient::SendHandler
+{
+public:
+	using mediasoupclient::SendHandler::SendHandler;
+
+public:
+	rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> queuedTrack;
+	std::future<mediasoupclient::SendHandler::SendResult> queuedFuture;
+
+private:
+	void NegotiatePendingOperations() override
+	{
+		this->queuedFuture = this->SendAsync(this->queuedTrack, nullptr, nullptr, nullptr);
+
+		throw MediaSoupClientError("fake negotiation failure");
+	};
+};
+
 TEST_CASE("Handler", "[Handler]")
 {
 	SECTION("Handler::GetNativeRtpCapabilities() succeeds")
@@ -55,6 +78,8 @@ TEST_CASE("SendHandler", "[Handler][SendHandler]")
 
 	static std::string localId;
 
+	static webrtc::RtpSenderInterface* rtpSender{ nullptr };
+
 	SECTION("sendHandler.Send() fails if a null track is provided")
 	{
 		REQUIRE_THROWS_AS(sendHandler.Send(nullptr, nullptr, nullptr, nullptr), MediaSoupClientError);
@@ -68,7 +93,8 @@ TEST_CASE("SendHandler", "[Handler][SendHandler]")
 
 		REQUIRE_NOTHROW(sendResult = sendHandler.Send(track, nullptr, nullptr, nullptr));
 
-		localId = sendResult.localId;
+		localId   = sendResult.localId;
+		rtpSender = sendResult.rtpSender;
 
 		REQUIRE(sendResult.rtpParameters["codecs"].size() == 1);
 		REQUIRE(sendResult.rtpParameters["headerExtensions"].size() == 3);
@@ -103,6 +129,63 @@ TEST_CASE("SendHandler", "[Handler][SendHandler]")
 		REQUIRE_NOTHROW(sendHandler.SetMaxSpatialLayer(localId, 1));
 	}
 
+	SECTION("sendHandler.SetRtpEncodingParameters() fails if invalid localId is provided")
+	{
+		REQUIRE_THROWS_AS(
+		  sendHandler.SetRtpEncodingParameters("", json::array()), MediaSoupClientError);
+	}
+
+	SECTION("sendHandler.SetRtpEncodingParameters() fails if encodings is not an array")
+	{
+		REQUIRE_THROWS_AS(
+		  sendHandler.SetRtpEncodingParameters(localId, json::object()), MediaSoupClientError);
+	}
+
+	SECTION("sendHandler.SetRtpEncodingParameters() succeeds if track is being sent")
+	{
+		/* clang-format off */
+		json encodings =
+		{
+			{
+				{ "maxBitrate",   100000 },
+				{ "maxFramerate", 15     }
+			}
+		};
+		/* clang-format on */
+
+		REQUIRE_NOTHROW(sendHandler.SetRtpEncodingParameters(localId, encodings));
+
+		auto encoding = rtpSender->GetParameters().encodings.front();
+
+		REQUIRE(encoding.max_bitrate_bps == 100000);
+		REQUIRE(encoding.max_framerate == 15);
+	}
+
+	SECTION("sendHandler.PauseSending() fails if invalid localId is provided")
+	{
+		REQUIRE_THROWS_AS(sendHandler.PauseSending(""), MediaSoupClientError);
+	}
+
+	SECTION("sendHandler.PauseSending() deactivates all the encodings")
+	{
+		REQUIRE_NOTHROW(sendHandler.PauseSending(localId));
+
+		for (const auto& encoding : rtpSender->GetParameters().encodings)
+		{
+			REQUIRE(!encoding.active);
+		}
+	}
+
+	SECTION("sendHandler.ResumeSending() restores the encodings")
+	{
+		REQUIRE_NOTHROW(sendHandler.ResumeSending(localId));
+
+		for (const auto& encoding : rtpSender->GetParameters().encodings)
+		{
+			REQUIRE(encoding.active);
+		}
+	}
+
 	SECTION("sendHandler.GetSenderStats() fails if invalid localId is provided")
 	{
 		REQUIRE_THROWS_AS(sendHandler.GetSenderStats(""), MediaSoupClientError);
@@ -132,6 +215,22 @@ TEST_CASE("SendHandler", "[Handler][SendHandler]")
 		REQUIRE_NOTHROW(sendHandler.StopSending(localId));
 	}
 
+	SECTION("sendHandler.StopSending() stops several tracks at once")
+	{
+		auto track1 = createAudioTrack("test-track-id-1");
+		auto track2 = createAudioTrack("test-track-id-2");
+
+		auto localId1 = sendHandler.Send(track1, nullptr, nullptr, nullptr).localId;
+		auto localId2 = sendHandler.Send(track2, nullptr, nullptr, nullptr).localId;
+
+		// Nothing is stopped if any localId is invalid.
+		REQUIRE_THROWS_AS(
+		  sendHandler.StopSending(std::vector<std::string>{ localId1, "" }), MediaSoupClientError);
+		REQUIRE_NOTHROW(sendHandler.GetSenderStats(localId1));
+
+		REQUIRE_NOTHROW(sendHandler.StopSending(std::vector<std::string>{ localId1, localId2 }));
+	}
+
 	SECTION("sendHandler.RestartIce() succeeds")
 	{
 		auto iceParameters = TransportRemoteParameters["iceParameters"];
@@ -145,6 +244,121 @@ TEST_CASE("SendHandler", "[Handler][SendHandler]")
 	}
 }
 
+TEST_CASE("SendHandler with simulcast encodings", "[Handler][SendHandler]")
+{
+	FakePeerConnection::Backend backend;
+	mediasoupclient::PeerConnection::Options peerConnectionOptions;
+	FakeHandlerListener handlerListener;
+
+	peerConnectionOptions.backend = &backend;
+
+	mediasoupclient::SendHandler sendHandler(
+	  &handlerListener,
+	  TransportRemoteParameters["iceParameters"],
+	  TransportRemoteParameters["iceCandidates"],
+	  TransportRemoteParameters["dtlsParameters"],
+	  TransportRemoteParameters["sctpParameters"],
+	  &peerConnectionOptions,
+	  RtpParametersByKind,
+	  RtpParametersByKind);
+
+	rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track(
+	  new rtc::RefCountedObject<FakeMediaStreamTrack>("video", "test-video-track-id"));
+	std::vector<webrtc::RtpEncodingParameters> sendEncodings(3);
+
+	auto sendResult = sendHandler.Send(track, &sendEncodings, nullptr, nullptr);
+	auto* rtpSender = sendResult.rtpSender;
+
+	REQUIRE(rtpSender->GetParameters().encodings.size() == 3);
+
+	SECTION("sendHandler.SetRtpEncodingParameters() matches encodings by rid")
+	{
+		/* clang-format off */
+		json encodings =
+		{
+			{
+				{ "rid",        "r2"   },
+				{ "maxBitrate", 500000 }
+			}
+		};
+		/* clang-format on */
+
+		REQUIRE_NOTHROW(sendHandler.SetRtpEncodingParameters(sendResult.localId, encodings));
+
+		auto parameters = rtpSender->GetParameters();
+
+		REQUIRE(!parameters.encodings[0].max_bitrate_bps.has_value());
+		REQUIRE(!parameters.encodings[1].max_bitrate_bps.has_value());
+		REQUIRE(parameters.encodings[2].max_bitrate_bps == 500000);
+	}
+
+	SECTION("sendHandler.SetRtpEncodingParameters() matches encodings by position")
+	{
+		/* clang-format off */
+		json encodings =
+		{
+			{ { "maxFramerate", 10 } },
+			{ { "maxFramerate", 20 } }
+		};
+		/* clang-format on */
+
+		REQUIRE_NOTHROW(sendHandler.SetRtpEncodingParameters(sendResult.localId, encodings));
+
+		auto parameters = rtpSender->GetParameters();
+
+		REQUIRE(parameters.encodings[0].max_framerate == 10);
+		REQUIRE(parameters.encodings[1].max_framerate == 20);
+		REQUIRE(!parameters.encodings[2].max_framerate.has_value());
+	}
+
+	SECTION("sendHandler.SetRtpEncodingParameters() with an unknown rid throws and modifies nothing")
+	{
+		/* clang-format off */
+		json encodings =
+		{
+			{
+				{ "rid",        "r1"   },
+				{ "maxBitrate", 200000 }
+			},
+			{
+				{ "rid",        "r9"   },
+				{ "maxBitrate", 300000 }
+			}
+		};
+		/* clang-format on */
+
+		REQUIRE_THROWS_AS(
+		  sendHandler.SetRtpEncodingParameters(sendResult.localId, encodings), MediaSoupClientTypeError);
+
+		REQUIRE(!rtpSender->GetParameters().encodings[1].max_bitrate_bps.has_value());
+	}
+
+	SECTION("sendHandler.SetRtpEncodingParameters() with a maxBitrate out of range throws")
+	{
+		auto maxBitrate = static_cast<uint64_t>(std::numeric_limits<int>::max()) + 1u;
+
+		/* clang-format off */
+		json encodings =
+		{
+			{
+				{ "rid",        "r0"       },
+				{ "maxBitrate", maxBitrate }
+			}
+		};
+		/* clang-format on */
+
+		REQUIRE_THROWS_AS(
+		  sendHandler.SetRtpEncodingParameters(sendResult.localId, encodings), MediaSoupClientTypeError);
+
+		REQUIRE(!rtpSender->GetParameters().encodings[0].max_bitrate_bps.has_value());
+
+		encodings[0]["maxBitrate"] = std::numeric_limits<int>::max();
+
+		REQUIRE_NOTHROW(sendHandler.SetRtpEncodingParameters(sendResult.localId, encodings));
+		REQUIRE(rtpSender->GetParameters().encodings[0].max_bitrate_bps == std::numeric_limits<int>::max());
+	}
+}
+
 TEST_CASE("RecvHandler", "[Handler][RecvHandler]")
 {
 	auto consumerRemoteParameters = generateConsumerRemoteParameters("audio/opus");
@@ -194,6 +408,17 @@ TEST_CASE("RecvHandler", "[Handler][RecvHandler]")
 		REQUIRE_NOTHROW(recvHandler.StopReceiving(localId));
 	}
 
+	SECTION("recvHandler.StopReceiving() stops several receivers at once")
+	{
+		auto rtpParameters1 = generateConsumerRemoteParameters("audio/opus")["rtpParameters"];
+		auto rtpParameters2 = generateConsumerRemoteParameters("video/VP8")["rtpParameters"];
+
+		auto localId1 = recvHandler.Receive("test1", "audio", &rtpParameters1).localId;
+		auto localId2 = recvHandler.Receive("test2", "video", &rtpParameters2).localId;
+
+		REQUIRE_NOTHROW(recvHandler.StopReceiving(std::vector<std::string>{ localId1, localId2 }));
+	}
+
 	SECTION("recvHandler.RestartIce() succeeds")
 	{
 		auto iceParameters = TransportRemoteParameters["iceParameters"];
@@ -205,4 +430,206 @@ TEST_CASE("RecvHandler", "[Handler][RecvHandler]")
 	{
 		REQUIRE_NOTHROW(recvHandler.UpdateIceServers(json::array()));
 	}
+
+}
+
+TEST_CASE("Handler negotiation coalescing", "[Handler]")
+{
+	FakePeerConnection::Backend backend;
+	mediasoupclient::PeerConnection::Options peerConnectionOptions;
+	FakeHandlerListener handlerListener;
+
+	peerConnectionOptions.backend = &backend;
+
+	SECTION("recvHandler.ReceiveAsync() negotiates a batch once")
+	{
+		mediasoupclient::RecvHandler recvHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions);
+
+		auto* pc = backend.lastPeerConnection;
+		std::vector<mediasoupclient::RecvHandler::ReceiveOptions> optionsList(5);
+
+		for (size_t idx{ 0u }; idx < optionsList.size(); ++idx)
+		{
+			optionsList[idx].id            = "test" + std::to_string(idx);
+			optionsList[idx].kind          = "video";
+			optionsList[idx].rtpParameters = generateConsumerRemoteParameters("video/VP8")["rtpParameters"];
+		}
+
+		auto futures = recvHandler.ReceiveAsync(optionsList);
+
+		for (auto& future : futures)
+		{
+			REQUIRE(future.get().track->kind() == "video");
+		}
+
+		REQUIRE(pc->createAnswerCount == 1u);
+	}
+
+	SECTION("recvHandler.ReceiveAsync() merges operations queued while negotiating")
+	{
+		mediasoupclient::RecvHandler recvHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions);
+
+		auto* pc = backend.lastPeerConnection;
+		std::vector<std::future<mediasoupclient::RecvHandler::RecvResult>> queuedFutures;
+
+		// Queue more operations while the first negotiation is in flight.
+		pc->onSetRemoteDescription = [&]() {
+			if (!queuedFutures.empty())
+				return;
+
+			for (auto i = 0; i < 3; ++i)
+			{
+				auto rtpParameters = generateConsumerRemoteParameters("video/VP8")["rtpParameters"];
+
+				queuedFutures.push_back(
+				  recvHandler.ReceiveAsync("queued" + std::to_string(i), "video", rtpParameters));
+			}
+		};
+
+		auto rtpParameters = generateConsumerRemoteParameters("audio/opus")["rtpParameters"];
+		auto future        = recvHandler.ReceiveAsync("test", "audio", rtpParameters);
+
+		REQUIRE(future.get().track->kind() == "audio");
+		REQUIRE(queuedFutures.size() == 3u);
+
+		for (auto& queuedFuture : queuedFutures)
+		{
+			REQUIRE(queuedFuture.get().track->kind() == "video");
+		}
+
+		// The three queued operations took a single negotiation.
+		REQUIRE(pc->createAnswerCount == 2u);
+	}
+
+	SECTION("sendHandler.SendAsync() merges operations queued while negotiating")
+	{
+		mediasoupclient::SendHandler sendHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions,
+		  RtpParametersByKind,
+		  RtpParametersByKind);
+
+		auto* pc = backend.lastPeerConnection;
+		std::vector<rtc::scoped_refptr<webrtc::MediaStreamTrackInterface>> tracks;
+		std::vector<std::future<mediasoupclient::SendHandler::SendResult>> queuedFutures;
+
+		for (auto i = 0; i < 4; ++i)
+		{
+			tracks.emplace_back(
+			  new rtc::RefCountedObject<FakeMediaStreamTrack>("video", "track" + std::to_string(i)));
+		}
+
+		// Queue more operations while the first negotiation is in flight.
+		pc->onSetRemoteDescription = [&]() {
+			if (!queuedFutures.empty())
+				return;
+
+			for (size_t idx{ 1u }; idx < tracks.size(); ++idx)
+			{
+				queuedFutures.push_back(sendHandler.SendAsync(tracks[idx], nullptr, nullptr, nullptr));
+			}
+		};
+
+		auto future = sendHandler.SendAsync(tracks[0], nullptr, nullptr, nullptr);
+
+		REQUIRE_NOTHROW(future.get());
+		REQUIRE(queuedFutures.size() == 3u);
+
+		for (auto& queuedFuture : queuedFutures)
+		{
+			REQUIRE_NOTHROW(queuedFuture.get());
+		}
+
+		// The three queued operations took a single negotiation.
+		REQUIRE(pc->createOfferCount == 2u);
+	}
+
+	SECTION("a failed negotiation rejects every merged operation")
+	{
+		mediasoupclient::SendHandler sendHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions,
+		  RtpParametersByKind,
+		  RtpParametersByKind);
+
+		auto* pc = backend.lastPeerConnection;
+		std::vector<rtc::scoped_refptr<webrtc::MediaStreamTrackInterface>> tracks;
+		std::vector<std::future<mediasoupclient::SendHandler::SendResult>> queuedFutures;
+
+		for (auto i = 0; i < 3; ++i)
+		{
+			tracks.emplace_back(
+			  new rtc::RefCountedObject<FakeMediaStreamTrack>("video", "track" + std::to_string(i)));
+		}
+
+		// Queue more operations during the first negotiation and fail the second one.
+		pc->onSetRemoteDescription = [&]() {
+			if (!queuedFutures.empty())
+				throw MediaSoupClientError("fake SetRemoteDescription failure");
+
+			for (size_t idx{ 1u }; idx < tracks.size(); ++idx)
+			{
+				queuedFutures.push_back(sendHandler.SendAsync(tracks[idx], nullptr, nullptr, nullptr));
+			}
+		};
+
+		auto future = sendHandler.SendAsync(tracks[0], nullptr, nullptr, nullptr);
+
+		REQUIRE_NOTHROW(future.get());
+		REQUIRE(queuedFutures.size() == 2u);
+
+		for (auto& queuedFuture : queuedFutures)
+		{
+			REQUIRE_THROWS_AS(queuedFuture.get(), MediaSoupClientError);
+		}
+
+		REQUIRE(pc->createOfferCount == 2u);
+	}
+
+	SECTION("a negotiation that throws rejects the operations queued meanwhile")
+	{
+		FailingSendHandler sendHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions,
+		  RtpParametersByKind,
+		  RtpParametersByKind);
+
+		rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track(
+		  new rtc::RefCountedObject<FakeMediaStreamTrack>("video", "track"));
+
+		sendHandler.queuedTrack = new rtc::RefCountedObject<FakeMediaStreamTrack>("video", "queued");
+
+		REQUIRE_THROWS_AS(
+		  sendHandler.SendAsync(track, nullptr, nullptr, nullptr), MediaSoupClientError);
+
+		// Not left waiting for a negotiation nobody does.
+		REQUIRE(sendHandler.queuedFuture.valid());
+		REQUIRE(
+		  sendHandler.queuedFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+		REQUIRE_THROWS_AS(sendHandler.queuedFuture.get(), MediaSoupClientError);
+	}
 }
@@ -0,0 +1,63 @@
+#include "helpers.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "sdptransform.hpp"
+#include "sdp/LocalSdp.hpp"
+#include "sdp/Utils.hpp"
+#include <catch.hpp>
+
+TEST_CASE("Sdp::LocalSdp", "[Sdp][LocalSdp]")
+{
+	auto sdp       = helpers::readFile("test/data/audio_video.sdp");
+	auto sdpObject = sdptransform::parse(sdp);
+
+	mediasoupclient::Sdp::LocalSdp localSdp(sdp);
+
+	SECTION("media sections are indexed")
+	{
+		REQUIRE(localSdp.GetMediaSectionCount() == 2u);
+		REQUIRE(localSdp.GetMediaType(0) == "audio");
+		REQUIRE(localSdp.GetMediaType(1) == "video");
+		REQUIRE(!localSdp.IsMediaSectionClosed(0));
+		REQUIRE(*localSdp.GetMediaSectionIdx("audio") == 0u);
+		REQUIRE(*localSdp.GetMediaSectionIdx("video") == 1u);
+		REQUIRE(!localSdp.GetMediaSectionIdx("unknown"));
+		REQUIRE_THROWS_AS(localSdp.GetMediaType(2), MediaSoupClientError);
+	}
+
+	SECTION("attributes are read as in the parsed SDP")
+	{
+		REQUIRE(*localSdp.GetAttribute(0, "setup") == sdpObject["media"][0]["setup"].get<std::string>());
+		REQUIRE(*localSdp.GetAttribute(1, "ice-ufrag") == sdpObject["media"][1]["iceUfrag"].get<std::string>());
+		REQUIRE(!localSdp.GetAttribute(0, "unknown"));
+		REQUIRE(localSdp.GetAttributes(0, "rtpmap").size() == sdpObject["media"][0]["rtp"].size());
+	}
+
+	SECTION("ParseMediaSection() matches sdptransform::parse()")
+	{
+		for (size_t idx{ 0u }; idx < localSdp.GetMediaSectionCount(); ++idx)
+		{
+			REQUIRE(localSdp.ParseMediaSection(idx) == sdpObject["media"][idx]);
+		}
+	}
+
+	SECTION("ExtractDtlsParameters() matches Sdp::Utils::extractDtlsParameters()")
+	{
+		REQUIRE(localSdp.ExtractDtlsParameters() == mediasoupclient::Sdp::Utils::extractDtlsParameters(sdpObject));
+	}
+
+	SECTION("SetMediaSection() replaces just the given media section")
+	{
+		auto mediaObject = localSdp.ParseMediaSection(0);
+
+		mediaObject["direction"] = "inactive";
+
+		localSdp.SetMediaSection(0, mediaObject);
+
+		auto newSdpObject = sdptransform::parse(localSdp.GetSdp());
+
+		REQUIRE(newSdpObject["media"].size() == 2u);
+		REQUIRE(newSdpObject["media"][0]["direction"] == "inactive");
+		REQUIRE(newSdpObject["media"][1] == sdpObject["media"][1]);
+		REQUIRE(*localSdp.GetMediaSectionIdx("video") == 1u);
+	}
+}
@@ -0,0 +1,197 @@
+#include "LoopbackRouter.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "Utils.hpp"
+#include "fakeParameters.hpp"
+#include <algorithm>
+
+using json = nlohmann::json;
+
+static bool isRtxCodec(const json& codec)
+{
+	auto mimeType = codec["mimeType"].get<std::string>();
+
+	std::transform(mimeType.begin(), mimeType.end(), mimeType.begin(), ::tolower);
+
+	return mimeType.size() > 4 && mimeType.substr(mimeType.size() - 4) == "/rtx";
+}
+
+LoopbackRouter::LoopbackRouter() : rtpCapabilities(generateRouterRtpCapabilities())
+{
+}
+
+const json& LoopbackRouter::GetRtpCapabilities() const
+{
+	return this->rtpCapabilities;
+}
+
+json LoopbackRouter::CreateWebRtcTransport() const
+{
+	return generateTransportRemoteParameters();
+}
+
+json LoopbackRouter::Consume(const std::string& producerId)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto producerIt = this->producers.find(producerId);
+
+	if (producerIt == this->producers.end())
+		MSC_THROW_ERROR("Producer not found [id:%s]", producerId.c_str());
+
+	const auto& producer     = producerIt->second;
+	const auto& routerCodecs = this->rtpCapabilities["codecs"];
+	const auto& mediaCodec   = producer.rtpParameters["codecs"][0];
+
+	// Map the Producer codec into the router one, as mediasoup does.
+	auto routerCodecIt =
+	  std::find_if(routerCodecs.begin(), routerCodecs.end(), [&mediaCodec](const json& codec) {
+		  return codec["mimeType"] == mediaCodec["mimeType"] && codec["clockRate"] == mediaCodec["clockRate"];
+	  });
+
+	if (routerCodecIt == routerCodecs.end())
+		MSC_THROW_ERROR("unsupported codec [mimeType:%s]", mediaCodec["mimeType"].get<std::string>().c_str());
+
+	auto payloadType = (*routerCodecIt)["preferredPayloadType"].get<uint8_t>();
+	auto codecs      = json::array();
+	auto codec       = *routerCodecIt;
+
+	codec["payloadType"] = payloadType;
+	codec.erase("preferredPayloadType");
+	codec.erase("kind");
+	codecs.push_back(codec);
+
+	bool hasRtx = std::any_of(
+	  producer.rtpParameters["codecs"].begin(), producer.rtpParameters["codecs"].end(), isRtxCodec);
+
+	if (hasRtx)
+	{
+		auto rtxCodecIt =
+		  std::find_if(routerCodecs.begin(), routerCodecs.end(), [payloadType](const json& codec) {
+			  return isRtxCodec(codec) && codec["parameters"]["apt"] == payloadType;
+		  });
+
+		if (rtxCodecIt != routerCodecs.end())
+		{
+			auto rtxCodec = *rtxCodecIt;
+
+			rtxCodec["payloadType"] = rtxCodec["preferredPayloadType"];
+			rtxCodec.erase("preferredPayloadType");
+			rtxCodec.erase("kind");
+			codecs.push_back(rtxCodec);
+		}
+		else
+		{
+			hasRtx = false;
+		}
+	}
+
+	auto headerExtensions = json::array();
+
+	for (const auto& ext : this->rtpCapabilities["headerExtensions"])
+	{
+		if (ext["kind"] != producer.kind)
+			continue;
+
+		headerExtensions.push_back({ { "uri", ext["uri"] }, { "id", ext["preferredId"] } });
+	}
+
+	// Single stream, whatever the number of Producer encodings.
+	json encoding = { { "ssrc", mediasoupclient::Utils::getRandomInteger(100000000, 999999999) } };
+
+	if (hasRtx)
+		encoding["rtx"] = { { "ssrc", mediasoupclient::Utils::getRandomInteger(100000000, 999999999) } };
+
+	/* clang-format off */
+	json rtpParameters =
+	{
+		{ "codecs",           codecs                    },
+		{ "headerExtensions", headerExtensions          },
+		{ "encodings",        json::array({ encoding }) },
+		{ "rtcp",
+			{
+				{ "cname",       producer.rtpParameters["rtcp"]["cname"] },
+				{ "reducedSize", true                                    },
+				{ "mux",         true                                    }
+			}
+		}
+	};
+
+	return
+	{
+		{ "id",            mediasoupclient::Utils::getRandomString(12) },
+		{ "producerId",    producerId                                  },
+		{ "kind",          producer.kind                               },
+		{ "rtpParameters", rtpParameters                               }
+	};
+	/* clang-format on */
+}
+
+const LoopbackRouter::ProducerInfo& LoopbackRouter::GetProducer(const std::string& producerId)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto producerIt = this->producers.find(producerId);
+
+	if (producerIt == this->producers.end())
+		MSC_THROW_ERROR("Producer not found [id:%s]", producerId.c_str());
+
+	return producerIt->second;
+}
+
+size_t LoopbackRouter::GetConnectCount()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	return this->connectedTransports.size();
+}
+
+std::future<void> LoopbackRouter::OnConnect(mediasoupclient::Transport* transport, const json& dtlsParameters)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	this->connectedTransports[transport->GetId()] = dtlsParameters;
+
+	std::promise<void> promise;
+
+	promise.set_value();
+
+	return promise.get_future();
+}
+
+void LoopbackRouter::OnConnectionStateChange(
+  mediasoupclient::Transport* /*transport*/, const std::string& /*connectionState*/)
+{
+}
+
+std::future<std::string> LoopbackRouter::OnProduce(
+  mediasoupclient::SendTransport* /*transport*/,
+  const std::string& kind,
+  json rtpParameters,
+  const json& /*appData*/)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	auto producerId = mediasoupclient::Utils::getRandomString(12);
+
+	this->producers[producerId] = { kind, std::move(rtpParameters), Clock::now() };
+
+	std::promise<std::string> promise;
+
+	promise.set_value(producerId);
+
+	return promise.get_future();
+}
+
+std::future<std::string> LoopbackRouter::OnProduceData(
+  mediasoupclient::SendTransport* /*transport*/,
+  const json& /*sctpStreamParameters*/,
+  const std::string& /*label*/,
+  const std::string& /*protocol*/,
+  const json& /*appData*/)
+{
+	std::promise<std::string> promise;
+
+	promise.set_value(mediasoupclient::Utils::getRandomString(12));
+
+	return promise.get_future();
+}
@@ -0,0 +1,382 @@
+#include "FakePeerConnection.hpp"
+#include "FakeTransportListener.hpp"
+#include "LoopbackRouter.hpp"
+#include "MediaStreamTrackFactory.hpp"
+#include "mediasoupclient.hpp"
+#include <catch.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static double toMs(LoopbackRouter::Clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static void printDistribution(const std::string& name, std::vector<double> samples)
+{
+	std::sort(samples.begin(), samples.end());
+
+	auto percentile = [&samples](double p) {
+		return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1))];
+	};
+
+	std::cout << name << " [ms]: min:" << samples.front() << " p50:" << percentile(0.50)
+	          << " p95:" << percentile(0.95) << " p99:" << percentile(0.99) << " max:" << samples.back()
+	          << std::endl;
+}
+
+TEST_CASE("LoopbackRouter", "[LoopbackRouter]")
+{
+	static LoopbackRouter router;
+	static FakeProducerListener producerListener;
+	static FakeConsumerListener consumerListener;
+	static std::unique_ptr<mediasoupclient::Device> device;
+	static std::unique_ptr<mediasoupclient::SendTransport> sendTransport;
+	static std::unique_ptr<mediasoupclient::RecvTransport> recvTransport;
+
+	SECTION("device.Load() succeeds with the router RTP capabilities")
+	{
+		device.reset(new mediasoupclient::Device());
+
+		REQUIRE_NOTHROW(device->Load(router.GetRtpCapabilities()));
+	}
+
+	SECTION("transports are created with the router transport parameters")
+	{
+		auto sendParameters = router.CreateWebRtcTransport();
+		auto recvParameters = router.CreateWebRtcTransport();
+
+		REQUIRE_NOTHROW(sendTransport.reset(device->CreateSendTransport(
+		  &router,
+		  sendParameters["id"],
+		  sendParameters["iceParameters"],
+		  sendParameters["iceCandidates"],
+		  sendParameters["dtlsParameters"])));
+
+		REQUIRE_NOTHROW(recvTransport.reset(device->CreateRecvTransport(
+		  &router,
+		  recvParameters["id"],
+		  recvParameters["iceParameters"],
+		  recvParameters["iceCandidates"],
+		  recvParameters["dtlsParameters"])));
+	}
+
+	SECTION("Producers are consumed through the router")
+	{
+		auto audioTrack = createAudioTrack("loopback-audio-track-id");
+		auto videoTrack = createVideoTrack("loopback-video-track-id");
+
+		std::unique_ptr<mediasoupclient::Producer> audioProducer(
+		  sendTransport->Produce(&producerListener, audioTrack, nullptr, nullptr, nullptr));
+		std::unique_ptr<mediasoupclient::Producer> videoProducer(
+		  sendTransport->Produce(&producerListener, videoTrack, nullptr, nullptr, nullptr));
+
+		for (auto* producer : { audioProducer.get(), videoProducer.get() })
+		{
+			auto consumerParameters = router.Consume(producer->GetId());
+			auto rtpParameters      = consumerParameters["rtpParameters"];
+
+			std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+			  &consumerListener,
+			  consumerParameters["id"],
+			  consumerParameters["producerId"],
+			  consumerParameters["kind"],
+			  &rtpParameters));
+
+			REQUIRE(consumer->GetProducerId() == producer->GetId());
+			REQUIRE(consumer->GetKind() == producer->GetKind());
+			REQUIRE(consumer->GetTrack() != nullptr);
+			REQUIRE(
+			  consumer->GetRtpParameters()["rtcp"]["cname"] ==
+			  producer->GetRtpParameters()["rtcp"]["cname"]);
+
+			consumer->Close();
+		}
+
+		REQUIRE(router.GetConnectCount() == 2u);
+
+		audioProducer->Close();
+		videoProducer->Close();
+	}
+
+	SECTION("Consumers take a latency hint")
+	{
+		auto videoTrack = createVideoTrack("loopback-latency-video-track-id");
+
+		std::unique_ptr<mediasoupclient::Producer> producer(
+		  sendTransport->Produce(&producerListener, videoTrack, nullptr, nullptr, nullptr));
+
+		auto consumerParameters = router.Consume(producer->GetId());
+		auto rtpParameters      = consumerParameters["rtpParameters"];
+
+		REQUIRE_THROWS_AS(
+		  recvTransport->Consume(
+		    &consumerListener,
+		    consumerParameters["id"],
+		    consumerParameters["producerId"],
+		    consumerParameters["kind"],
+		    &rtpParameters,
+		    nlohmann::json::object(),
+		    -1.0),
+		  MediaSoupClientTypeError);
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+		  &consumerListener,
+		  consumerParameters["id"],
+		  consumerParameters["producerId"],
+		  consumerParameters["kind"],
+		  &rtpParameters,
+		  nlohmann::json::object(),
+		  0.0));
+
+		REQUIRE(consumer->GetLatencyHint() == 0.0);
+
+		consumer->SetLatencyHint(0.1);
+
+		REQUIRE(consumer->GetLatencyHint() == 0.1);
+
+		consumer->SetLatencyHint(absl::nullopt);
+
+		REQUIRE(!consumer->GetLatencyHint());
+		REQUIRE_THROWS_AS(
+		  consumer->SetLatencyHint(mediasoupclient::Consumer::MaxLatencyHint + 1), MediaSoupClientTypeError);
+
+		consumer->Close();
+		producer->Close();
+	}
+
+	SECTION("router.Consume() fails for an unknown Producer")
+	{
+		REQUIRE_THROWS_AS(router.Consume("unknown"), MediaSoupClientError);
+	}
+
+	SECTION("transports are closed")
+	{
+		sendTransport->Close();
+		recvTransport->Close();
+	}
+}
+
+TEST_CASE("LoopbackRouter with a shared PeerConnection", "[LoopbackRouter]")
+{
+	LoopbackRouter router;
+	FakeProducerListener producerListener;
+	FakeConsumerListener consumerListener;
+	mediasoupclient::Device device;
+
+	device.Load(router.GetRtpCapabilities());
+
+	auto transportParameters = router.CreateWebRtcTransport();
+
+	std::unique_ptr<mediasoupclient::SendTransport> sendTransport(device.CreateSendTransport(
+	  &router,
+	  transportParameters["id"],
+	  transportParameters["iceParameters"],
+	  transportParameters["iceCandidates"],
+	  transportParameters["dtlsParameters"]));
+
+	std::unique_ptr<mediasoupclient::RecvTransport> recvTransport;
+
+	REQUIRE_NOTHROW(recvTransport.reset(device.CreateRecvTransport(&router, sendTransport.get())));
+	REQUIRE(recvTransport->GetId() == sendTransport->GetId());
+
+	auto track = createVideoTrack("shared-video-track-id");
+
+	std::unique_ptr<mediasoupclient::Producer> producer(
+	  sendTransport->Produce(&producerListener, track, nullptr, nullptr, nullptr));
+
+	auto consumerParameters = router.Consume(producer->GetId());
+	auto rtpParameters      = consumerParameters["rtpParameters"];
+
+	std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+	  &consumerListener,
+	  consumerParameters["id"],
+	  consumerParameters["producerId"],
+	  consumerParameters["kind"],
+	  &rtpParameters));
+
+	REQUIRE(consumer->GetTrack() != nullptr);
+	REQUIRE(consumer->GetLocalId() != producer->GetLocalId());
+	// A single ICE/DTLS transport.
+	REQUIRE(router.GetConnectCount() == 1u);
+
+	consumer->Close();
+	producer->Close();
+
+	REQUIRE_THROWS_AS(device.CreateRecvTransport(&router, nullptr), MediaSoupClientError);
+
+	recvTransport->Close();
+	sendTransport->Close();
+}
+
+// Hidden benchmark, run it with: test_mediasoupclient "[benchmark]"
+// Measures the time from Produce() to the remote track existing over libwebrtc
+// PeerConnections. The LoopbackRouter just answers the signaling and no RTP
+// flows, so it is not the time to the first frame.
+TEST_CASE("LoopbackRouter benchmark", "[.][benchmark]")
+{
+	static const size_t Iterations{ 200u };
+
+	LoopbackRouter router;
+	FakeProducerListener producerListener;
+	FakeConsumerListener consumerListener;
+	mediasoupclient::Device device;
+
+	device.Load(router.GetRtpCapabilities());
+
+	auto sendParameters = router.CreateWebRtcTransport();
+	auto recvParameters = router.CreateWebRtcTransport();
+
+	std::unique_ptr<mediasoupclient::SendTransport> sendTransport(device.CreateSendTransport(
+	  &router,
+	  sendParameters["id"],
+	  sendParameters["iceParameters"],
+	  sendParameters["iceCandidates"],
+	  sendParameters["dtlsParameters"]));
+
+	std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(device.CreateRecvTransport(
+	  &router,
+	  recvParameters["id"],
+	  recvParameters["iceParameters"],
+	  recvParameters["iceCandidates"],
+	  recvParameters["dtlsParameters"]));
+
+	std::vector<double> produceSamples;
+	std::vector<double> consumeSamples;
+	std::vector<double> remoteTrackSamples;
+
+	for (size_t i{ 0u }; i < Iterations; ++i)
+	{
+		auto track = createVideoTrack("loopback-video-track-" + std::to_string(i));
+
+		auto start = LoopbackRouter::Clock::now();
+
+		std::unique_ptr<mediasoupclient::Producer> producer(
+		  sendTransport->Produce(&producerListener, track, nullptr, nullptr, nullptr));
+
+		auto produced           = LoopbackRouter::Clock::now();
+		auto consumerParameters = router.Consume(producer->GetId());
+		auto rtpParameters      = consumerParameters["rtpParameters"];
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer(recvTransport->Consume(
+		  &consumerListener,
+		  consumerParameters["id"],
+		  consumerParameters["producerId"],
+		  consumerParameters["kind"],
+		  &rtpParameters));
+
+		// The remote track exists.
+		auto consumed = LoopbackRouter::Clock::now();
+
+		produceSamples.push_back(toMs(produced - start));
+		consumeSamples.push_back(toMs(consumed - produced));
+		remoteTrackSamples.push_back(toMs(consumed - start));
+
+		consumer->Close();
+		producer->Close();
+	}
+
+	printDistribution("produce", produceSamples);
+	printDistribution("consume", consumeSamples);
+	printDistribution("time-to-remote-track", remoteTrackSamples);
+
+	sendTransport->Close();
+	recvTransport->Close();
+}
+
+// Hidden benchmark, run it with: test_mediasoupclient "[benchmark]"
+// Measures Consume() with more and more live Consumers over the fake
+// PeerConnection, so libwebrtc costs are left out. It prints the median time
+// of each batch of Consumers and its ratio to the first batch, which stays
+// close to 1 as long as finding the new transceiver does not depend on the
+// number of transceivers. Just the SDP, which grows with the m-sections, is
+// expected to make it grow a little.
+TEST_CASE("LoopbackRouter consume scaling benchmark", "[.][benchmark]")
+{
+	static const size_t Consumers{ 500u };
+	static const size_t BatchSize{ 100u };
+
+	LoopbackRouter router;
+	FakePeerConnection::Backend backend;
+	mediasoupclient::PeerConnection::Options peerConnectionOptions;
+	FakeProducerListener producerListener;
+	FakeConsumerListener consumerListener;
+	mediasoupclient::Device device;
+
+	peerConnectionOptions.backend = &backend;
+
+	device.Load(router.GetRtpCapabilities(), &peerConnectionOptions);
+
+	auto sendParameters = router.CreateWebRtcTransport();
+	auto recvParameters = router.CreateWebRtcTransport();
+
+	std::unique_ptr<mediasoupclient::SendTransport> sendTransport(device.CreateSendTransport(
+	  &router,
+	  sendParameters["id"],
+	  sendParameters["iceParameters"],
+	  sendParameters["iceCandidates"],
+	  sendParameters["dtlsParameters"],
+	  &peerConnectionOptions));
+
+	std::unique_ptr<mediasoupclient::RecvTransport> recvTransport(device.CreateRecvTransport(
+	  &router,
+	  recvParameters["id"],
+	  recvParameters["iceParameters"],
+	  recvParameters["iceCandidates"],
+	  recvParameters["dtlsParameters"],
+	  &peerConnectionOptions));
+
+	rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track(
+	  new rtc::RefCountedObject<FakeMediaStreamTrack>("video", "loopback-video-track-id"));
+
+	std::unique_ptr<mediasoupclient::Producer> producer(
+	  sendTransport->Produce(&producerListener, track, nullptr, nullptr, nullptr));
+
+	std::vector<std::unique_ptr<mediasoupclient::Consumer>> consumers;
+	std::vector<double> batchSamples;
+	double firstBatchMedian{ 0 };
+
+	for (size_t i{ 0u }; i < Consumers; ++i)
+	{
+		auto consumerParameters = router.Consume(producer->GetId());
+		auto rtpParameters      = consumerParameters["rtpParameters"];
+
+		auto start = LoopbackRouter::Clock::now();
+
+		consumers.emplace_back(recvTransport->Consume(
+		  &consumerListener,
+		  consumerParameters["id"],
+		  consumerParameters["producerId"],
+		  consumerParameters["kind"],
+		  &rtpParameters));
+
+		batchSamples.push_back(toMs(LoopbackRouter::Clock::now() - start));
+
+		if (batchSamples.size() < BatchSize)
+			continue;
+
+		std::sort(batchSamples.begin(), batchSamples.end());
+
+		auto median = batchSamples[batchSamples.size() / 2];
+
+		if (i + 1 == BatchSize)
+			firstBatchMedian = median;
+
+		std::cout << "consume with " << (i + 1 - BatchSize) << "+ live consumers [ms]: p50:" << median
+		          << " ratio to the first batch:" << (median / firstBatchMedian) << std::endl;
+
+		batchSamples.clear();
+	}
+
+	for (auto& consumer : consumers)
+	{
+		consumer->Close();
+	}
+
+	producer->Close();
+	sendTransport->Close();
+	recvTransport->Close();
+}
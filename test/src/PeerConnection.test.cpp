@@ -18,6 +18,23 @@ TEST_CASE("PeerConnection", "[PeerConnection]")
 		auto configuration = pc.GetConfiguration();
 	}
 
+	SECTION("'pc.GetConfiguration()' reflects the continualGathering option")
+	{
+		mediasoupclient::PeerConnection::PrivateListener listener;
+		mediasoupclient::PeerConnection::Options peerConnectionOptions;
+
+		peerConnectionOptions.continualGathering = true;
+
+		mediasoupclient::PeerConnection pc(&listener, &peerConnectionOptions);
+
+		auto configuration = pc.GetConfiguration();
+
+		REQUIRE(
+		  configuration.continual_gathering_policy ==
+		  webrtc::PeerConnectionInterface::GATHER_CONTINUALLY);
+		REQUIRE(configuration.ice_candidate_pool_size == 2);
+	}
+
 	/*
 	 * NOTE: Fails if peerconnection is created with Unified Plan SDP semantics.
 	 * See: src/PeerConnection.cpp (constructor).
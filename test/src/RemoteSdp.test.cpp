@@ -1,7 +1,30 @@
+#include "fakeParameters.hpp"
 #include "helpers.hpp"
 #include "sdptransform.hpp"
 #include "sdp/RemoteSdp.hpp"
 #include <catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Exposes the SDP object so it can be written by sdptransform.
+class TestRemoteSdp : public mediasoupclient::Sdp::RemoteSdp
+{
+public:
+	using mediasoupclient::Sdp::RemoteSdp::RemoteSdp;
+
+	nlohmann::json GetSdpObject() const
+	{
+		auto sdpObject = this->sdpObject;
+
+		for (const auto& mediaSection : this->mediaSections)
+		{
+			sdpObject["media"].push_back(mediaSection->GetObject());
+		}
+
+		return sdpObject;
+	}
+};
 
 TEST_CASE("SendRemoteSdp", "[SendRemoteSdp]")
 {
@@ -364,3 +387,340 @@ TEST_CASE("SendRemoteSdp", "[SendRemoteSdp]")
 		delete remoteSdp;
 	}
 }
+
+TEST_CASE("MixedRemoteSdp", "[MixedRemoteSdp]")
+{
+	SECTION("offer media sections take the DTLS role once known")
+	{
+		auto transportRemoteParameters = generateTransportRemoteParameters();
+		auto consumerRemoteParameters  = generateConsumerRemoteParameters("audio/opus");
+
+		auto* remoteSdp = new mediasoupclient::Sdp::RemoteSdp(
+		  transportRemoteParameters["iceParameters"],
+		  transportRemoteParameters["iceCandidates"],
+		  transportRemoteParameters["dtlsParameters"],
+		  nullptr);
+
+		remoteSdp->SetMixedRoles();
+		remoteSdp->Receive(
+		  "0", "audio", consumerRemoteParameters["rtpParameters"], "stream-id", "track-id");
+
+		auto sdpObject = sdptransform::parse(remoteSdp->GetSdp());
+
+		REQUIRE(sdpObject["media"][0]["setup"] == "actpass");
+
+		remoteSdp->UpdateDtlsRole("server");
+
+		sdpObject = sdptransform::parse(remoteSdp->GetSdp());
+
+		REQUIRE(sdpObject["media"][0]["setup"] == "passive");
+
+		remoteSdp->Receive(
+		  "1", "audio", consumerRemoteParameters["rtpParameters"], "stream-id", "track-id");
+
+		sdpObject = sdptransform::parse(remoteSdp->GetSdp());
+
+		REQUIRE(sdpObject["media"][1]["setup"] == "passive");
+		REQUIRE(remoteSdp->HasMediaSection("1"));
+		REQUIRE(remoteSdp->GetMediaSectionIdx("1") == 1u);
+
+		delete remoteSdp;
+	}
+}
+
+TEST_CASE("RemoteSdp writes the same SDP as sdptransform", "[RemoteSdp]")
+{
+	auto transportRemoteParameters = generateTransportRemoteParameters();
+	std::mt19937 random(1234u);
+	std::vector<std::string> mimeTypes = { "audio/opus", "audio/ISAC", "video/VP8" };
+
+	TestRemoteSdp remoteSdp(
+	  transportRemoteParameters["iceParameters"],
+	  transportRemoteParameters["iceCandidates"],
+	  transportRemoteParameters["dtlsParameters"],
+	  transportRemoteParameters["sctpParameters"]);
+
+	std::vector<std::string> mids;
+	size_t nextMid{ 0u };
+
+	for (auto i = 0; i < 300; ++i)
+	{
+		auto operation = random() % 10u;
+
+		// Close a random m-section.
+		if (operation < 3u && !mids.empty())
+		{
+			auto midIdx = random() % mids.size();
+
+			remoteSdp.CloseMediaSection(mids[midIdx]);
+			mids.erase(mids.begin() + midIdx);
+		}
+		else if (operation == 3u)
+		{
+			remoteSdp.UpdateDtlsRole(random() % 2u ? "client" : "server");
+		}
+		else if (operation == 4u)
+		{
+			auto iceParameters                = transportRemoteParameters["iceParameters"];
+			iceParameters["usernameFragment"] = "ufrag" + std::to_string(i);
+
+			remoteSdp.UpdateIceParameters(iceParameters);
+		}
+		else
+		{
+			const auto& mimeType    = mimeTypes[random() % mimeTypes.size()];
+			auto consumerParameters = generateConsumerRemoteParameters(mimeType);
+			auto mid                = std::to_string(nextMid++);
+
+			remoteSdp.Receive(
+			  mid,
+			  consumerParameters["kind"],
+			  consumerParameters["rtpParameters"],
+			  consumerParameters["rtpParameters"]["rtcp"]["cname"],
+			  consumerParameters["id"]);
+
+			mids.push_back(mid);
+		}
+
+		auto sdp       = remoteSdp.GetSdp();
+		auto sdpObject = remoteSdp.GetSdpObject();
+
+		REQUIRE(sdp == sdptransform::write(sdpObject));
+	}
+}
+
+// Hidden benchmark, run it with: test_mediasoupclient "[benchmark]"
+TEST_CASE("RemoteSdp writer benchmark", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	static const size_t MediaSections{ 500u };
+	static const size_t Iterations{ 100u };
+
+	auto transportRemoteParameters = generateTransportRemoteParameters();
+	auto consumerParameters        = generateConsumerRemoteParameters("video/VP8");
+
+	TestRemoteSdp remoteSdp(
+	  transportRemoteParameters["iceParameters"],
+	  transportRemoteParameters["iceCandidates"],
+	  transportRemoteParameters["dtlsParameters"],
+	  nullptr);
+
+	for (size_t i{ 0u }; i < MediaSections; ++i)
+	{
+		remoteSdp.Receive(
+		  std::to_string(i),
+		  "video",
+		  consumerParameters["rtpParameters"],
+		  consumerParameters["rtpParameters"]["rtcp"]["cname"],
+		  consumerParameters["id"]);
+	}
+
+	(void)remoteSdp.GetSdp();
+
+	std::chrono::duration<double, std::milli> incremental{ 0 };
+	std::chrono::duration<double, std::milli> full{ 0 };
+
+	for (size_t i{ 0u }; i < Iterations; ++i)
+	{
+		// A renegotiation changes a single m-section.
+		remoteSdp.CloseMediaSection(std::to_string(i + 1));
+
+		auto start = Clock::now();
+
+		(void)remoteSdp.GetSdp();
+
+		incremental += Clock::now() - start;
+
+		auto sdpObject = remoteSdp.GetSdpObject();
+
+		start = Clock::now();
+
+		(void)sdptransform::write(sdpObject);
+
+		full += Clock::now() - start;
+	}
+
+	std::cout << MediaSections << " m-sections, per SDP [ms]: RemoteSdp::GetSdp():"
+	          << incremental.count() / Iterations << " sdptransform::write():" << full.count() / Iterations
+	          << std::endl;
+}
+
+TEST_CASE("CompactRemoteSdp", "[CompactRemoteSdp]")
+{
+	auto transportRemoteParameters = generateTransportRemoteParameters();
+	auto consumerRemoteParameters  = generateConsumerRemoteParameters("audio/opus");
+	auto iceParameters             = transportRemoteParameters["iceParameters"];
+
+	mediasoupclient::Sdp::RemoteSdp remoteSdp(
+	  iceParameters,
+	  transportRemoteParameters["iceCandidates"],
+	  transportRemoteParameters["dtlsParameters"],
+	  nullptr);
+
+	remoteSdp.Receive("0", "audio", consumerRemoteParameters["rtpParameters"], "stream-id", "track-id");
+	remoteSdp.SetCompact();
+	remoteSdp.Receive("1", "audio", consumerRemoteParameters["rtpParameters"], "stream-id", "track-id");
+
+	SECTION("ICE parameters are given at session level")
+	{
+		auto sdpObject = sdptransform::parse(remoteSdp.GetSdp());
+
+		REQUIRE(sdpObject["iceUfrag"] == iceParameters["usernameFragment"]);
+		REQUIRE(sdpObject["icePwd"] == iceParameters["password"]);
+		REQUIRE(sdpObject["iceOptions"] == "renomination");
+
+		for (const auto& mediaObject : sdpObject["media"])
+		{
+			REQUIRE(mediaObject.find("iceUfrag") == mediaObject.end());
+			REQUIRE(mediaObject.find("icePwd") == mediaObject.end());
+			REQUIRE(mediaObject.find("iceOptions") == mediaObject.end());
+		}
+	}
+
+	SECTION("ICE candidates are given just in the first media section")
+	{
+		auto sdpObject = sdptransform::parse(remoteSdp.GetSdp());
+
+		REQUIRE(sdpObject["media"][0]["candidates"].size() == transportRemoteParameters["iceCandidates"].size());
+		REQUIRE(sdpObject["media"][0]["endOfCandidates"] == "end-of-candidates");
+		REQUIRE(sdpObject["media"][1].find("candidates") == sdpObject["media"][1].end());
+		REQUIRE(sdpObject["media"][1].find("endOfCandidates") == sdpObject["media"][1].end());
+	}
+
+	SECTION("UpdateIceParameters() updates the session level ICE parameters")
+	{
+		iceParameters["usernameFragment"] = "newufrag";
+		iceParameters["password"]         = "newpwd";
+
+		remoteSdp.UpdateIceParameters(iceParameters);
+
+		auto sdpObject = sdptransform::parse(remoteSdp.GetSdp());
+
+		REQUIRE(sdpObject["iceUfrag"] == "newufrag");
+		REQUIRE(sdpObject["icePwd"] == "newpwd");
+		REQUIRE(sdpObject["media"][1].find("iceUfrag") == sdpObject["media"][1].end());
+	}
+}
+
+// Hidden benchmark, run it with: test_mediasoupclient "[benchmark]"
+TEST_CASE("CompactRemoteSdp benchmark", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	static const size_t MediaSections{ 300u };
+	static const size_t Iterations{ 20u };
+
+	auto transportRemoteParameters = generateTransportRemoteParameters();
+	auto consumerParameters        = generateConsumerRemoteParameters("audio/opus");
+
+	for (auto compact : { false, true })
+	{
+		mediasoupclient::Sdp::RemoteSdp remoteSdp(
+		  transportRemoteParameters["iceParameters"],
+		  transportRemoteParameters["iceCandidates"],
+		  transportRemoteParameters["dtlsParameters"],
+		  nullptr);
+
+		if (compact)
+			remoteSdp.SetCompact();
+
+		for (size_t i{ 0u }; i < MediaSections; ++i)
+		{
+			remoteSdp.Receive(
+			  std::to_string(i),
+			  "audio",
+			  consumerParameters["rtpParameters"],
+			  consumerParameters["rtpParameters"]["rtcp"]["cname"],
+			  consumerParameters["id"]);
+		}
+
+		std::string sdp;
+		std::chrono::duration<double, std::milli> write{ 0 };
+		std::chrono::duration<double, std::milli> parse{ 0 };
+
+		for (size_t i{ 0u }; i < Iterations; ++i)
+		{
+			// An ICE restart changes the ICE parameters of every m-section.
+			auto iceParameters                = transportRemoteParameters["iceParameters"];
+			iceParameters["usernameFragment"] = "ufrag" + std::to_string(i);
+
+			remoteSdp.UpdateIceParameters(iceParameters);
+
+			auto start = Clock::now();
+
+			sdp = remoteSdp.GetSdp();
+
+			write += Clock::now() - start;
+
+			start = Clock::now();
+
+			(void)sdptransform::parse(sdp);
+
+			parse += Clock::now() - start;
+		}
+
+		std::cout << MediaSections << " m-sections, " << (compact ? "compact" : "regular")
+		          << " SDP: " << sdp.size() << " bytes, per SDP [ms]: GetSdp():" << write.count() / Iterations
+		          << " sdptransform::parse():" << parse.count() / Iterations << std::endl;
+	}
+}
+
+// Approximate heap and inline memory used by a json value.
+static size_t getJsonMemory(const nlohmann::json& value)
+{
+	size_t size{ sizeof(nlohmann::json) };
+
+	if (value.is_string())
+	{
+		size += value.get_ref<const std::string&>().capacity();
+	}
+	else if (value.is_array())
+	{
+		for (const auto& item : value)
+		{
+			size += getJsonMemory(item);
+		}
+	}
+	else if (value.is_object())
+	{
+		for (const auto& item : value.items())
+		{
+			size += item.key().capacity() + getJsonMemory(item.value());
+		}
+	}
+
+	return size;
+}
+
+// Hidden benchmark, run it with: test_mediasoupclient "[benchmark]"
+TEST_CASE("RemoteSdp memory benchmark", "[.][benchmark]")
+{
+	static const size_t MediaSections{ 300u };
+
+	auto transportRemoteParameters = generateTransportRemoteParameters();
+	auto consumerParameters        = generateConsumerRemoteParameters("video/VP8");
+
+	TestRemoteSdp remoteSdp(
+	  transportRemoteParameters["iceParameters"],
+	  transportRemoteParameters["iceCandidates"],
+	  transportRemoteParameters["dtlsParameters"],
+	  nullptr);
+
+	for (size_t i{ 0u }; i < MediaSections; ++i)
+	{
+		remoteSdp.Receive(
+		  std::to_string(i),
+		  "video",
+		  consumerParameters["rtpParameters"],
+		  consumerParameters["rtpParameters"]["rtcp"]["cname"],
+		  consumerParameters["id"]);
+	}
+
+	auto sdp          = remoteSdp.GetSdp();
+	auto mediaObjects = remoteSdp.GetSdpObject()["media"];
+
+	std::cout << MediaSections << " m-sections, per m-section [bytes]: json:"
+	          << getJsonMemory(mediaObjects) / MediaSections << " SDP text:" << sdp.size() / MediaSections
+	          << std::endl;
+}
@@ -0,0 +1,148 @@
+#include "FakePeerConnection.hpp"
+#include "Handler.hpp"
+#include "MediaSoupClientErrors.hpp"
+#include "MediaStreamTrackFactory.hpp"
+#include "TransportPool.hpp"
+#include "fakeParameters.hpp"
+#include <catch.hpp>
+#include <memory>
+
+class FakeTransportPoolHandlerListener : public mediasoupclient::Handler::PrivateListener
+{
+public:
+	void OnConnect(json& /*transportLocalParameters*/) override{};
+
+	void OnConnectionStateChange(
+	  webrtc::PeerConnectionInterface::IceConnectionState /*connectionState*/) override{};
+};
+
+TEST_CASE("TransportPool", "[TransportPool]")
+{
+	static const json TransportRemoteParameters = generateTransportRemoteParameters();
+	static const json RtpParametersByKind       = generateRtpParametersByKind();
+
+	static FakeTransportPoolHandlerListener handlerListener;
+	static mediasoupclient::PeerConnection::Options peerConnectionOptions;
+	static std::unique_ptr<mediasoupclient::TransportPool> transportPool;
+
+	SECTION("TransportPool with size 0 throws")
+	{
+		REQUIRE_THROWS_AS(
+		  mediasoupclient::TransportPool(&peerConnectionOptions, 0u), MediaSoupClientTypeError);
+	}
+
+	SECTION("transportPool.Fill() creates the PeerConnections")
+	{
+		transportPool.reset(new mediasoupclient::TransportPool(&peerConnectionOptions, 2u));
+
+		REQUIRE(transportPool->GetAvailable() == 0u);
+		REQUIRE_NOTHROW(transportPool->Fill());
+		REQUIRE(transportPool->GetAvailable() == 2u);
+	}
+
+	SECTION("SendHandler takes a PeerConnection from the pool")
+	{
+		peerConnectionOptions.transportPool = transportPool.get();
+
+		mediasoupclient::SendHandler sendHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions,
+		  RtpParametersByKind,
+		  RtpParametersByKind);
+
+		REQUIRE(transportPool->GetAvailable() == 1u);
+
+		auto track = createAudioTrack("test-track-id");
+
+		REQUIRE_NOTHROW(sendHandler.Send(track, nullptr, nullptr, nullptr));
+
+		sendHandler.Close();
+	}
+
+	SECTION("SendHandler creates a PeerConnection if the pool is empty")
+	{
+		mediasoupclient::SendHandler sendHandler1(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions,
+		  RtpParametersByKind,
+		  RtpParametersByKind);
+
+		REQUIRE(transportPool->GetAvailable() == 0u);
+
+		REQUIRE_NOTHROW(mediasoupclient::SendHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &peerConnectionOptions,
+		  RtpParametersByKind,
+		  RtpParametersByKind));
+
+		sendHandler1.Close();
+	}
+
+	SECTION("a pooled PeerConnection gets the configuration of the transport")
+	{
+		FakePeerConnection::Backend backend;
+		mediasoupclient::PeerConnection::Options poolOptions;
+
+		poolOptions.backend = &backend;
+
+		mediasoupclient::TransportPool pool(&poolOptions, 1u);
+
+		pool.Fill();
+
+		auto* pooledPc = backend.lastPeerConnection;
+
+		REQUIRE(pooledPc->GetConfiguration().servers.empty());
+
+		webrtc::PeerConnectionInterface::IceServer iceServer;
+
+		iceServer.uri = "turn:turn.example.com:3478";
+
+		mediasoupclient::PeerConnection::Options transportOptions;
+
+		transportOptions.backend       = &backend;
+		transportOptions.transportPool = &pool;
+		transportOptions.config.servers.push_back(iceServer);
+
+		mediasoupclient::SendHandler sendHandler(
+		  &handlerListener,
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"],
+		  &transportOptions,
+		  RtpParametersByKind,
+		  RtpParametersByKind);
+
+		REQUIRE(pool.GetAvailable() == 0u);
+		REQUIRE(backend.lastPeerConnection == pooledPc);
+
+		auto config = pooledPc->GetConfiguration();
+
+		REQUIRE(config.servers.size() == 1);
+		REQUIRE(config.servers[0].uri == "turn:turn.example.com:3478");
+		REQUIRE(config.ice_candidate_pool_size == 1);
+
+		sendHandler.Close();
+	}
+
+	SECTION("transportPool.Close() succeeds")
+	{
+		REQUIRE_NOTHROW(transportPool->Close());
+		REQUIRE(transportPool->IsClosed());
+		REQUIRE_THROWS_AS(transportPool->Fill(), MediaSoupClientInvalidStateError);
+
+		peerConnectionOptions.transportPool = nullptr;
+	}
+}
@@ -4,6 +4,7 @@
 #include "fakeParameters.hpp"
 #include "mediasoupclient.hpp"
 #include <catch.hpp>
+#include <chrono>
 #include <vector>
 
 TEST_CASE("mediasoupclient", "[mediasoupclient]")
@@ -617,6 +618,8 @@ TEST_CASE("mediasoupclient", "[mediasoupclient]")
 		auto iceParameters = TransportRemoteParameters["iceParameters"];
 
 		REQUIRE_NOTHROW(sendTransport->RestartIce(iceParameters));
+		// Not connected again yet.
+		REQUIRE(sendTransport->GetIceRestartLatency().count() == 0);
 	}
 
 	SECTION("sendTransport.UpdateIceServers() succeeds")
@@ -685,6 +688,516 @@ TEST_CASE("mediasoupclient", "[mediasoupclient]")
 			MediaSoupClientError);
 	}
 
+	SECTION("producer.SetRtpEncodingParameters() succeeds")
+	{
+		/* clang-format off */
+		json encodings =
+		{
+			{
+				{ "rid",        "r2"   },
+				{ "maxBitrate", 500000 }
+			}
+		};
+		/* clang-format on */
+
+		REQUIRE_NOTHROW(videoProducer->SetRtpEncodingParameters(encodings));
+	}
+
+	SECTION("producer.SetRtpEncodingParameters() with a non array throws")
+	{
+		REQUIRE_THROWS_AS(
+			videoProducer->SetRtpEncodingParameters(json::object()),
+			MediaSoupClientError);
+	}
+
+	SECTION("AdaptiveLayerController with a null SendTransport throws")
+	{
+		REQUIRE_THROWS_AS(mediasoupclient::AdaptiveLayerController(nullptr), MediaSoupClientTypeError);
+	}
+
+	SECTION("adaptiveLayerController.Tick() succeeds")
+	{
+		mediasoupclient::AdaptiveLayerController controller(sendTransport.get());
+
+		REQUIRE_NOTHROW(controller.Tick());
+		REQUIRE_NOTHROW(controller.Tick());
+	}
+
+	SECTION("adaptiveLayerController.Inspect() drops a layer on overuse and raises it on underuse")
+	{
+		mediasoupclient::AdaptiveLayerController::Options options;
+
+		options.overuseCount  = 2u;
+		options.underuseCount = 3u;
+
+		mediasoupclient::AdaptiveLayerController controller(sendTransport.get(), nullptr, options);
+
+		auto now = std::chrono::steady_clock::now();
+		uint64_t bytesSent{ 0u };
+		double totalEncodeTime{ 0 };
+
+		// Inspects canned stats of one second with the given encode usage.
+		auto inspect = [&](double encodeUsage) {
+			now += std::chrono::seconds(1);
+			bytesSent += 100000u;
+			totalEncodeTime += encodeUsage;
+
+			/* clang-format off */
+			json stats =
+			{
+				{
+					{ "type",            "outbound-rtp"  },
+					{ "rid",             "r0"            },
+					{ "bytesSent",       bytesSent       },
+					{ "totalEncodeTime", totalEncodeTime }
+				}
+			};
+			/* clang-format on */
+
+			controller.Inspect(videoProducer.get(), stats, now);
+		};
+
+		videoProducer->SetMaxSpatialLayer(3);
+
+		// First sample.
+		inspect(0.5);
+
+		// A single overused inspection is not enough.
+		inspect(0.95);
+		REQUIRE(videoProducer->GetMaxSpatialLayer() == 3);
+
+		inspect(0.95);
+		REQUIRE(videoProducer->GetMaxSpatialLayer() == 2);
+
+		// Samples again after changing the layer, then neither overused nor
+		// underused resets the counters.
+		inspect(0.1);
+		inspect(0.1);
+		inspect(0.6);
+		inspect(0.1);
+		inspect(0.1);
+		REQUIRE(videoProducer->GetMaxSpatialLayer() == 2);
+
+		inspect(0.1);
+		REQUIRE(videoProducer->GetMaxSpatialLayer() == 3);
+
+		// Never above the number of layers.
+		for (auto i = 0; i < 5; ++i)
+		{
+			inspect(0.1);
+		}
+
+		REQUIRE(videoProducer->GetMaxSpatialLayer() == 3);
+	}
+
+	SECTION("adaptiveLayerController.Inspect() does not raise above the app max spatial layer")
+	{
+		mediasoupclient::AdaptiveLayerController::Options options;
+
+		options.overuseCount  = 1u;
+		options.underuseCount = 1u;
+
+		mediasoupclient::AdaptiveLayerController controller(sendTransport.get(), nullptr, options);
+
+		auto now = std::chrono::steady_clock::now();
+		uint64_t bytesSent{ 0u };
+		double totalEncodeTime{ 0 };
+
+		auto inspect = [&](double encodeUsage) {
+			now += std::chrono::seconds(1);
+			bytesSent += 100000u;
+			totalEncodeTime += encodeUsage;
+
+			/* clang-format off */
+			json stats =
+			{
+				{
+					{ "type",            "outbound-rtp"  },
+					{ "rid",             "r0"            },
+					{ "bytesSent",       bytesSent       },
+					{ "totalEncodeTime", totalEncodeTime }
+				}
+			};
+			/* clang-format on */
+
+			controller.Inspect(videoProducer.get(), stats, now);
+		};
+
+		videoProducer->SetMaxSpatialLayer(2);
+
+		inspect(0.5);
+		inspect(0.95);
+		REQUIRE(videoProducer->GetMaxSpatialLayer() == 1);
+
+		for (auto i = 0; i < 5; ++i)
+		{
+			inspect(0.1);
+		}
+
+		REQUIRE(videoProducer->GetMaxSpatialLayer() == 2);
+	}
+
+	SECTION("BandwidthMonitor with a null SendTransport throws")
+	{
+		REQUIRE_THROWS_AS(mediasoupclient::BandwidthMonitor(nullptr), MediaSoupClientTypeError);
+	}
+
+	SECTION("bandwidthMonitor.Tick() succeeds")
+	{
+		FakeBandwidthMonitorListener listener;
+		mediasoupclient::BandwidthMonitor monitor(sendTransport.get(), &listener);
+
+		REQUIRE_NOTHROW(monitor.Tick());
+		REQUIRE(listener.onBandwidthEstimationTimesCalled == 1);
+	}
+
+	SECTION("bandwidthMonitor.Inspect() takes the bitrate of the selected candidate-pair")
+	{
+		FakeBandwidthMonitorListener listener;
+		mediasoupclient::BandwidthMonitor monitor(sendTransport.get(), &listener);
+
+		// The first pair is still nominated after an ICE restart.
+		/* clang-format off */
+		json stats =
+		{
+			{
+				{ "type",                     "candidate-pair" },
+				{ "id",                       "CP01"           },
+				{ "nominated",                true             },
+				{ "availableOutgoingBitrate", 3000000          }
+			},
+			{
+				{ "type",                    "transport" },
+				{ "selectedCandidatePairId", "CP02"      }
+			},
+			{
+				{ "type",                     "candidate-pair" },
+				{ "id",                       "CP02"           },
+				{ "nominated",                true             },
+				{ "availableOutgoingBitrate", 1000000          }
+			},
+			{
+				{ "type",                     "candidate-pair" },
+				{ "id",                       "CP03"           },
+				{ "nominated",                true             },
+				{ "availableOutgoingBitrate", 2000000          }
+			}
+		};
+		/* clang-format on */
+
+		monitor.Inspect(stats);
+
+		REQUIRE(monitor.GetEstimation().availableOutgoingBitrate == 1000000u);
+		REQUIRE(listener.onBandwidthEstimationTimesCalled == 1);
+	}
+
+	SECTION("bandwidthMonitor.Inspect() computes the pacer queue delay from the deltas")
+	{
+		mediasoupclient::BandwidthMonitor monitor(sendTransport.get());
+
+		// Inspects canned stats of a single outbound RTP stream.
+		auto inspect = [&monitor](double totalPacketSendDelay, uint64_t packetsSent) {
+			/* clang-format off */
+			json stats =
+			{
+				{
+					{ "type",                 "outbound-rtp"       },
+					{ "id",                   "OT01V1"             },
+					{ "totalPacketSendDelay", totalPacketSendDelay },
+					{ "packetsSent",          packetsSent          }
+				}
+			};
+			/* clang-format on */
+
+			monitor.Inspect(stats);
+
+			return monitor.GetEstimation().pacerQueueDelay;
+		};
+
+		// First sample.
+		REQUIRE(inspect(10.0, 1000u) == std::chrono::milliseconds(0));
+
+		// 100 packets held 2 seconds in total.
+		REQUIRE(inspect(12.0, 1100u) == std::chrono::milliseconds(20));
+
+		// Nothing sent meanwhile.
+		REQUIRE(inspect(12.0, 1100u) == std::chrono::milliseconds(0));
+
+		// The stream restarted, so packetsSent decreased.
+		REQUIRE(inspect(1.0, 100u) == std::chrono::milliseconds(0));
+
+		// Deltas from the restarted counters.
+		REQUIRE(inspect(1.5, 200u) == std::chrono::milliseconds(5));
+	}
+
+	SECTION("bandwidthMonitor.Inspect() notifies congestion once the bitrate drops by the ratio")
+	{
+		FakeBandwidthMonitorListener listener;
+		mediasoupclient::BandwidthMonitor::Options options;
+
+		options.congestionDropRatio = 0.25;
+
+		mediasoupclient::BandwidthMonitor monitor(sendTransport.get(), &listener, options);
+
+		// Inspects canned stats with the given available outgoing bitrate.
+		auto inspect = [&monitor](uint64_t availableOutgoingBitrate) {
+			/* clang-format off */
+			json stats =
+			{
+				{
+					{ "type",                    "transport" },
+					{ "selectedCandidatePairId", "CP01"      }
+				},
+				{
+					{ "type",                     "candidate-pair"         },
+					{ "id",                       "CP01"                   },
+					{ "nominated",                true                     },
+					{ "availableOutgoingBitrate", availableOutgoingBitrate }
+				}
+			};
+			/* clang-format on */
+
+			monitor.Inspect(stats);
+		};
+
+		inspect(1000000u);
+
+		// Below the drop ratio.
+		inspect(800000u);
+		REQUIRE(listener.onCongestionTimesCalled == 0);
+
+		// Exactly the drop ratio.
+		inspect(600000u);
+		REQUIRE(listener.onCongestionTimesCalled == 1);
+		REQUIRE(listener.previousBitrate == 800000u);
+
+		// Just below the drop ratio.
+		inspect(450001u);
+		REQUIRE(listener.onCongestionTimesCalled == 1);
+
+		// A rise is not congestion.
+		inspect(900000u);
+		REQUIRE(listener.onCongestionTimesCalled == 1);
+		REQUIRE(listener.onBandwidthEstimationTimesCalled == 5);
+	}
+
+	SECTION("ConnectionQualityMonitor with a null Transport throws")
+	{
+		REQUIRE_THROWS_AS(mediasoupclient::ConnectionQualityMonitor(nullptr), MediaSoupClientTypeError);
+	}
+
+	SECTION("connectionQualityMonitor.Tick() succeeds")
+	{
+		mediasoupclient::ConnectionQualityMonitor monitor(recvTransport.get());
+
+		REQUIRE_NOTHROW(monitor.Tick());
+		REQUIRE_NOTHROW(monitor.Tick());
+	}
+
+	SECTION("connectionQualityMonitor.Inspect() notifies only when the quality bucket changes")
+	{
+		using Quality = mediasoupclient::ConnectionQualityMonitor::Quality;
+
+		FakeConnectionQualityMonitorListener listener;
+		mediasoupclient::ConnectionQualityMonitor::Options options;
+
+		// No smoothing.
+		options.smoothingFactor = 1;
+
+		mediasoupclient::ConnectionQualityMonitor monitor(recvTransport.get(), &listener, options);
+
+		// Inspects canned stats with the given ICE RTT.
+		auto inspect = [&monitor](double roundTripTime) {
+			/* clang-format off */
+			json stats =
+			{
+				{
+					{ "type",                    "transport" },
+					{ "selectedCandidatePairId", "CP01"      }
+				},
+				{
+					{ "type",                 "candidate-pair" },
+					{ "id",                   "CP01"           },
+					{ "nominated",            true             },
+					{ "currentRoundTripTime", roundTripTime    }
+				}
+			};
+			/* clang-format on */
+
+			monitor.Inspect(stats);
+		};
+
+		inspect(0.05);
+		REQUIRE(listener.onQualityChangeTimesCalled == 1);
+		REQUIRE(listener.quality == Quality::GOOD);
+
+		// Same bucket.
+		inspect(0.1);
+		REQUIRE(listener.onQualityChangeTimesCalled == 1);
+
+		inspect(0.2);
+		REQUIRE(listener.onQualityChangeTimesCalled == 2);
+		REQUIRE(listener.quality == Quality::FAIR);
+
+		inspect(0.5);
+		REQUIRE(listener.onQualityChangeTimesCalled == 3);
+		REQUIRE(listener.quality == Quality::POOR);
+
+		// Same bucket.
+		inspect(0.6);
+		REQUIRE(listener.onQualityChangeTimesCalled == 3);
+		REQUIRE(monitor.GetQuality() == Quality::POOR);
+	}
+
+	SECTION("connectionQualityMonitor.Inspect() prefers the candidate-pair RTT over the RTCP one")
+	{
+		mediasoupclient::ConnectionQualityMonitor monitor(recvTransport.get());
+
+		/* clang-format off */
+		json stats =
+		{
+			{
+				{ "type",          "remote-inbound-rtp" },
+				{ "roundTripTime", 0.5                  }
+			},
+			{
+				{ "type",                    "transport" },
+				{ "selectedCandidatePairId", "CP01"      }
+			},
+			{
+				{ "type",                 "candidate-pair" },
+				{ "id",                   "CP01"           },
+				{ "nominated",            true             },
+				{ "currentRoundTripTime", 0.05             }
+			}
+		};
+		/* clang-format on */
+
+		monitor.Inspect(stats);
+
+		REQUIRE(monitor.GetMetrics().roundTripTime == std::chrono::milliseconds(50));
+		REQUIRE(monitor.GetQuality() == mediasoupclient::ConnectionQualityMonitor::Quality::GOOD);
+	}
+
+	SECTION("connectionQualityMonitor.Inspect() takes the RTT of the selected candidate-pair")
+	{
+		mediasoupclient::ConnectionQualityMonitor monitor(recvTransport.get());
+
+		// The first pair is dead but still nominated after an ICE restart.
+		/* clang-format off */
+		json stats =
+		{
+			{
+				{ "type",                 "candidate-pair" },
+				{ "id",                   "CP01"           },
+				{ "nominated",            true             },
+				{ "currentRoundTripTime", 2.0              }
+			},
+			{
+				{ "type",                    "transport" },
+				{ "selectedCandidatePairId", "CP02"      }
+			},
+			{
+				{ "type",                 "candidate-pair" },
+				{ "id",                   "CP02"           },
+				{ "nominated",            true             },
+				{ "currentRoundTripTime", 0.05             }
+			},
+			{
+				{ "type",                 "candidate-pair" },
+				{ "id",                   "CP03"           },
+				{ "nominated",            true             },
+				{ "currentRoundTripTime", 1.0              }
+			}
+		};
+		/* clang-format on */
+
+		monitor.Inspect(stats);
+
+		REQUIRE(monitor.GetMetrics().roundTripTime == std::chrono::milliseconds(50));
+	}
+
+	SECTION("connectionQualityMonitor.Inspect() does not take packetsLost going back as loss")
+	{
+		mediasoupclient::ConnectionQualityMonitor::Options options;
+
+		// No smoothing.
+		options.smoothingFactor = 1;
+
+		mediasoupclient::ConnectionQualityMonitor monitor(recvTransport.get(), nullptr, options);
+
+		// Inspects canned stats of a single inbound RTP stream.
+		auto inspect = [&monitor](uint64_t packetsReceived, int64_t packetsLost) {
+			/* clang-format off */
+			json stats =
+			{
+				{
+					{ "type",            "inbound-rtp"   },
+					{ "id",              "IT01A1"        },
+					{ "packetsReceived", packetsReceived },
+					{ "packetsLost",     packetsLost     }
+				}
+			};
+			/* clang-format on */
+
+			monitor.Inspect(stats);
+
+			return monitor.GetMetrics().packetLoss;
+		};
+
+		// First sample.
+		inspect(1000u, 10);
+
+		// Duplicated packets made packetsLost decrease.
+		REQUIRE(inspect(1100u, 5) == 0);
+
+		// 10 packets lost out of 100.
+		REQUIRE(inspect(1190u, 15) == Approx(0.1));
+	}
+
+	SECTION("connectionQualityMonitor.Inspect() takes the first sample of every metric as is")
+	{
+		mediasoupclient::ConnectionQualityMonitor::Options options;
+
+		options.smoothingFactor = 0.5;
+
+		mediasoupclient::ConnectionQualityMonitor monitor(recvTransport.get(), nullptr, options);
+
+		/* clang-format off */
+		json stats =
+		{
+			{
+				{ "type",                    "transport" },
+				{ "selectedCandidatePairId", "CP01"      }
+			},
+			{
+				{ "type",                 "candidate-pair" },
+				{ "id",                   "CP01"           },
+				{ "nominated",            true             },
+				{ "currentRoundTripTime", 0.1              }
+			}
+		};
+		/* clang-format on */
+
+		monitor.Inspect(stats);
+
+		/* clang-format off */
+		stats =
+		{
+			{
+				{ "type",         "remote-inbound-rtp" },
+				{ "fractionLost", 0.2                  }
+			}
+		};
+		/* clang-format on */
+
+		monitor.Inspect(stats);
+
+		// Not smoothed with the initial 0.
+		REQUIRE(monitor.GetMetrics().packetLoss == Approx(0.2));
+		REQUIRE(monitor.GetMetrics().roundTripTime == std::chrono::milliseconds(100));
+	}
+
 	SECTION("producer.GetStats() succeeds")
 	{
 		REQUIRE_NOTHROW(videoProducer->GetStats());
@@ -737,6 +1250,164 @@ TEST_CASE("mediasoupclient", "[mediasoupclient]")
 			MediaSoupClientError);
 	}
 
+	SECTION("sendTransport.CloseProducers() closes several Producers at once")
+	{
+		std::unique_ptr<mediasoupclient::Producer> producer1(sendTransport->Produce(
+		  &producerListener, createAudioTrack("audio-track-id-3"), nullptr, nullptr, nullptr));
+		std::unique_ptr<mediasoupclient::Producer> producer2(sendTransport->Produce(
+		  &producerListener, createAudioTrack("audio-track-id-4"), nullptr, nullptr, nullptr));
+
+		// Already closed Producers are ignored.
+		REQUIRE_NOTHROW(
+		  sendTransport->CloseProducers({ producer1.get(), producer2.get(), audioProducer.get() }));
+
+		REQUIRE(producer1->IsClosed());
+		REQUIRE(producer2->IsClosed());
+		REQUIRE(!videoProducer->IsClosed());
+	}
+
+	SECTION("recvTransport.CloseConsumers() closes several Consumers at once")
+	{
+		auto consumer1RemoteParameters = generateConsumerRemoteParameters("audio/opus");
+		auto consumer2RemoteParameters = generateConsumerRemoteParameters("video/VP8");
+
+		std::unique_ptr<mediasoupclient::Consumer> consumer1(recvTransport->Consume(
+		  &consumerListener,
+		  consumer1RemoteParameters["id"].get<std::string>(),
+		  consumer1RemoteParameters["producerId"].get<std::string>(),
+		  consumer1RemoteParameters["kind"].get<std::string>(),
+		  &consumer1RemoteParameters["rtpParameters"]));
+		std::unique_ptr<mediasoupclient::Consumer> consumer2(recvTransport->Consume(
+		  &consumerListener,
+		  consumer2RemoteParameters["id"].get<std::string>(),
+		  consumer2RemoteParameters["producerId"].get<std::string>(),
+		  consumer2RemoteParameters["kind"].get<std::string>(),
+		  &consumer2RemoteParameters["rtpParameters"]));
+
+		REQUIRE_NOTHROW(recvTransport->CloseConsumers({ consumer1.get(), consumer2.get() }));
+
+		REQUIRE(consumer1->IsClosed());
+		REQUIRE(consumer2->IsClosed());
+		REQUIRE(!videoConsumer->IsClosed());
+	}
+
+	SECTION("recvTransport.Consume() creates several Consumers at once")
+	{
+		std::vector<mediasoupclient::RecvTransport::ConsumeOptions> optionsList;
+
+		for (const auto* mimeType : { "audio/opus", "video/VP8", "video/VP8" })
+		{
+			auto consumerRemoteParameters = generateConsumerRemoteParameters(mimeType);
+			mediasoupclient::RecvTransport::ConsumeOptions options;
+
+			options.id            = consumerRemoteParameters["id"].get<std::string>();
+			options.producerId    = consumerRemoteParameters["producerId"].get<std::string>();
+			options.kind          = consumerRemoteParameters["kind"].get<std::string>();
+			options.rtpParameters = consumerRemoteParameters["rtpParameters"];
+
+			optionsList.push_back(options);
+		}
+
+		std::vector<mediasoupclient::Consumer*> consumers;
+
+		REQUIRE_NOTHROW(consumers = recvTransport->Consume(&consumerListener, optionsList));
+		REQUIRE(consumers.size() == 3);
+
+		for (size_t idx{ 0u }; idx < consumers.size(); ++idx)
+		{
+			REQUIRE(consumers[idx]->GetId() == optionsList[idx].id);
+			REQUIRE(consumers[idx]->GetKind() == optionsList[idx].kind);
+		}
+
+		REQUIRE_NOTHROW(recvTransport->CloseConsumers(consumers));
+
+		for (auto* consumer : consumers)
+		{
+			delete consumer;
+		}
+	}
+
+	SECTION("recvTransport.Consume() with an invalid Consumer creates none")
+	{
+		std::vector<mediasoupclient::RecvTransport::ConsumeOptions> optionsList(2);
+
+		auto consumerRemoteParameters = generateConsumerRemoteParameters("audio/opus");
+
+		optionsList[0].id            = consumerRemoteParameters["id"].get<std::string>();
+		optionsList[0].producerId    = consumerRemoteParameters["producerId"].get<std::string>();
+		optionsList[0].kind          = "audio";
+		optionsList[0].rtpParameters = consumerRemoteParameters["rtpParameters"];
+		optionsList[1]               = optionsList[0];
+		optionsList[1].kind          = "chicken";
+
+		REQUIRE_THROWS_AS(
+		  recvTransport->Consume(&consumerListener, optionsList), MediaSoupClientTypeError);
+	}
+
+	SECTION("sendTransport.Connect() connects before producing")
+	{
+		FakeSendTransportListener listener;
+		std::unique_ptr<mediasoupclient::SendTransport> transport(device->CreateSendTransport(
+		  &listener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  TransportRemoteParameters["sctpParameters"]));
+
+		REQUIRE_NOTHROW(transport->Connect());
+		REQUIRE(listener.onConnectTimesCalled == 1);
+
+		// Already connected.
+		REQUIRE_NOTHROW(transport->Connect());
+		REQUIRE(listener.onConnectTimesCalled == 1);
+
+		// Connecting does not take a SCTP stream id.
+		std::unique_ptr<mediasoupclient::DataProducer> producer(
+		  transport->ProduceData(&producerListener));
+
+		REQUIRE(producer->GetSctpStreamParameters()["streamId"] == 0);
+
+		producer->Close();
+		transport->Close();
+	}
+
+	SECTION("sendTransport.Connect() without SctpParameters throws")
+	{
+		FakeSendTransportListener listener;
+		std::unique_ptr<mediasoupclient::SendTransport> transport(device->CreateSendTransport(
+		  &listener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"]));
+
+		REQUIRE_THROWS_AS(transport->Connect(), MediaSoupClientUnsupportedError);
+
+		transport->Close();
+	}
+
+	SECTION("recvTransport.Connect() connects before consuming")
+	{
+		FakeRecvTransportListener listener;
+		std::unique_ptr<mediasoupclient::RecvTransport> transport(device->CreateRecvTransport(
+		  &listener,
+		  TransportRemoteParameters["id"],
+		  TransportRemoteParameters["iceParameters"],
+		  TransportRemoteParameters["iceCandidates"],
+		  TransportRemoteParameters["dtlsParameters"],
+		  nullptr));
+
+		REQUIRE_NOTHROW(transport->Connect());
+		REQUIRE(listener.onConnectTimesCalled == 1);
+
+		// Already connected.
+		REQUIRE_NOTHROW(transport->Connect());
+		REQUIRE(listener.onConnectTimesCalled == 1);
+
+		transport->Close();
+	}
+
 	SECTION("transport.Close() fires 'OnTransportClose' in live Producers/Consumers")
 	{
 		// Audio Producer was already closed.
@@ -786,6 +1457,13 @@ TEST_CASE("mediasoupclient", "[mediasoupclient]")
 			MediaSoupClientError);
 	}
 
+	SECTION("transport.Connect() throws if closed")
+	{
+		REQUIRE_THROWS_AS(
+			sendTransport->Connect(),
+			MediaSoupClientInvalidStateError);
+	}
+
 	SECTION("transport.getStats() throws if closed")
 	{
 		REQUIRE_THROWS_AS(
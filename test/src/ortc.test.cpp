@@ -1,6 +1,11 @@
 #include "fakeParameters.hpp"
+#include "MediaSoupClientErrors.hpp"
 #include "ortc.hpp"
+#include "sdptransform.hpp"
+#include "sdp/RemoteSdp.hpp"
 #include <catch.hpp>
+#include <chrono>
+#include <iostream>
 
 using namespace mediasoupclient;
 
@@ -58,6 +63,129 @@ TEST_CASE("getExtendedCapabilities", "[ortc][getExtendedCapabilities]")
 	}
 }
 
+TEST_CASE("applyRtpCapabilitiesProfile", "[ortc][applyRtpCapabilitiesProfile]")
+{
+	json remoteCaps = generateRouterRtpCapabilities();
+	json localCaps  = generateRouterRtpCapabilities();
+
+	auto extendedRtpCapabilities = ortc::getExtendedRtpCapabilities(localCaps, remoteCaps);
+
+	SECTION("keeps the allowed codecs in the given order")
+	{
+		json profile = { { "codecs", { "video/vp8", "audio/opus" } } };
+
+		ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, profile);
+
+		auto& codecs = extendedRtpCapabilities["codecs"];
+
+		REQUIRE(codecs.size() == 2);
+		REQUIRE(codecs[0]["mimeType"] == "video/VP8");
+		REQUIRE(codecs[0]["localRtxPayloadType"] != nullptr);
+		REQUIRE(codecs[1]["mimeType"] == "audio/opus");
+		REQUIRE(!extendedRtpCapabilities["headerExtensions"].empty());
+	}
+
+	SECTION("keeps the allowed header extensions")
+	{
+		json profile = { { "headerExtensions", { "urn:ietf:params:rtp-hdrext:sdes:mid" } } };
+		auto numCodecs = extendedRtpCapabilities["codecs"].size();
+
+		ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, profile);
+
+		REQUIRE(extendedRtpCapabilities["codecs"].size() == numCodecs);
+
+		for (const auto& ext : extendedRtpCapabilities["headerExtensions"])
+		{
+			REQUIRE(ext["uri"] == "urn:ietf:params:rtp-hdrext:sdes:mid");
+		}
+	}
+
+	SECTION("keeps the allowed kinds")
+	{
+		json profile = { { "kinds", { "audio" } } };
+
+		ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, profile);
+
+		REQUIRE(!extendedRtpCapabilities["codecs"].empty());
+		REQUIRE(!ortc::canSend("video", extendedRtpCapabilities));
+
+		for (const auto& ext : extendedRtpCapabilities["headerExtensions"])
+		{
+			REQUIRE(ext["kind"] == "audio");
+		}
+	}
+
+	SECTION("throws if the profile is invalid")
+	{
+		REQUIRE_THROWS_AS(
+		  ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, { { "kinds", { "data" } } }),
+		  MediaSoupClientTypeError);
+		REQUIRE_THROWS_AS(
+		  ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, json::array()), MediaSoupClientTypeError);
+		REQUIRE_THROWS_AS(
+		  ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, { { "codecs", "audio/opus" } }),
+		  MediaSoupClientTypeError);
+		REQUIRE_THROWS_AS(
+		  ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, { { "headerExtensions", { 1 } } }),
+		  MediaSoupClientTypeError);
+	}
+}
+
+// Hidden benchmark, run it with: test_mediasoupclient "[benchmark]"
+TEST_CASE("applyRtpCapabilitiesProfile benchmark", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	static const size_t MediaSections{ 300u };
+
+	json remoteCaps = generateRouterRtpCapabilities();
+	json localCaps  = generateRouterRtpCapabilities();
+
+	auto transportRemoteParameters = generateTransportRemoteParameters();
+	auto extendedRtpCapabilities   = ortc::getExtendedRtpCapabilities(localCaps, remoteCaps);
+
+	// clang-format off
+	json profile =
+	{
+		{ "codecs",           { "audio/opus", "video/VP8" }                                       },
+		{ "headerExtensions", { "urn:ietf:params:rtp-hdrext:sdes:mid", "urn:3gpp:video-orientation" } }
+	};
+	// clang-format on
+
+	for (auto withProfile : { false, true })
+	{
+		if (withProfile)
+			ortc::applyRtpCapabilitiesProfile(extendedRtpCapabilities, profile);
+
+		auto rtpParameters = ortc::getSendingRemoteRtpParameters("video", extendedRtpCapabilities);
+
+		rtpParameters["encodings"] = { { { "ssrc", 1111 }, { "rtx", { { "ssrc", 2222 } } } } };
+		rtpParameters["rtcp"]      = { { "cname", "cname" } };
+
+		mediasoupclient::Sdp::RemoteSdp remoteSdp(
+		  transportRemoteParameters["iceParameters"],
+		  transportRemoteParameters["iceCandidates"],
+		  transportRemoteParameters["dtlsParameters"],
+		  nullptr);
+
+		for (size_t i{ 0u }; i < MediaSections; ++i)
+		{
+			remoteSdp.Receive(std::to_string(i), "video", rtpParameters, "stream-id", "track-id");
+		}
+
+		auto sdp   = remoteSdp.GetSdp();
+		auto start = Clock::now();
+
+		(void)sdptransform::parse(sdp);
+
+		std::chrono::duration<double, std::milli> parse = Clock::now() - start;
+
+		std::cout << MediaSections << " video m-sections, " << (withProfile ? "with" : "without")
+		          << " profile: " << sdp.size() << " bytes, sdptransform::parse() [ms]:" << parse.count()
+		          << std::endl;
+	}
+}
+
 TEST_CASE("getRecvRtpCapabilities", "[getRecvRtpCapabilities]")
 {
 	SECTION("succeeds if localCaps equals remoteCaps")